@@ -33,6 +33,12 @@
  */
 #define VIDEO_ENLARGEMENT_FACTOR  1.0666
 
+/**
+ * Bounding box of the target brackets drawn by frameOverlay.png, in points
+ * of the overlay image.  The customer holds the card inside this box.
+ */
+#define FRAME_OVERLAY_TARGET  CGRectMake(154, 30, 460, 195)
+
 
 @interface cameraView : UIView <AVCaptureVideoDataOutputSampleBufferDelegate> {
 	UIImageView *imageView;
@@ -53,7 +59,11 @@
 
 -(id)initWithFrame:(CGRect)aRect;
 - (void)initCapture;
+-(CGRect) cropRectForWidth: (size_t)width height: (size_t)height;
++(CGRect) targetRectInStrip: (CGRect)strip;
 -(CGImageRef) cropImage: (CGImageRef) img;
+-(CGImageRef) createImageFromBuffer: (CVImageBufferRef) imageBuffer 
+              crop: (CGRect) crop;
 -(UIImage*) addFrameOverlay: (UIImage*) baseImg;
 -(void) captureOutput:(AVCaptureOutput *)captureOutput 
 				didOutputSampleBuffer:(CMSampleBufferRef)sampleBuffer 
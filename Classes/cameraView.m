@@ -39,6 +39,8 @@
 #import "cameraView.h"
 #import "mainAppDelegate.h"
 #import "codeScanner.h"
+#import "scanMetrics.h"
+#import <mach/mach_time.h>
 
 @implementation cameraView
 
@@ -86,9 +88,11 @@
 - (void)initCapture {
   NSError *err;
 
-  /* Video capture format variables */  
+  /* Video capture format variables.  Bi-planar YUV is the camera's native
+  format, and its luma plane can be scanned by ZBar without conversion. */
   NSString* key = (NSString*)kCVPixelBufferPixelFormatTypeKey; 
-  NSNumber* value = [NSNumber numberWithUnsignedInt:kCVPixelFormatType_32BGRA]; 
+  NSNumber* value = [NSNumber numberWithUnsignedInt:
+      kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange]; 
   NSDictionary* videoSettings = [NSDictionary dictionaryWithObject: value forKey:key]; 
 
   /* Setup dispatch queue (for video frames waiting to be handled) */
@@ -116,7 +120,7 @@
   
   /* Output device settings.  Set delegate, frame format, framerate. */
   captureOutput.alwaysDiscardsLateVideoFrames = YES; 
-  captureOutput.minFrameDuration = CMTimeMake(1, 10); // caps framerate  
+  captureOutput.minFrameDuration = CMTimeMake(1, FRAME_RATE_ACTIVE_FPS); // caps framerate
   [captureOutput setSampleBufferDelegate:self queue:queue];
   [captureOutput setVideoSettings:videoSettings]; 
   
@@ -125,6 +129,13 @@
   [self.captureSession addInput:captureInput];
   [self.captureSession addOutput:captureOutput];
 
+  /* Slow the camera down while nobody is at the counter.  The scan worker
+  feeds the governor each frame's motion. */
+  mainAppDelegate *delegate = 
+      (mainAppDelegate*)[[UIApplication sharedApplication] delegate];
+  delegate.scanner.governor = [[[frameRateGovernor alloc] 
+    initWithOutput: captureOutput] autorelease];
+
   /* Start session (delegate will now be called with each frame) */
   [self.captureSession startRunning];
   
@@ -145,13 +156,138 @@
  * \return Cropped image
  */
 -(CGImageRef) cropImage: (CGImageRef) img {
-  CGRect screenSize = [[UIScreen mainScreen] bounds];
-  float width = screenSize.size.height / (4 * VIDEO_ENLARGEMENT_FACTOR);
-  float height = screenSize.size.width;
-  CGRect imgRect = CGRectMake(0,0, width, height);
+  CGRect imgRect = [self cropRectForWidth: CGImageGetWidth(img) 
+                         height: CGImageGetHeight(img)];
   return CGImageCreateWithImageInRect(img, imgRect);
 }
 
+/**
+ * \brief Region of a video frame that is displayed and scanned
+ *
+ * Same region that cropImage: cuts out, clipped to the frame so it can also
+ * be handed to the barcode scanner as a crop rectangle.
+ *
+ * \param width Width of the unrotated video frame
+ * \param height Height of the unrotated video frame
+ * \return Crop rectangle in pixels of the unrotated frame
+ */
+-(CGRect) cropRectForWidth: (size_t)width height: (size_t)height {
+  CGRect screenSize = [[UIScreen mainScreen] bounds];
+  float cropWidth = screenSize.size.height / (4 * VIDEO_ENLARGEMENT_FACTOR);
+  float cropHeight = screenSize.size.width;
+  CGRect imgRect = CGRectMake(0,0, cropWidth, cropHeight);
+  return CGRectIntegral(CGRectIntersection(imgRect, 
+                                           CGRectMake(0, 0, width, height)));
+}
+
+/**
+ * \brief Region of a video frame inside the overlay's target brackets
+ *
+ * The displayed strip is the cropped frame rotated a quarter turn clockwise
+ * and enlarged by VIDEO_ENLARGEMENT_FACTOR, so a point (x,y) on the overlay
+ * comes from pixel (y/k, height - x/k) of the strip.
+ *
+ * \param strip Crop rectangle of the displayed strip, in frame pixels
+ * \return Target rectangle in pixels of the unrotated frame
+ */
++(CGRect) targetRectInStrip: (CGRect)strip {
+  CGRect target = FRAME_OVERLAY_TARGET;
+  float k = VIDEO_ENLARGEMENT_FACTOR;
+  CGRect rect = CGRectMake(
+    strip.origin.x + CGRectGetMinY(target) / k,
+    strip.origin.y + strip.size.height - CGRectGetMaxX(target) / k,
+    target.size.height / k,
+    target.size.width / k);
+  return CGRectIntegral(CGRectIntersection(rect, strip));
+}
+
+/**
+ * \brief Convert a region of a bi-planar YUV frame to BGRA for display
+ *
+ * ITU-R BT.601 video range, in fixed point.  Each chroma sample covers a
+ * 2x2 block of luma.
+ *
+ * \param imageBuffer Locked bi-planar pixel buffer
+ * \param crop Region to convert, in pixels of the frame
+ * \param out BGRA output, crop width * 4 bytes per row
+ */
+static void convertYCbCrToBGRA(CVImageBufferRef imageBuffer, CGRect crop, 
+                               uint8_t *out) {
+  const uint8_t *luma = CVPixelBufferGetBaseAddressOfPlane(imageBuffer, 0);
+  const uint8_t *chroma = CVPixelBufferGetBaseAddressOfPlane(imageBuffer, 1);
+  size_t lumaStride = CVPixelBufferGetBytesPerRowOfPlane(imageBuffer, 0);
+  size_t chromaStride = CVPixelBufferGetBytesPerRowOfPlane(imageBuffer, 1);
+  int x0 = crop.origin.x, y0 = crop.origin.y;
+  int width = crop.size.width, height = crop.size.height;
+  
+  for (int y = 0; y < height; y++) {
+    const uint8_t *yRow = luma + (y0 + y) * lumaStride + x0;
+    const uint8_t *cRow = chroma + ((y0 + y) / 2) * chromaStride;
+    for (int x = 0; x < width; x++) {
+      const uint8_t *cbcr = cRow + ((x0 + x) & ~1);
+      int c = 298 * (yRow[x] - 16) + 128;
+      int d = cbcr[0] - 128, e = cbcr[1] - 128;
+      int r = (c + 409 * e) >> 8;
+      int g = (c - 100 * d - 208 * e) >> 8;
+      int b = (c + 516 * d) >> 8;
+      out[0] = b < 0 ? 0 : b > 255 ? 255 : b;
+      out[1] = g < 0 ? 0 : g > 255 ? 255 : g;
+      out[2] = r < 0 ? 0 : r > 255 ? 255 : r;
+      out[3] = 255;
+      out += 4;
+    }
+  }
+}
+
+/**
+ * \brief Create a displayable image of a region of a video frame
+ *
+ * Bi-planar YUV frames have only the region converted to colour, so the
+ * rest of the frame, which is never shown, costs nothing.  Packed BGRA
+ * frames are cropped as they are.  Base address of the buffer must be
+ * locked.  Only the scanner reads the luma plane directly.
+ *
+ * \param imageBuffer Locked pixel buffer from the video capture output
+ * \param crop Region to display, in pixels of the frame
+ * \return New image, which the caller must release
+ */
+-(CGImageRef) createImageFromBuffer: (CVImageBufferRef) imageBuffer 
+              crop: (CGRect) crop {
+  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB(); 
+  CGImageRef image = NULL;
+  
+  if (CVPixelBufferIsPlanar(imageBuffer)) {
+    // A new buffer each frame; the image may still be on screen when the
+    // next frame arrives
+    size_t bytesPerRow = (size_t)crop.size.width * 4;
+    NSMutableData *pixels = [NSMutableData dataWithLength: 
+      bytesPerRow * (size_t)crop.size.height];
+    convertYCbCrToBGRA(imageBuffer, crop, [pixels mutableBytes]);
+    CGDataProviderRef provider = 
+      CGDataProviderCreateWithCFData((CFDataRef)pixels);
+    image = CGImageCreate(crop.size.width, crop.size.height, 8, 32, 
+        bytesPerRow, colorSpace, 
+        kCGBitmapByteOrder32Little | kCGImageAlphaNoneSkipFirst, 
+        provider, NULL, NO, kCGRenderingIntentDefault);
+    CGDataProviderRelease(provider);
+  }
+  else {
+    CGContextRef context = CGBitmapContextCreate(
+        CVPixelBufferGetBaseAddress(imageBuffer), 
+        CVPixelBufferGetWidth(imageBuffer), 
+        CVPixelBufferGetHeight(imageBuffer), 8, 
+        CVPixelBufferGetBytesPerRow(imageBuffer), colorSpace, 
+        kCGBitmapByteOrder32Little | kCGImageAlphaPremultipliedFirst);
+    CGImageRef frame = CGBitmapContextCreateImage(context);
+    image = CGImageCreateWithImageInRect(frame, crop);
+    CGImageRelease(frame);
+    CGContextRelease(context);
+  }
+  
+  CGColorSpaceRelease(colorSpace);
+  return image;
+}
+
 /**
  * \brief Adds a 'target' overlay to image frame
  *
@@ -184,8 +320,8 @@
  *
  * Called whenever the camera has a new frame captured, this method crops,
  * overlays, rotates, and resizes the frame before displaying it.  It also
- * passes the frame to the global barcode scanner to check if any barcodes
- * are readable.
+ * queues the frame on the global barcode scanner's worker to check if any
+ * barcodes are readable.
  *
  * \param captureOutput Output device that generated the frame
  * \param sampleBuffer Raw data returned from the camera
@@ -196,30 +332,31 @@
         fromConnection:(AVCaptureConnection *)connection 
 { 
   NSAutoreleasePool * pool = [[NSAutoreleasePool alloc] init];
+  uint64_t captured = mach_absolute_time();
 
   /* Get image data from the raw sample buffer */
   CVImageBufferRef imageBuffer = CMSampleBufferGetImageBuffer(sampleBuffer); 
   CVPixelBufferLockBaseAddress(imageBuffer,0); 
-  uint8_t *baseAddress = (uint8_t *)CVPixelBufferGetBaseAddress(imageBuffer); 
-  size_t bytesPerRow = CVPixelBufferGetBytesPerRow(imageBuffer); 
   size_t width = CVPixelBufferGetWidth(imageBuffer); 
   size_t height = CVPixelBufferGetHeight(imageBuffer);  
-    
-  /* Create a core graphics image from data */
-  CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB(); 
-  CGContextRef newContext = CGBitmapContextCreate(baseAddress, width, height, 8, 
-      bytesPerRow, colorSpace, kCGBitmapByteOrder32Little | 
-      kCGImageAlphaPremultipliedFirst);
-  CGImageRef newImage = CGBitmapContextCreateImage(newContext); 
-    
-  /* Crop the image for our view */
-  CGImageRef croppedImg = [self cropImage: newImage];
+  CGRect cropRect = [self cropRectForWidth: width height: height];
   
-  /* Scan the cropped image for barcodes */
+  /* Hand the frame to the scan worker.  Scanning happens on its own queue,
+  so the preview keeps running at camera rate. */
   mainAppDelegate *delegate = 
       (mainAppDelegate*)[[UIApplication sharedApplication] delegate];
   codeScanner *scanner = delegate.scanner;
-  [scanner scanImage: croppedImg];
+  unsigned sequence = [scanner submitPixelBuffer: imageBuffer 
+                              crop: cropRect 
+                              target: [cameraView targetRectInStrip: cropRect]];
+  scanMetrics *metrics = [scanMetrics sharedMetrics];
+  [metrics frame: sequence reachedStage: SCAN_STAGE_CAPTURED atTime: captured];
+  [metrics frame: sequence reachedStage: SCAN_STAGE_SUBMITTED];
+  uint64_t previewStart = mach_absolute_time();
+    
+  /* Create a core graphics image of the region for our view */
+  CGImageRef croppedImg = [self createImageFromBuffer: imageBuffer 
+                                crop: cropRect];
 
   /* Convert to Cocoa image, enlarging to fit iPad screen (720px width -> 768px 
   width), and rotating to correct orientation. */
@@ -234,13 +371,11 @@
   thread since it's a GUI operation. */
   [self.imageView performSelectorOnMainThread: @selector(setImage:) 
                   withObject: image 
-                  waitUntilDone: YES];
+                  waitUntilDone: NO];
+  [metrics recordSince: previewStart inHistogram: SCAN_HISTOGRAM_PREVIEW];
   
   /* Clean up locks and allocated memory */
 	CVPixelBufferUnlockBaseAddress(imageBuffer, 0);
-  CGContextRelease(newContext); 
-  CGColorSpaceRelease(colorSpace);
-  CGImageRelease(newImage);
   CGImageRelease(croppedImg);
   
   [pool drain];
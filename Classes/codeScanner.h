@@ -22,21 +22,114 @@
 ///\file
 
 #import <Foundation/Foundation.h>
+#import <CoreVideo/CoreVideo.h>
 #import "ZBarSDK.h"
+#import "scanDensityController.h"
+#import "scanCoalescer.h"
+#import "scanGate.h"
+#import "scanPyramid.h"
+#import "scanResultRing.h"
+#import "scanlineDecoder.h"
+#import "scanScheduler.h"
+#import "frameRateGovernor.h"
+#import "scanFramePool.h"
+#import "frameRecorder.h"
+#import "memberCard.h"
+
+/// User default holding the name of the selected scan profile
+#define SCAN_PROFILE_DEFAULTS_KEY @"ASE_ScanProfile"
+/// Scan profile used when none has been selected
+#define SCAN_PROFILE_DEFAULT @"all"
+/// Every Nth frame is scanned across the whole strip, not just the target
+#define SCAN_FALLBACK_INTERVAL 5
+/// Frames that can be in flight between the camera and the scan worker
+#define SCAN_FRAME_POOL_SIZE 4
+/// Directory in Documents that scanned frames are recorded into, if present
+#define SCAN_RECORD_DIRECTORY @"scan_record"
+/// Most frames recorded per launch
+#define SCAN_RECORD_MAX_FRAMES 600
+/// ASE_BarcodeScanned userInfo key holding the scanned frame's sequence;
+/// the result itself is read from the scanner's results ring
+#define SCAN_SEQUENCE_KEY @"sequence"
+/// Posted in place of ASE_BarcodeScanned by a scanner made for a replay
+#define SCAN_REPLAY_SCANNED_NOTIFICATION @"ASE_ReplayBarcodeScanned"
+/// ASE_BarcodeCandidate userInfo key holding data decoded but not confirmed
+#define SCAN_CANDIDATE_KEY @"barcode"
+/// Posted in place of ASE_BarcodeCandidate by a scanner made for a replay
+#define SCAN_REPLAY_CANDIDATE_NOTIFICATION @"ASE_ReplayBarcodeCandidate"
 
 
 @interface codeScanner : NSObject {
 	ZBarImageScanner *scanner;
-  NSString *lastCode;
+  scanResultRing *results;
+  NSString *profileName;
+  scanCoalescer *coalescer;
+  BOOL replaying;
+  frameRateGovernor *governor;
+  
+  @private
+    ZBarImage *lumaImage;
+    NSMutableData *convertBuffer;
+    scanFramePool *framePool;
+    NSString *recordPath;
+    frameRecorder *recorder;
+    scanDensityController *densityController;
+    int appliedDensity;
+    scanGate *gate;
+    scanPyramid *pyramid;
+    scanlineDecoder *scanlines;
+    scanScheduler *scheduler;
+    NSString *lastCandidate;
+    uint64_t lastCandidateTime;
+    dispatch_queue_t scanQueue;
+    void * volatile mailbox;
+    volatile int32_t scanScheduled;
+    volatile int32_t lastSequence;
+    volatile int32_t framesSubmitted;
+    volatile int32_t framesDropped;
+    int32_t framesScanned;
+    double scanLatencyTotal;
+    uint64_t pixelsScanned;
+    uint64_t stripPixels;
 }
 
 /// ZBar barcode scanner instance
 @property (nonatomic, retain) ZBarImageScanner *scanner;
-/// String of the last barcode scan result.
-@property (nonatomic, retain) NSString *lastCode;
+/// Results published by the scanner, one per frame a barcode decoded in
+@property (nonatomic, readonly) scanResultRing *results;
+/// Name of the scan profile the scanner is configured with
+@property (nonatomic, readonly, retain) NSString *profileName;
+/// Collapses repeated decodes of a card into one scan event
+@property (nonatomic, readonly, retain) scanCoalescer *coalescer;
+/// Whether this scanner was made by initForReplay
+@property (nonatomic, readonly) BOOL replaying;
+/// Told the motion and decodes of every frame scanned, if set
+@property (retain) frameRateGovernor *governor;
 
 
+- (id) initForReplay;
 -(void) simulatorDebug;
+- (BOOL) selectProfile: (NSString*) name;
 - (BOOL) scanImage: (CGImageRef) img;
+- (unsigned) submitPixelBuffer: (CVImageBufferRef) buffer 
+              crop: (CGRect) crop 
+              target: (CGRect) target;
+- (void) waitUntilIdle;
+- (BOOL) scanPixelBuffer: (CVImageBufferRef) buffer crop: (CGRect) crop;
+- (BOOL) scanLumaPlane: (const uint8_t*) plane
+         width: (size_t) width
+         height: (size_t) height
+         bytesPerRow: (size_t) bytesPerRow
+         crop: (CGRect) crop;
+
++ (NSDictionary*) scanProfiles;
++ (ZBarImageScanner*) scannerWithProfile: (NSDictionary*) profile;
++ (void) applyProfile: (NSDictionary*) profile 
+         with: (void (^)(zbar_symbol_type_t, zbar_config_t, int)) setConfig;
+
+@end
 
+/// Access to the C scanner, for the calls ZBarImageScanner doesn't wrap
+@interface ZBarImageScanner (rawScanner)
+- (zbar_image_scanner_t*) zbarImageScanner;
 @end
@@ -27,48 +27,1000 @@
  * images from the cameraView and scans them for barcodes.  If a barcode is
  * detected, the decoded result is stored in an instance variable for decoding.
  *
+ * Video frames are scanned straight out of the capture buffer: the luma (Y)
+ * plane of a bi-planar YUV frame is already an 8-bit greyscale image, so it
+ * is handed to ZBar as Y800 data without any intermediate CGImage or format
+ * conversion.  The crop is applied by ZBar itself, so nothing is copied.
+ *
+ * Scanning runs on its own worker queue so a slow scan never holds up the
+ * camera preview.  The camera hands frames over through a single-slot
+ * mailbox: a newer frame replaces one that has not been scanned yet, so the
+ * worker always scans the most recent frame and stale ones are dropped.
+ * Frames come from a fixed scanFramePool, and each one owns the ZBar image
+ * it is scanned through, so the worker allocates nothing per frame.
+ *
+ * Which symbologies the scanner tries, and what data lengths it accepts,
+ * come from a scan profile in scanProfiles.plist.  A profile is a
+ * dictionary with these optional keys:
+ *   - symbologies -- Array of symbology names to enable (default: all)
+ *   - minLength   -- Minimum data length of a valid decode
+ *   - maxLength   -- Maximum data length of a valid decode
+ *   - addCheck    -- Whether to verify optional check digits
+ *   - enableCache -- Whether a symbol must be seen in several frames before
+ *                    it is reported (see ZBAR_CFG_UNCERTAINTY)
+ *   - config      -- Array of extra ZBar config strings, e.g. "x-density=2"
+ *
+ * Restricting a profile to the symbology our cards actually use saves
+ * ZBar from trying every other decoder on every scanline.
+ *
+ * Customers aim the card into the target brackets of the frame overlay, so
+ * most frames only scan that target window.  Every SCAN_FALLBACK_INTERVAL
+ * frames the whole displayed strip is scanned instead, to catch cards held
+ * outside the brackets.
+ *
+ * Scanline density is chosen per frame by a scanDensityController: sparse
+ * while nothing is happening, dense while a card appears to be arriving.
+ *
+ * Frames are first tried along a few columns with a scanlineDecoder, then
+ * scanned as images through a scanPyramid: at half size first, and at
+ * full size only around a symbol the half-size scan wasn't sure of, or
+ * periodically.
+ *
+ * Each frame's scan is kept inside SCAN_SCHEDULER_BUDGET_MS by a
+ * scanScheduler, which splits slow scans into bands spread over several
+ * frames rather than letting the camera back up behind one frame.
+ *
+ * The motion score of every frame is passed to the governor, if one is
+ * set, so the camera can slow down while the counter is empty.
+ *
+ * Before a target window scan, a scanGate checks the window's sharpness and
+ * motion, and frames ZBar could not decode are released without scanning.
+ *
+ * Only the best symbol decoded in a frame is reported, as an immutable
+ * scanResult published to the results ring from the scan worker, followed
+ * by ASE_BarcodeScanned.  Observers read the result from the ring with
+ * their own cursor.
+ *
+ * Data decoded but not yet trusted, from an uncertain symbol or a single
+ * scanline, is posted as ASE_BarcodeCandidate so the customer can be
+ * looked up while the scan is still being confirmed.
+ *
+ * Signed membership cards (see memberCard) are checked before they are
+ * published, and a card whose signature doesn't verify is dropped.
+ *
+ * A card held in view decodes on nearly every frame, but a result is only
+ * published once per presentation of a card; the scanCoalescer drops the
+ * repeats and counts them.
+ *
+ * If a scan_record directory exists in Documents, the displayed strip of
+ * each scanned frame is recorded there (see frameRecorder), up to
+ * SCAN_RECORD_MAX_FRAMES per launch, so a problem seen in the field can be
+ * replayed later with frameReplay.
+ *
  */
  
  
 #import "codeScanner.h"
+#import <libkern/OSAtomic.h>
+#import <mach/mach_time.h>
+#import "scanKernels.h"
+#import "scanMetrics.h"
+
+/// Number of scanned frames between worker statistics log lines
+#define SCAN_STATS_INTERVAL 300
+
+/**
+ * \brief Atomically replace the frame in a mailbox slot
+ * \param slot Mailbox slot
+ * \param frame New frame, or NULL to empty the slot
+ * \return Frame previously in the slot, or NULL if it was empty
+ */
+static scanFrame *exchangeFrame(void * volatile *slot, scanFrame *frame) {
+  void *old;
+  do {
+    old = *slot;
+  } while (!OSAtomicCompareAndSwapPtrBarrier(old, frame, slot));
+  return (scanFrame*)old;
+}
+
+/// Symbology names accepted in scan profiles
+static const struct {
+  NSString *name;
+  zbar_symbol_type_t type;
+} symbologyNames[] = {
+  { @"ean8", ZBAR_EAN8 },
+  { @"upce", ZBAR_UPCE },
+  { @"isbn10", ZBAR_ISBN10 },
+  { @"upca", ZBAR_UPCA },
+  { @"ean13", ZBAR_EAN13 },
+  { @"isbn13", ZBAR_ISBN13 },
+  { @"i25", ZBAR_I25 },
+  { @"databar", ZBAR_DATABAR },
+  { @"databar-exp", ZBAR_DATABAR_EXP },
+  { @"code39", ZBAR_CODE39 },
+  { @"pdf417", ZBAR_PDF417 },
+  { @"qrcode", ZBAR_QRCODE },
+  { @"code93", ZBAR_CODE93 },
+  { @"code128", ZBAR_CODE128 },
+};
+
+/**
+ * \brief Look up a symbology by its scan profile name
+ * \param name Symbology name, as used in ZBar config strings
+ * \return Symbology type, or ZBAR_NONE if the name is unknown
+ */
+static zbar_symbol_type_t symbologyNamed(NSString *name) {
+  int count = sizeof(symbologyNames) / sizeof(symbologyNames[0]);
+  for (int i = 0; i < count; i++) {
+    if ([name caseInsensitiveCompare: symbologyNames[i].name] == NSOrderedSame)
+      return symbologyNames[i].type;
+  }
+  return ZBAR_NONE;
+}
+
+@implementation ZBarImageScanner (rawScanner)
+- (zbar_image_scanner_t*) zbarImageScanner {
+  return scanner;
+}
+@end
+
+/// Time ZBarImage spent converting a CGImage to Y800
+@interface ZBarImage (convertTime)
+- (double) convertTime;
+@end
+
+@implementation ZBarImage (convertTime)
+- (double) convertTime {
+  return t_convert;
+}
+@end
+
+@interface codeScanner (PrivateMethods)
+- (BOOL) handleSymbols: (ZBarSymbolSet*) symbols;
+- (BOOL) publishResult: (scanResult*) result;
+- (void) drainMailbox;
+- (void) defaultsChanged: (NSNotification*) notification;
+- (BOOL) attachFrame: (scanFrame*) frame region: (CGRect) region;
+- (BOOL) scanFrame: (scanFrame*) frame;
+- (void) finishFrame: (scanFrame*) frame;
+- (void) recordFrame: (scanFrame*) frame;
+- (void) applyDensity;
+- (BOOL) sawUncertainSymbol;
+- (void) postCandidate;
+@end
+
+@interface codeScanner ()
+/// Reusable ZBar image that wraps the plane given to scanLumaPlane:
+@property (nonatomic, retain) ZBarImage *lumaImage;
+/// Chooses scanline density for each frame
+@property (nonatomic, retain) scanDensityController *densityController;
+@property (nonatomic, readwrite, retain) NSString *profileName;
+@property (nonatomic, readwrite, retain) scanCoalescer *coalescer;
+@end
+
+/**
+ * \brief Scan worker entry point
+ *
+ * Plain function rather than a block, so waking the worker doesn't copy a
+ * block for every frame.
+ *
+ * \param context The codeScanner
+ */
+static void drainScanQueue(void *context) {
+  [(codeScanner*)context drainMailbox];
+}
 
 @implementation codeScanner
 
 @synthesize scanner;
-@synthesize lastCode;
+@synthesize results;
+@synthesize lumaImage;
+@synthesize profileName;
+@synthesize densityController;
+@synthesize coalescer;
+@synthesize replaying;
+@synthesize governor;
 
 - (id) init {
 	if (self = [super init]) {
-  	self.scanner = [[ZBarImageScanner alloc] init];
+    NSString *name = [[NSUserDefaults standardUserDefaults] 
+      stringForKey: SCAN_PROFILE_DEFAULTS_KEY];
+    NSDictionary *profile = [[codeScanner scanProfiles] objectForKey: name];
+    if (!profile) {
+      name = SCAN_PROFILE_DEFAULT;
+      profile = [[codeScanner scanProfiles] objectForKey: name];
+    }
+  	self.scanner = [codeScanner scannerWithProfile: profile];
+    scanlines = [[scanlineDecoder alloc] initWithProfile: profile];
+    self.profileName = name;
+    
+    zbar_image_t *zimg = zbar_image_create();
+    zbar_image_set_format(zimg, zbar_fourcc('Y','8','0','0'));
+    self.lumaImage = [[[ZBarImage alloc] initWithImage: zimg] autorelease];
+    zbar_image_destroy(zimg); // ZBarImage holds its own reference
+    
+    self.densityController = [[[scanDensityController alloc] init] 
+      autorelease];
+    self.coalescer = [[[scanCoalescer alloc] init] autorelease];
+    convertBuffer = [[NSMutableData alloc] init];
+    framePool = [[scanFramePool alloc] initWithCapacity: SCAN_FRAME_POOL_SIZE];
+    results = [[scanResultRing alloc] init];
+    gate = [[scanGate alloc] init];
+    pyramid = [[scanPyramid alloc] init];
+    scheduler = [[scanScheduler alloc] init];
+    
+    NSArray *docPaths = NSSearchPathForDirectoriesInDomains(
+      NSDocumentDirectory, NSUserDomainMask, YES);
+    NSString *recordDir = [[docPaths objectAtIndex: 0] 
+      stringByAppendingPathComponent: SCAN_RECORD_DIRECTORY];
+    BOOL isDir = NO;
+    if ([[NSFileManager defaultManager] fileExistsAtPath: recordDir 
+                                        isDirectory: &isDir] && isDir) {
+      NSDateFormatter *format = [[[NSDateFormatter alloc] init] autorelease];
+      [format setDateFormat: @"yyyyMMdd-HHmmss"];
+      recordPath = [[[recordDir stringByAppendingPathComponent: 
+          [format stringFromDate: [NSDate date]]] 
+        stringByAppendingPathExtension: FRAME_RECORDING_EXTENSION] retain];
+    }
+    scanQueue = dispatch_queue_create("scanQueue", NULL);
+    
+    // Follow the profile picked in the Settings app
+    [[NSNotificationCenter defaultCenter] 
+      addObserver: self
+      selector: @selector(defaultsChanged:)
+      name: NSUserDefaultsDidChangeNotification
+      object: nil];
   }
   return self;
 }
 
+/**
+ * \brief Create a scanner that frameReplay feeds recorded frames to
+ *
+ * A replay scanner never records frames, and posts its decodes as
+ * ASE_ReplayBarcodeScanned, so nothing listening to the camera's scanner,
+ * like the customer screen, reacts to a replay.
+ *
+ * \return Initialized instance
+ */
+- (id) initForReplay {
+  if (self = [self init]) {
+    replaying = YES;
+    [recordPath release];
+    recordPath = nil;
+  }
+  return self;
+}
+
+- (void) dealloc {
+  [[NSNotificationCenter defaultCenter] removeObserver: self];
+  dispatch_sync(scanQueue, ^{});
+  [framePool releaseFrame: exchangeFrame(&mailbox, NULL)];
+  dispatch_release(scanQueue);
+  [scanner release];
+  [results release];
+  [profileName release];
+  [lumaImage release];
+  [densityController release];
+  [coalescer release];
+  [convertBuffer release];
+  [framePool release];
+  [gate release];
+  [pyramid release];
+  [scheduler release];
+  [governor release];
+  [scanlines release];
+  [lastCandidate release];
+  [recordPath release];
+  [recorder release];
+  [super dealloc];
+}
+
 -(void) simulatorDebug {
-    self.lastCode = [NSString stringWithString: @"1020304"];
-    NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
-    [center postNotificationName: @"ASE_BarcodeScanned"
-            object: self
-            userInfo: nil];
+    scanResult *result = [[[scanResult alloc] initWithData: @"1020304" 
+                                              symbology: ZBAR_CODE128 
+                                              quality: 1 
+                                              location: CGRectZero 
+                                              sequence: 0] autorelease];
+    dispatch_async(scanQueue, ^{ [self publishResult: result]; });
+}
+
+/**
+ * \brief Switch the scanner to a different scan profile
+ *
+ * A new scanner is built for the profile and swapped in on the scan worker
+ * between frames.  The choice is saved, and used again on next launch.
+ * Profiles are normally picked from the Settings app, which lands here
+ * through defaultsChanged:.
+ *
+ * \param name Name of a profile in scanProfiles.plist
+ * \return NO if there is no profile with that name
+ */
+- (BOOL) selectProfile: (NSString*) name {
+  NSDictionary *profile = [[codeScanner scanProfiles] objectForKey: name];
+  if (!profile) return NO;
+  
+  ZBarImageScanner *newScanner = [codeScanner scannerWithProfile: profile];
+  scanlineDecoder *newScanlines = [[scanlineDecoder alloc] 
+    initWithProfile: profile];
+  dispatch_async(scanQueue, ^{
+    self.scanner = newScanner;
+    self.profileName = name;
+    [scanlines release];
+    scanlines = newScanlines;
+    appliedDensity = 0;
+  });
+  
+  // Only write a change, so the defaults notification doesn't loop back here
+  NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+  if (![name isEqualToString: [defaults stringForKey: 
+                                          SCAN_PROFILE_DEFAULTS_KEY]])
+    [defaults setObject: name forKey: SCAN_PROFILE_DEFAULTS_KEY];
+  NSLog(@"Scan profile: %@", name);
+  return YES;
+}
+
+/**
+ * \brief All scan profiles from scanProfiles.plist
+ *
+ * Always contains the default profile, even if the file is missing.
+ *
+ * \return Dictionary of profile name to profile dictionary
+ */
++ (NSDictionary*) scanProfiles {
+  static NSDictionary *profiles = nil;
+  
+  @synchronized(self) {
+    if (!profiles) {
+      NSString *file = [[NSBundle mainBundle] pathForResource: @"scanProfiles" 
+                                              ofType: @"plist"];
+      NSMutableDictionary *loaded = [NSMutableDictionary 
+        dictionaryWithContentsOfFile: file];
+      if (!loaded) loaded = [NSMutableDictionary dictionary];
+      if (![loaded objectForKey: SCAN_PROFILE_DEFAULT])
+        [loaded setObject: [NSDictionary dictionary] 
+                forKey: SCAN_PROFILE_DEFAULT];
+      profiles = [loaded copy];
+    }
+  }
+  return profiles;
 }
 
+/**
+ * \brief Create a ZBar scanner configured with a scan profile
+ *
+ * \param profile Profile dictionary from scanProfiles
+ * \return New autoreleased scanner
+ */
++ (ZBarImageScanner*) scannerWithProfile: (NSDictionary*) profile {
+  ZBarImageScanner *newScanner = [[[ZBarImageScanner alloc] init] autorelease];
+  newScanner.enableCache = [[profile objectForKey: @"enableCache"] boolValue];
+  [codeScanner applyProfile: profile 
+               with: ^(zbar_symbol_type_t type, zbar_config_t config, int value) {
+    [newScanner setSymbology: type config: config to: value];
+  }];
+  return newScanner;
+}
+
+/**
+ * \brief Apply a scan profile's symbology settings through a setter
+ *
+ * If the profile lists symbologies, every symbology is disabled first and
+ * only the listed ones are turned back on.  Length limits and check digit
+ * settings are applied to each listed symbology, then any extra config
+ * strings.  Taking a setter lets the same profile configure an image
+ * scanner or a bare decoder.
+ *
+ * \param profile Profile dictionary from scanProfiles
+ * \param setConfig Called once per setting, like zbar_decoder_set_config
+ */
++ (void) applyProfile: (NSDictionary*) profile 
+         with: (void (^)(zbar_symbol_type_t, zbar_config_t, int)) setConfig {
+  NSArray *symbologies = [profile objectForKey: @"symbologies"];
+  NSNumber *minLength = [profile objectForKey: @"minLength"];
+  NSNumber *maxLength = [profile objectForKey: @"maxLength"];
+  NSNumber *addCheck = [profile objectForKey: @"addCheck"];
+  
+  if ([symbologies count]) {
+    setConfig(ZBAR_NONE, ZBAR_CFG_ENABLE, 0);
+  }
+  for (NSString *name in symbologies) {
+    zbar_symbol_type_t type = symbologyNamed(name);
+    if (type == ZBAR_NONE) {
+      NSLog(@"Scan profile: unknown symbology %@", name);
+      continue;
+    }
+    setConfig(type, ZBAR_CFG_ENABLE, 1);
+    if (minLength)
+      setConfig(type, ZBAR_CFG_MIN_LEN, [minLength intValue]);
+    if (maxLength)
+      setConfig(type, ZBAR_CFG_MAX_LEN, [maxLength intValue]);
+    if (addCheck)
+      setConfig(type, ZBAR_CFG_ADD_CHECK, [addCheck boolValue]);
+  }
+  
+  for (NSString *setting in [profile objectForKey: @"config"]) {
+    zbar_symbol_type_t type;
+    zbar_config_t config;
+    int value;
+    if (zbar_parse_config([setting UTF8String], &type, &config, &value))
+      NSLog(@"Scan profile: bad config %@", setting);
+    else
+      setConfig(type, config, value);
+  }
+}
+
+/**
+ * \brief Scan a CGImage for barcodes
+ *
+ * ZBar re-renders the image to Y800 internally, so this is the slow path.
+ * Video frames should go through scanPixelBuffer:crop: instead.
+ *
+ * \param img Image to scan
+ * \return Whether a barcode was found
+ */
 - (BOOL) scanImage: (CGImageRef) img {
 	ZBarImage *zimg = [[[ZBarImage  alloc] initWithCGImage: img] autorelease];
+  [[scanMetrics sharedMetrics] record: [zimg convertTime] * 1000.0 
+                               inHistogram: SCAN_HISTOGRAM_CONVERT];
   NSInteger result = [self.scanner scanImage: zimg];    
   if (!result) return FALSE;
   
-  ZBarSymbolSet *symbols = zimg.symbols;
-  for(ZBarSymbol *symbol in symbols) {
-  	NSLog(@"Symbol type: %@", symbol.typeName);
-    NSLog(@"Symbol data: %@", symbol.data);
-    self.lastCode = [NSString stringWithString: symbol.data];
-    NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
-    [center postNotificationName: @"ASE_BarcodeScanned"
-            object: self
-            userInfo: nil];
-	}
+  return [self handleSymbols: zimg.symbols];
+}
+
+/**
+ * \brief Queue a video frame to be scanned on the scan worker
+ *
+ * Returns immediately.  The buffer is retained until it has been scanned,
+ * or until a newer frame replaces it in the mailbox, in which case it is
+ * dropped without being scanned.  If every pooled frame is still in use the
+ * video frame is dropped straight away.
+ *
+ * \param buffer Pixel buffer from the video capture output
+ * \param crop Displayed region of the frame, in pixels of the unrotated frame
+ * \param target Target window inside crop, in pixels of the unrotated frame
+ * \return Sequence number the frame is scanned under, for scanMetrics, or 0
+ *         if it was dropped straight away
+ */
+- (unsigned) submitPixelBuffer: (CVImageBufferRef) buffer 
+              crop: (CGRect) crop 
+              target: (CGRect) target {
+  OSAtomicIncrement32(&framesSubmitted);
+  scanFrame *frame = [framePool acquireFrameForBuffer: buffer];
+  if (!frame) {
+    OSAtomicIncrement32(&framesDropped);
+    [[scanMetrics sharedMetrics] frameDropped];
+    return 0;
+  }
+  
+  unsigned sequence = (unsigned)OSAtomicIncrement32(&lastSequence);
+  if (!sequence) sequence = (unsigned)OSAtomicIncrement32(&lastSequence);
+  zbar_image_set_sequence(frame->image, sequence);
+  frame->crop = crop;
+  frame->target = target;
+  frame->submitTime = mach_absolute_time();
+  
+  scanFrame *stale = exchangeFrame(&mailbox, frame);
+  if (stale) {
+    OSAtomicIncrement32(&framesDropped);
+    [[scanMetrics sharedMetrics] frameDropped];
+    [framePool releaseFrame: stale];
+  }
+  
+  // Wake the worker unless it is already scheduled to empty the mailbox
+  if (OSAtomicCompareAndSwap32Barrier(0, 1, &scanScheduled))
+    dispatch_async_f(scanQueue, self, drainScanQueue);
+  return sequence;
+}
+
+/**
+ * \brief Block until every submitted frame has been scanned
+ */
+- (void) waitUntilIdle {
+  dispatch_sync(scanQueue, ^{});
+}
+
+/**
+ * \brief Scan a video frame for barcodes without copying it
+ *
+ * Bi-planar YUV frames are scanned in place from their luma plane.  Packed
+ * BGRA frames have no luma plane, so the crop is converted to luma with
+ * scanBgraToY8 first; that is one pass over the cropped pixels, instead of
+ * the copies a CGImage round trip makes.
+ *
+ * \param buffer Pixel buffer from the video capture output
+ * \param crop Region of the frame to scan, in pixels of the unrotated frame
+ * \return Whether a barcode was found
+ */
+- (BOOL) scanPixelBuffer: (CVImageBufferRef) buffer crop: (CGRect) crop {
+  BOOL result = NO;
+  
+  CVPixelBufferLockBaseAddress(buffer, 0);
+  if (CVPixelBufferIsPlanar(buffer)) {
+    result = [self scanLumaPlane: 
+                (const uint8_t*)CVPixelBufferGetBaseAddressOfPlane(buffer, 0)
+              width: CVPixelBufferGetWidthOfPlane(buffer, 0)
+              height: CVPixelBufferGetHeightOfPlane(buffer, 0)
+              bytesPerRow: CVPixelBufferGetBytesPerRowOfPlane(buffer, 0)
+              crop: crop];
+  }
+  else {
+    // Convert just the crop to luma, into a buffer reused across frames
+    crop = CGRectIntersection(CGRectIntegral(crop), 
+      CGRectMake(0, 0, CVPixelBufferGetWidth(buffer), 
+                 CVPixelBufferGetHeight(buffer)));
+    const uint8_t *bgra = CVPixelBufferGetBaseAddress(buffer);
+    if (bgra && !CGRectIsEmpty(crop)) {
+      int width = crop.size.width, height = crop.size.height;
+      if ([convertBuffer length] < (NSUInteger)(width * height))
+        [convertBuffer setLength: width * height];
+      size_t bytesPerRow = CVPixelBufferGetBytesPerRow(buffer);
+      scanBgraToY8(bgra + (size_t)crop.origin.y * bytesPerRow + 
+                     (size_t)crop.origin.x * 4, 
+                   bytesPerRow, [convertBuffer mutableBytes], width, 
+                   width, height);
+      result = [self scanLumaPlane: [convertBuffer bytes] 
+                     width: width height: height bytesPerRow: width 
+                     crop: CGRectMake(0, 0, width, height)];
+    }
+  }
+  CVPixelBufferUnlockBaseAddress(buffer, 0);
+  
+  return result;
+}
+
+/**
+ * \brief Scan an 8-bit greyscale plane for barcodes in place
+ *
+ * The plane is given to ZBar as Y800 data with no cleanup handler, so ZBar
+ * never copies or frees it.  ZBar assumes rows are packed, so the image is
+ * declared as bytesPerRow wide and the padding is excluded by the crop.
+ *
+ * The plane must stay valid until this method returns.
+ *
+ * \param plane First byte of the greyscale plane
+ * \param width Width of the plane in pixels
+ * \param height Height of the plane in pixels
+ * \param bytesPerRow Row stride of the plane in bytes
+ * \param crop Region of the plane to scan
+ * \return Whether a barcode was found
+ */
+- (BOOL) scanLumaPlane: (const uint8_t*) plane
+         width: (size_t) width
+         height: (size_t) height
+         bytesPerRow: (size_t) bytesPerRow
+         crop: (CGRect) crop {
+  crop = CGRectIntersection(CGRectIntegral(crop), 
+                            CGRectMake(0, 0, width, height));
+  if (!plane || CGRectIsEmpty(crop)) return FALSE;
+  
+  zbar_image_t *zimg = self.lumaImage.zbarImage;
+  zbar_image_set_size(zimg, bytesPerRow, height);
+  zbar_image_set_crop(zimg, crop.origin.x, crop.origin.y, 
+                      crop.size.width, crop.size.height);
+  zbar_image_set_data(zimg, plane, bytesPerRow * height, NULL);
+  
+  NSInteger result = [self.scanner scanImage: self.lumaImage];
+  BOOL found = NO;
+  if (result > 0)
+    found = [self handleSymbols: self.lumaImage.symbols];
+  
+  // Don't leave a pointer into a buffer the camera is about to reuse
+  zbar_image_set_data(zimg, NULL, 0, NULL);
+  return found;
+}
+
+@end
+
+@implementation codeScanner (PrivateMethods)
+
+/**
+ * \brief Switch profiles when a different one is picked in Settings
+ *
+ * Defaults can change on any thread, so the current profile is compared
+ * on the scan worker, which is the only thread that sets it.
+ */
+- (void) defaultsChanged: (NSNotification*) notification {
+  NSString *name = [[NSUserDefaults standardUserDefaults] 
+    stringForKey: SCAN_PROFILE_DEFAULTS_KEY];
+  if (!name) return;
+  dispatch_async(scanQueue, ^{
+    if (![name isEqualToString: self.profileName])
+      [self selectProfile: name];
+  });
+}
+
+/**
+ * \brief Scan frames from the mailbox until it is empty
+ *
+ * Runs on the scan worker queue.  The scheduled flag is cleared before the
+ * mailbox is checked, so a frame submitted during a scan either gets picked
+ * up by this loop or schedules a new drain.
+ */
+- (void) drainMailbox {
+  NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+  
+  for (;;) {
+    OSAtomicCompareAndSwap32Barrier(1, 0, &scanScheduled);
+    scanFrame *frame = exchangeFrame(&mailbox, NULL);
+    if (!frame) break;
+    unsigned sequence = zbar_image_get_sequence(frame->image);
+    [[scanMetrics sharedMetrics] frame: sequence 
+                                 reachedStage: SCAN_STAGE_DEQUEUED];
+    
+    // Scan the target window, with a periodic scan of the whole strip
+    CGRect region = frame->target;
+    if (CGRectIsEmpty(region) || framesScanned % SCAN_FALLBACK_INTERVAL == 0)
+      region = frame->crop;
+    stripPixels += frame->crop.size.width * frame->crop.size.height;
+    
+    if (![self attachFrame: frame region: region]) {
+      [framePool releaseFrame: frame];
+      continue;
+    }
+    if (recordPath) [self recordFrame: frame];
+    
+    // Pick scanline density from motion in the target window
+    const uint8_t *luma = NULL;
+    size_t lumaBytesPerRow = 0;
+    if (CVPixelBufferIsPlanar(frame->buffer)) {
+      luma = CVPixelBufferGetBaseAddressOfPlane(frame->buffer, 0);
+      lumaBytesPerRow = CVPixelBufferGetBytesPerRowOfPlane(frame->buffer, 0);
+    }
+    double motion = [self.densityController observeLumaPlane: luma 
+                                            bytesPerRow: lumaBytesPerRow 
+                                            region: frame->target];
+    [self applyDensity];
+    frameRateGovernor *frameRate = self.governor;
+    [frameRate frameWithMotion: motion time: frame->submitTime];
+    
+    // Skip blurred, moving and unchanged frames, but never the periodic
+    // full-strip scans.  A skipped frame still counts toward the stats, and
+    // toward density as a frame that decoded nothing new.
+    BOOL gated = !CGRectEqualToRect(region, frame->crop);
+    scanGateDecision decision = gated ? 
+      [gate evaluateLumaPlane: luma 
+            bytesPerRow: lumaBytesPerRow 
+            region: region 
+            motion: motion 
+            time: frame->submitTime] : 
+      SCAN_GATE_SCAN;
+    if (decision != SCAN_GATE_SCAN) {
+      [self.densityController 
+        scanFinished: 0.0 
+        found: decision == SCAN_GATE_SKIP_UNCHANGED 
+        partial: NO];
+      [self finishFrame: frame];
+      continue;
+    }
+    pixelsScanned += region.size.width * region.size.height;
+    
+    uint64_t start = mach_absolute_time();
+    BOOL found = [self scanFrame: frame];
+    [[scanMetrics sharedMetrics] recordSince: start 
+                                 inHistogram: SCAN_HISTOGRAM_SCAN];
+    [[scanMetrics sharedMetrics] frame: sequence 
+                                 reachedStage: SCAN_STAGE_DECODED];
+    [self.densityController 
+      scanFinished: machTimeToMs(mach_absolute_time() - start) 
+      found: found 
+      partial: [self sawUncertainSymbol]];
+    if (found) [frameRate decodedAtTime: frame->submitTime];
+    else [self postCandidate];
+    double firstDecode = gated ? 
+      [gate scanFinished: found time: frame->submitTime] : 0.0;
+    if (firstDecode > 0.0)
+      [[scanMetrics sharedMetrics] record: firstDecode 
+                                   inHistogram: SCAN_HISTOGRAM_FIRST_DECODE];
+    
+    // Hand the symbols back to the scanner for reuse, then detach the data;
+    // the frame's cleanup handler releases the buffer and pools the frame
+    zbar_image_scanner_recycle_image([self.scanner zbarImageScanner], 
+                                     frame->image);
+    [self finishFrame: frame];
+  }
+  
+  [pool drain];
+}
+
+/**
+ * \brief Account for a frame the scan worker is done with, and release it
+ *
+ * Called for frames the gate skipped as well as those scanned, so latency
+ * and the periodic full-strip scans count every frame.
+ *
+ * \param frame Frame taken from the mailbox
+ */
+- (void) finishFrame: (scanFrame*) frame {
+  scanLatencyTotal += machTimeToMs(mach_absolute_time() - frame->submitTime);
+  [framePool releaseFrame: frame];
+  
+  if (++framesScanned % SCAN_STATS_INTERVAL == 0) {
+    NSLog(@"Scan worker: %d submitted, %d scanned or skipped, %d dropped, "
+           "%.1f ms average latency, %.0f%% of strip pixels scanned, "
+           "%d presentations, %d duplicate decodes suppressed, "
+           "frame pool exhausted %d times, %@, %@, %@, %@, %@, %@",
+           framesSubmitted, framesScanned, framesDropped,
+           scanLatencyTotal / framesScanned,
+           100.0 * pixelsScanned / stripPixels,
+           self.coalescer.presentations, self.coalescer.suppressed,
+           framePool.exhausted, [self.densityController summary],
+           [gate summary], [scanlines summary], [pyramid summary],
+           [scheduler summary], [self.governor summary]);
+  }
+}
+
+/**
+ * \brief Point a pooled frame's image at the region to scan
+ *
+ * Locks the frame's pixel buffer; it is unlocked when the frame is
+ * released.  The luma plane of a bi-planar frame is attached in place.  A
+ * BGRA frame has its region converted into the frame's own luma buffer,
+ * which is only allocated the first time.
+ *
+ * \param frame Frame taken from the mailbox
+ * \param region Region to scan, in pixels of the unrotated frame
+ * \return NO if there is nothing to scan
+ */
+- (BOOL) attachFrame: (scanFrame*) frame region: (CGRect) region {
+  CVPixelBufferLockBaseAddress(frame->buffer, 0);
+  frame->locked = YES;
+  zbar_image_t *zimg = frame->image;
+  
+  if (CVPixelBufferIsPlanar(frame->buffer)) {
+    const uint8_t *plane = CVPixelBufferGetBaseAddressOfPlane(frame->buffer, 0);
+    size_t height = CVPixelBufferGetHeightOfPlane(frame->buffer, 0);
+    size_t bytesPerRow = CVPixelBufferGetBytesPerRowOfPlane(frame->buffer, 0);
+    region = CGRectIntersection(CGRectIntegral(region), CGRectMake(0, 0, 
+      CVPixelBufferGetWidthOfPlane(frame->buffer, 0), height));
+    if (!plane || CGRectIsEmpty(region)) return NO;
+    
+    // Rows are declared bytesPerRow wide; the crop excludes the padding
+    zbar_image_set_size(zimg, bytesPerRow, height);
+    zbar_image_set_crop(zimg, region.origin.x, region.origin.y, 
+                        region.size.width, region.size.height);
+    frame->offset = CGPointZero;
+    [framePool attachData: plane length: bytesPerRow * height toFrame: frame];
+    return YES;
+  }
+  
+  const uint8_t *bgra = CVPixelBufferGetBaseAddress(frame->buffer);
+  size_t bytesPerRow = CVPixelBufferGetBytesPerRow(frame->buffer);
+  region = CGRectIntersection(CGRectIntegral(region), CGRectMake(0, 0, 
+    CVPixelBufferGetWidth(frame->buffer), 
+    CVPixelBufferGetHeight(frame->buffer)));
+  if (!bgra || CGRectIsEmpty(region)) return NO;
+  
+  int width = region.size.width, height = region.size.height;
+  uint8_t *luma = [framePool lumaBufferForFrame: frame 
+                             length: width * height];
+  if (!luma) return NO;
+  uint64_t start = mach_absolute_time();
+  scanBgraToY8(bgra + (size_t)region.origin.y * bytesPerRow + 
+                 (size_t)region.origin.x * 4, 
+               bytesPerRow, luma, width, width, height);
+  [[scanMetrics sharedMetrics] recordSince: start 
+                               inHistogram: SCAN_HISTOGRAM_CONVERT];
+  zbar_image_set_size(zimg, width, height);
+  zbar_image_set_crop(zimg, 0, 0, width, height);
+  frame->offset = region.origin;
+  [framePool attachData: luma length: width * height toFrame: frame];
+  return YES;
+}
+
+/**
+ * \brief Scan a pooled frame's image
+ *
+ * A few columns are tried through the scanlineDecoder first; only if they
+ * don't agree on a decode is the frame scanned as an image.
+ *
+ * The image scan calls ZBar directly so a frame with no barcode in it
+ * doesn't create any Objective-C objects; symbols are only wrapped when
+ * something decodes.  The scanScheduler keeps the scan inside the frame's
+ * time budget, scanning bands of the frame through the scanPyramid, so the
+ * symbols may come from a half-size copy of part of the frame.
+ *
+ * \param frame Frame with data attached
+ * \return Whether a barcode was found
+ */
+- (BOOL) scanFrame: (scanFrame*) frame {
+  uint64_t start = mach_absolute_time();
+  scanResult *fast = [scanlines scanImage: frame->image offset: frame->offset];
+  if (fast) {
+    [self publishResult: fast];
+    return YES;
+  }
+  
+  CGPoint origin = CGPointZero;
+  zbar_image_t *decoded = [scheduler scanImage: frame->image 
+                                     withPyramid: pyramid 
+                                     scanner: [self.scanner zbarImageScanner] 
+                                     started: start 
+                                     origin: &origin];
+  if (!decoded) return NO;
+  
+  // Map symbol locations from the image scanned back to the frame
+  CGFloat scale = 1.0;
+  CGPoint offset = frame->offset;
+  if (decoded != frame->image) {
+    scale = 2.0;
+    offset.x += origin.x;
+    offset.y += origin.y;
+  }
+  
+  ZBarSymbolSet *symbols = [[ZBarSymbolSet alloc] 
+    initWithSymbolSet: zbar_image_get_symbols(decoded)];
+  scanResult *result = [scanResult bestOfSymbols: symbols 
+    scale: scale 
+    offset: offset 
+    sequence: zbar_image_get_sequence(frame->image)];
+  [symbols release];
+  if (!result) return NO;
+  
+  [self publishResult: result];
+  return YES;
+}
+
+/**
+ * \brief Append the displayed strip of a frame to the recording
+ *
+ * The recording is opened on the first frame, sized to its strip, and
+ * closed after SCAN_RECORD_MAX_FRAMES.  Only bi-planar frames have a luma
+ * plane to record.
+ *
+ * \param frame Frame with its buffer locked
+ */
+- (void) recordFrame: (scanFrame*) frame {
+  if (!CVPixelBufferIsPlanar(frame->buffer)) return;
+  CGRect strip = CGRectIntegral(frame->crop);
+  
+  if (!recorder) {
+    recorder = [[frameRecorder alloc] initWithPath: recordPath 
+                                      width: strip.size.width 
+                                      height: strip.size.height];
+    if (!recorder) {
+      [recordPath release];
+      recordPath = nil;
+      return;
+    }
+    NSLog(@"Recording scanned frames to %@", recordPath);
+  }
+  
+  [recorder appendPlane: CVPixelBufferGetBaseAddressOfPlane(frame->buffer, 0) 
+            bytesPerRow: CVPixelBufferGetBytesPerRowOfPlane(frame->buffer, 0) 
+            region: strip 
+            time: frame->submitTime];
+  if (recorder.framesWritten >= SCAN_RECORD_MAX_FRAMES) {
+    NSLog(@"Recorded %d frames to %@", recorder.framesWritten, recordPath);
+    [recorder close];
+    [recordPath release];
+    recordPath = nil;
+  }
+}
+
+/**
+ * \brief Configure the scanner with the density controller's choice
+ *
+ * Only touches the scanner when the density actually changes.
+ */
+- (void) applyDensity {
+  int density = self.densityController.density;
+  if (density == appliedDensity) return;
   
+  [self.scanner setSymbology: ZBAR_NONE config: ZBAR_CFG_X_DENSITY to: density];
+  [self.scanner setSymbology: ZBAR_NONE config: ZBAR_CFG_Y_DENSITY to: density];
+  appliedDensity = density;
+}
+
+/**
+ * \brief Whether the last scan saw a symbol that isn't confirmed yet
+ *
+ * Only happens when the scanner's inter-frame cache is enabled, in which
+ * case a symbol must be seen in several frames before it is reported.
+ *
+ * \return YES if the last scan found an uncertain symbol
+ */
+- (BOOL) sawUncertainSymbol {
+  const zbar_symbol_t *sym = zbar_symbol_set_first_symbol(
+    zbar_image_scanner_get_results([self.scanner zbarImageScanner]));
+  for (; sym; sym = zbar_symbol_next(sym)) {
+    if (zbar_symbol_get_count(sym) < 0) return YES;
+  }
+  return NO;
+}
+
+/**
+ * \brief Post data the last scan decoded but couldn't confirm
+ *
+ * Takes the first uncertain symbol from the image scanner, or else the
+ * scanlineDecoder's single-column decode.  The same data is posted at most
+ * once per SCAN_REARM_TIMEOUT, since a card being presented is read
+ * unconfirmed on several frames in a row.  A replay scanner posts
+ * ASE_ReplayBarcodeCandidate instead.  Must be called on the scan worker.
+ */
+- (void) postCandidate {
+  NSString *candidate = nil;
+  const zbar_symbol_t *sym = zbar_symbol_set_first_symbol(
+    zbar_image_scanner_get_results([self.scanner zbarImageScanner]));
+  for (; sym && !candidate; sym = zbar_symbol_next(sym)) {
+    if (zbar_symbol_get_count(sym) < 0)
+      candidate = [NSString stringWithUTF8String: zbar_symbol_get_data(sym)];
+  }
+  if (!candidate) candidate = scanlines.candidate;
+  if (!candidate || [candidate length] == 0) return;
+  
+  uint64_t now = mach_absolute_time();
+  if ([candidate isEqualToString: lastCandidate] && 
+      machTimeToMs(now - lastCandidateTime) < SCAN_REARM_TIMEOUT * 1000.0)
+    return;
+  [lastCandidate release];
+  lastCandidate = [candidate copy];
+  lastCandidateTime = now;
+  
+  NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+  [center postNotificationName: replaying ? 
+            SCAN_REPLAY_CANDIDATE_NOTIFICATION : @"ASE_BarcodeCandidate"
+          object: self
+          userInfo: [NSDictionary dictionaryWithObject: lastCandidate
+                                  forKey: SCAN_CANDIDATE_KEY]];
+}
+
+/**
+ * \brief Publish the best of the symbols from a synchronous scan
+ *
+ * Results are only published from the scan worker, the results ring's one
+ * writer, so this hands the result over to it.  Symbol locations are in
+ * pixels of the image that was scanned.
+ *
+ * \param symbols Symbols decoded from the most recent scan
+ * \return Whether any symbols were decoded
+ */
+- (BOOL) handleSymbols: (ZBarSymbolSet*) symbols {
+  scanResult *result = [scanResult bestOfSymbols: symbols 
+                                   scale: 1.0 
+                                   offset: CGPointZero 
+                                   sequence: 0];
+  if (!result) return FALSE;
+  
+  dispatch_async(scanQueue, ^{ [self publishResult: result]; });
   return TRUE;
 }
 
+/**
+ * \brief Publish a scan result to the results ring
+ *
+ * Publishes the result and posts ASE_BarcodeScanned, or
+ * ASE_ReplayBarcodeScanned for a replay scanner, unless it is a repeat
+ * decode of a card that is still being presented, or a signed card whose
+ * signature doesn't verify.  Must be called on the scan worker.
+ *
+ * The notification's userInfo carries the frame's sequence number under
+ * SCAN_SEQUENCE_KEY, so later stages can be timed in scanMetrics.
+ *
+ * \param result Best result decoded from a frame
+ * \return Whether the result was published
+ */
+- (BOOL) publishResult: (scanResult*) result {
+  if (![self.coalescer isNewPresentation: result.data]) return NO;
+  if (![memberCard barcodeForScan: result.data]) {
+    NSLog(@"Rejected signed card that doesn't verify: %@", result);
+    return NO;
+  }
+  NSLog(@"Scanned %@", result);
+  if (![self.results publish: result]) {
+    NSLog(@"Scan result too long to publish: %@", result);
+    return NO;
+  }
+  
+  NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+  [center postNotificationName: replaying ? 
+            SCAN_REPLAY_SCANNED_NOTIFICATION : @"ASE_BarcodeScanned"
+          object: self
+          userInfo: [NSDictionary dictionaryWithObject: 
+                      [NSNumber numberWithUnsignedInt: result.sequence]
+                    forKey: SCAN_SEQUENCE_KEY]];
+  return YES;
+}
+
 @end
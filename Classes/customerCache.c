@@ -0,0 +1,243 @@
+//
+//  customerCache.c
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "customerCache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Index slot holding no entry */
+#define EMPTY_SLOT -1
+
+typedef struct {
+  uint32_t hash;
+  uint8_t length;
+  uint8_t used;
+  uint8_t referenced;
+  char key[CUSTOMER_CACHE_MAX_KEY];
+  void *value;
+  size_t bytes;
+} cacheEntry;
+
+struct customerCache {
+  cacheEntry *entries;
+  int32_t *freeEntries;
+  size_t freeCount;
+  int32_t *index;
+  size_t indexMask;
+  size_t hand;
+  customerCacheRelease release;
+  customerCacheStats stats;
+};
+
+/* FNV-1a */
+static uint32_t hashKey(const char *key, size_t length) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (uint8_t)key[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+/* Index slot of a key, or the empty slot where it would go */
+static size_t findSlot(const customerCache *cache, const char *key, 
+                       size_t length, uint32_t hash) {
+  size_t slot = hash & cache->indexMask;
+  for (;;) {
+    int32_t i = cache->index[slot];
+    if (i == EMPTY_SLOT) return slot;
+    const cacheEntry *entry = &cache->entries[i];
+    if (entry->hash == hash && entry->length == length && 
+        !memcmp(entry->key, key, length))
+      return slot;
+    slot = (slot + 1) & cache->indexMask;
+  }
+}
+
+/* Empty an index slot, shifting later entries of the run back into it */
+static void removeSlot(customerCache *cache, size_t hole) {
+  size_t mask = cache->indexMask;
+  size_t slot = hole;
+  cache->index[hole] = EMPTY_SLOT;
+  for (;;) {
+    slot = (slot + 1) & mask;
+    int32_t i = cache->index[slot];
+    if (i == EMPTY_SLOT) return;
+    // An entry can fill the hole only if its home isn't between the two
+    size_t home = cache->entries[i].hash & mask;
+    if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+      cache->index[hole] = i;
+      cache->index[slot] = EMPTY_SLOT;
+      hole = slot;
+    }
+  }
+}
+
+/* Release an entry's value and return it to the free list */
+static void freeEntry(customerCache *cache, int32_t i) {
+  cacheEntry *entry = &cache->entries[i];
+  if (cache->release) cache->release(entry->value);
+  cache->stats.valueBytes -= entry->bytes;
+  cache->stats.entries--;
+  entry->used = 0;
+  entry->value = NULL;
+  cache->freeEntries[cache->freeCount++] = i;
+}
+
+/* Evict the next entry the clock hand finds unreferenced */
+static void evictOne(customerCache *cache) {
+  size_t capacity = cache->stats.capacity;
+  for (;;) {
+    cacheEntry *entry = &cache->entries[cache->hand];
+    size_t i = cache->hand;
+    cache->hand = (cache->hand + 1) % capacity;
+    if (!entry->used) continue;
+    if (entry->referenced) {
+      entry->referenced = 0;
+      continue;
+    }
+    removeSlot(cache, findSlot(cache, entry->key, entry->length, 
+                               entry->hash));
+    freeEntry(cache, (int32_t)i);
+    cache->stats.evictions++;
+    return;
+  }
+}
+
+/* Drop a key's entry, if cached */
+static int removeKey(customerCache *cache, const char *key, size_t length) {
+  if (length > CUSTOMER_CACHE_MAX_KEY) return 0;
+  size_t slot = findSlot(cache, key, length, hashKey(key, length));
+  int32_t i = cache->index[slot];
+  if (i == EMPTY_SLOT) return 0;
+  removeSlot(cache, slot);
+  freeEntry(cache, i);
+  return 1;
+}
+
+customerCache *customerCacheCreate(size_t capacity, size_t maxValueBytes,
+                                   customerCacheRelease release) {
+  if (!capacity || capacity > INT32_MAX / 2) return NULL;
+  customerCache *cache = calloc(1, sizeof(customerCache));
+  if (!cache) return NULL;
+  
+  size_t indexSize = 1;
+  while (indexSize < capacity * 2) indexSize <<= 1;
+  cache->entries = calloc(capacity, sizeof(cacheEntry));
+  cache->freeEntries = malloc(capacity * sizeof(int32_t));
+  cache->index = malloc(indexSize * sizeof(int32_t));
+  if (!cache->entries || !cache->freeEntries || !cache->index) {
+    free(cache->entries);
+    free(cache->freeEntries);
+    free(cache->index);
+    free(cache);
+    return NULL;
+  }
+  
+  for (size_t i = 0; i < indexSize; i++) cache->index[i] = EMPTY_SLOT;
+  // Hand out entries from the front, so the clock finds them in order
+  for (size_t i = 0; i < capacity; i++) 
+    cache->freeEntries[i] = (int32_t)(capacity - 1 - i);
+  cache->freeCount = capacity;
+  cache->indexMask = indexSize - 1;
+  cache->release = release;
+  cache->stats.capacity = capacity;
+  cache->stats.maxValueBytes = maxValueBytes;
+  cache->stats.tableBytes = capacity * (sizeof(cacheEntry) + sizeof(int32_t)) +
+    indexSize * sizeof(int32_t);
+  return cache;
+}
+
+void customerCacheDestroy(customerCache *cache) {
+  if (!cache) return;
+  customerCacheClear(cache);
+  free(cache->entries);
+  free(cache->freeEntries);
+  free(cache->index);
+  free(cache);
+}
+
+void *customerCacheGet(customerCache *cache, const char *key, size_t length) {
+  if (length > CUSTOMER_CACHE_MAX_KEY) {
+    cache->stats.misses++;
+    return NULL;
+  }
+  int32_t i = cache->index[findSlot(cache, key, length, 
+                                    hashKey(key, length))];
+  if (i == EMPTY_SLOT) {
+    cache->stats.misses++;
+    return NULL;
+  }
+  cache->stats.hits++;
+  cache->entries[i].referenced = 1;
+  return cache->entries[i].value;
+}
+
+void customerCachePut(customerCache *cache, const char *key, size_t length,
+                      void *value, size_t bytes) {
+  if (length > CUSTOMER_CACHE_MAX_KEY || bytes > cache->stats.maxValueBytes) {
+    if (cache->release) cache->release(value);
+    return;
+  }
+  removeKey(cache, key, length);
+  
+  while (!cache->freeCount || 
+         cache->stats.valueBytes + bytes > cache->stats.maxValueBytes)
+    evictOne(cache);
+  
+  uint32_t hash = hashKey(key, length);
+  int32_t i = cache->freeEntries[--cache->freeCount];
+  cacheEntry *entry = &cache->entries[i];
+  entry->hash = hash;
+  entry->length = (uint8_t)length;
+  entry->used = 1;
+  entry->referenced = 0;
+  memcpy(entry->key, key, length);
+  entry->value = value;
+  entry->bytes = bytes;
+  cache->index[findSlot(cache, key, length, hash)] = i;
+  cache->stats.entries++;
+  cache->stats.valueBytes += bytes;
+  cache->stats.insertions++;
+}
+
+int customerCacheRemove(customerCache *cache, const char *key, size_t length) {
+  if (!removeKey(cache, key, length)) return 0;
+  cache->stats.invalidations++;
+  return 1;
+}
+
+void customerCacheClear(customerCache *cache) {
+  cache->stats.invalidations += cache->stats.entries;
+  for (size_t i = 0; i <= cache->indexMask; i++) {
+    if (cache->index[i] == EMPTY_SLOT) continue;
+    freeEntry(cache, cache->index[i]);
+    cache->index[i] = EMPTY_SLOT;
+  }
+  cache->hand = 0;
+}
+
+void customerCacheGetStats(const customerCache *cache,
+                           customerCacheStats *stats) {
+  *stats = cache->stats;
+}
@@ -0,0 +1,122 @@
+//
+//  customerCache.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#ifndef CUSTOMER_CACHE_H
+#define CUSTOMER_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fixed-size cache from barcode to an opaque value, with CLOCK eviction.
+ *
+ * Entries live in one array allocated up front, and are found through an
+ * open-addressing index (linear probing, backward-shift deletion) at most
+ * half full, so neither a lookup nor an insertion allocates.  Keys longer
+ * than CUSTOMER_CACHE_MAX_KEY bytes are not cached.
+ *
+ * An entry is evicted when the cache is full, or when the values' sizes
+ * would exceed the byte budget.  Each hit marks its entry referenced, and
+ * the clock hand skips (and unmarks) referenced entries, so customers
+ * scanned often stay in.
+ *
+ * Not thread safe; callers lock around every call.
+ */
+
+/// Longest key cached, in bytes
+#define CUSTOMER_CACHE_MAX_KEY 47
+
+typedef struct customerCache customerCache;
+
+/// Called when a value leaves the cache: evicted, replaced or removed
+typedef void (*customerCacheRelease)(void *value);
+
+typedef struct {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t insertions;
+  uint64_t evictions;
+  uint64_t invalidations;
+  size_t entries;
+  size_t capacity;
+  /// Bytes reported for the values held
+  size_t valueBytes;
+  size_t maxValueBytes;
+  /// Bytes of the entry array and index, fixed at creation
+  size_t tableBytes;
+} customerCacheStats;
+
+/**
+ * \brief Create a cache
+ *
+ * \param capacity Most entries held
+ * \param maxValueBytes Most value bytes held, as reported to
+ *        customerCachePut()
+ * \param release Called for each value leaving the cache, or NULL
+ * \return New cache, or NULL if out of memory
+ */
+customerCache *customerCacheCreate(size_t capacity, size_t maxValueBytes,
+                                   customerCacheRelease release);
+void customerCacheDestroy(customerCache *cache);
+
+/**
+ * \brief Value cached for a key, marking it recently used
+ *
+ * \return Value, or NULL on a miss
+ */
+void *customerCacheGet(customerCache *cache, const char *key, size_t length);
+
+/**
+ * \brief Cache a value, replacing any value already cached for the key
+ *
+ * The cache takes over the value; it is released when it leaves.  A value
+ * that can't be cached (key too long, or bigger than the whole budget) is
+ * released straight away.
+ *
+ * \param bytes Memory the value accounts for, against the byte budget
+ */
+void customerCachePut(customerCache *cache, const char *key, size_t length,
+                      void *value, size_t bytes);
+
+/**
+ * \brief Drop the value cached for a key
+ *
+ * \return 1 if a value was cached, 0 if not
+ */
+int customerCacheRemove(customerCache *cache, const char *key, size_t length);
+
+/// Drop every value
+void customerCacheClear(customerCache *cache);
+
+void customerCacheGetStats(const customerCache *cache,
+                           customerCacheStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
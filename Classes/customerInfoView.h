@@ -28,10 +28,13 @@
 	NSMutableDictionary *currentScan;
   NSTimer *scanTimer;
   UIButton *redeemButton;
+  volatile unsigned displaySequence;
+  uint32_t resultCursor;
 }
 
 -(id)initWithFrame:(CGRect)aRect;
 - (void)newScanHandler:(NSNotification *)notif;
+- (void)candidateHandler:(NSNotification *)notif;
 - (void)redrawScreen;
 - (void)drawRect:(CGRect)rect;
 -(void) drawCenteredText: (NSString*)str y: (int)y;
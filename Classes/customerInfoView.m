@@ -28,6 +28,15 @@
  * database, it is displayed in a large, easily-readable format in this
  * frame.
  *
+ * Customers are looked up through the app's customerPrefetch, which starts
+ * looking up a card as soon as the scanner posts it as a candidate, so the
+ * lookup has usually finished by the time the scan is confirmed.
+ *
+ * A signed membership card (see memberCard) carries the customer's level,
+ * which is displayed as soon as the card is scanned, before the database
+ * has been searched.  If the customer isn't in this device's copy of the
+ * database, the card's level stays on screen.
+ *
  * Layout is intentionally minimalistic, and font is large, so information can
  * be parsed quickly by busy employees at a point-of-sale.
  *
@@ -35,6 +44,10 @@
  
 #import "customerInfoView.h"
 #import "mainAppDelegate.h"
+#import "scanMetrics.h"
+
+/// Confirmed scans between prefetch statistics log lines
+#define PREFETCH_STATS_INTERVAL 20
 
 @interface customerInfoView (PrivateMethods)
 - (void)displayInvalidScanNotification;
@@ -73,7 +86,8 @@
  * \brief Initialize view to given size
  *
  * Creates view with given bounds.  Background color set to dark gray, and
- * registers for ASE_BarcodeScanned notification events.  Sets default
+ * registers for ASE_BarcodeScanned and ASE_BarcodeCandidate notification
+ * events.  Sets default
  * text values to display.
  *
  * \param aRect Size of view
@@ -88,6 +102,10 @@
             selector: @selector(newScanHandler:) 
             name:@"ASE_BarcodeScanned" 
             object: nil];
+    [center addObserver: self 
+            selector: @selector(candidateHandler:) 
+            name:@"ASE_BarcodeCandidate" 
+            object: nil];
     self.currentScan = [NSMutableDictionary dictionaryWithCapacity: 10];
     [self.currentScan setObject:@"No Scan" forKey:@"name"];
     
@@ -138,15 +156,31 @@
   NSString *dbFile = delegate.dbManager.databasePath;
   if (!barcode || !dbFile) return;
   
-  // Log redemption
-  [delegate.dbManager logString: [NSString stringWithFormat:
-    @"CREDIT [%@] credit=[%d]", 
-    barcode,
-    [delegate.customer creditFromDb: dbFile withBarcode: barcode]]
-  ];
+  // Log redemption, on disk before the credit is cleared
+  int credit = [delegate.customer creditFromDb: dbFile withBarcode: barcode];
+  if (![delegate.dbManager logDurableString: [NSString stringWithFormat:
+          @"CREDIT [%@] credit=[%d]", 
+          barcode,
+          credit]]) {
+    UIAlertView *alert = [[[UIAlertView alloc] 
+      initWithTitle: @"Credit Not Redeemed" 
+      message: @"The redemption couldn't be written to the log, so the "
+        "customer's credit was left as it was."
+      delegate: self
+      cancelButtonTitle: nil
+      otherButtonTitles: @"OK",nil] autorelease];
+    [alert show];
+    return;
+  }
+  [delegate.dbManager journalEvent: SCAN_JOURNAL_CREDIT 
+                      barcode: barcode 
+                      values: [NSDictionary dictionaryWithObject: 
+                                [NSNumber numberWithInt: credit] 
+                                forKey: @"credit"]];
   
   // Clear credit
   [delegate.customer clearCreditFromDb: dbFile withBarcode: barcode];
+  [delegate.prefetch invalidate];
   
   // Write database to Dropbox
   NSArray *paths = NSSearchPathForDirectoriesInDomains(
@@ -191,43 +225,55 @@
 - (void)newScanHandler:(NSNotification *)notif {
   mainAppDelegate *delegate = 
       (mainAppDelegate*)[[UIApplication sharedApplication] delegate];
-  NSString *barcode = delegate.scanner.lastCode;
+  
+  // Only the newest result matters if several arrived at once
+  scanResult *result = nil, *next;
+  while ((next = [delegate.scanner.results nextResult: &resultCursor]))
+    result = next;
+  if (!result) return;
+  
+  unsigned sequence = result.sequence;
+  scanMetrics *metrics = [scanMetrics sharedMetrics];
+  [metrics frame: sequence reachedStage: SCAN_STAGE_NOTIFIED];
+  
+  NSString *barcode = result.data;
   NSString *dbFile = delegate.dbManager.databasePath;
 
 	NSLog(@"Scanned: %@", barcode);
 
-  NSString *name = [delegate.customer customerFromDb: dbFile 
-                                      withBarcode: barcode];
-  if (name)
-    [self.currentScan setObject:name forKey:@"name"];
+  // Show a signed card's level straight away, then fill in the rest
+  memberCard *card = [memberCard cardFromPayload: barcode 
+                                 key: [memberCard installedKey]];
+  if (card) {
+    barcode = card.barcode;
+    [self.currentScan removeAllObjects];
+    [self.currentScan setObject: @"Verified member" forKey: @"name"];
+    [self.currentScan setObject: barcode forKey: @"barcode"];
+    [self.currentScan setObject: [NSString stringWithFormat: @"%d", card.tier]
+                      forKey: @"level"];
+    [self performSelectorOnMainThread: @selector(redrawScreen)
+          withObject: nil
+          waitUntilDone: NO];
+  }
 
-  if (!name || [name length] == 0) {
+  NSDictionary *snapshot = [delegate.prefetch snapshotForBarcode: barcode 
+                                              fromDb: dbFile];
+  if (snapshot) {
+    [self.currentScan addEntriesFromDictionary: snapshot];
+  }
+  else if (!card) {
     [self.currentScan removeAllObjects];
   	[self displayInvalidScanNotification];
   }
-  else {
-    NSNumber *tmp = nil;
-    [self.currentScan setObject:barcode forKey:@"barcode"];
-    
-    tmp = [NSString stringWithFormat: @"%d", [delegate.customer 
-      levelFromDb: dbFile withBarcode: barcode]];
-    if (tmp)
-      [self.currentScan setObject:tmp  forKey:@"level"];
-      
-    tmp = [NSString stringWithFormat: @"%d", [delegate.customer 
-      discountFromDb: dbFile withBarcode: barcode]];
-    if (tmp)
-      [self.currentScan setObject:tmp  forKey:@"discount"];
-      
-    tmp = [NSString stringWithFormat: @"%d", [delegate.customer 
-      creditFromDb: dbFile withBarcode: barcode]];
-    if (tmp)
-      [self.currentScan setObject:tmp  forKey:@"credit"];
-      
-    tmp = [NSString stringWithFormat: @"%d", [delegate.customer 
-      referralCountFromDb:dbFile withBarcode:barcode]];
-    if (tmp)
-      [self.currentScan setObject:tmp  forKey:@"referrals"];
+  NSString *name = [snapshot objectForKey: @"name"];
+  [metrics frame: sequence reachedStage: SCAN_STAGE_LOOKED_UP];
+  customerPrefetch *prefetch = delegate.prefetch;
+  if ((prefetch.hits + prefetch.misses) % PREFETCH_STATS_INTERVAL == 0)
+  {
+    NSLog(@"%@", [prefetch summary]);
+    if ([(id)delegate.customer respondsToSelector: @selector(cacheSummary)])
+      NSLog(@"%@", [(id)delegate.customer cacheSummary]);
+    NSLog(@"%@", [delegate.dbManager logSummary]);
   }
   
   // Log scan
@@ -239,6 +285,10 @@
     [self.currentScan objectForKey:@"discount"],
     [self.currentScan objectForKey:@"referrals"]]
   ];
+  [delegate.dbManager journalEvent: SCAN_JOURNAL_SCAN 
+                      barcode: barcode 
+                      values: self.currentScan];
+  [metrics frame: sequence reachedStage: SCAN_STAGE_LOGGED];
   
   // Check if customer is due for a level upgrade
   [delegate.customer updateLevelOfReferrerWithBarcode:barcode withDb: dbFile];
@@ -250,11 +300,30 @@
   [self enableRedeemButton];
   
   // Draw customer's info on the screen
+  displaySequence = sequence;
   [self performSelectorOnMainThread: @selector(redrawScreen)
         withObject: nil
         waitUntilDone: NO];
 }
 
+/**
+ * \brief Handles barcodes decoded but not yet confirmed
+ *
+ * Starts looking the customer up in the background, so the confirmed scan
+ * that usually follows can display it straight away.
+ *
+ * \param notif Notification carrying the candidate under SCAN_CANDIDATE_KEY
+ *
+ */
+- (void)candidateHandler:(NSNotification *)notif {
+  mainAppDelegate *delegate = 
+      (mainAppDelegate*)[[UIApplication sharedApplication] delegate];
+  [delegate.prefetch 
+    prefetchBarcode: [memberCard barcodeForScan: 
+                       [[notif userInfo] objectForKey: SCAN_CANDIDATE_KEY]]
+    fromDb: delegate.dbManager.databasePath];
+}
+
 /**
  * \brief Schedule timer to expire a scan after 5 minutes
  *
@@ -360,7 +429,7 @@
   }
   
   NSString *discount = [self.currentScan objectForKey:@"discount"];
-  if (level) {
+  if (discount) {
     NSString *temp = [[[@"Discount:" stringByPaddingToLength: 15 
                                  withString:@" " 
                                  startingAtIndex: 0] 
@@ -387,7 +456,11 @@
                       stringByAppendingString: count];
     [self drawLeftJustifiedText: temp y: 400];
   }
-
+  
+  // Scan that caused this redraw is now on screen
+  [[scanMetrics sharedMetrics] frame: displaySequence 
+                               reachedStage: SCAN_STAGE_DISPLAYED];
+  displaySequence = 0;
 }
 
 - (NSString*)labelKey:(NSString*)key withLabel:(NSString*)label {
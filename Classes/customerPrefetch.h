@@ -0,0 +1,67 @@
+//
+//  customerPrefetch.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#import <Foundation/Foundation.h>
+#import "customerProtocol.h"
+
+/// Seconds a prefetched customer stays usable
+#define CUSTOMER_PREFETCH_TTL 3.0
+/// Most prefetched customers held at once
+#define CUSTOMER_PREFETCH_CAPACITY 8
+
+
+@interface customerPrefetch : NSObject {
+  int prefetches;
+  int hits;
+  int misses;
+  int wasted;
+  
+  @private
+    id <customerProtocol> customer;
+    NSMutableDictionary *entries;
+    dispatch_queue_t lookupQueue;
+    /// Bumped by each invalidate
+    int generation;
+}
+
+/// Lookups started speculatively
+@property (nonatomic, readonly) int prefetches;
+/// Confirmed scans served from a prefetch
+@property (nonatomic, readonly) int hits;
+/// Confirmed scans that had to look the customer up themselves
+@property (nonatomic, readonly) int misses;
+/// Prefetches that expired or were invalidated without being used
+@property (nonatomic, readonly) int wasted;
+
+-(id)initWithCustomer: (id <customerProtocol>)source;
+-(void)prefetchBarcode: (NSString*)barcode fromDb: (NSString*)dbFile;
+-(NSDictionary*)snapshotForBarcode: (NSString*)barcode 
+                fromDb: (NSString*)dbFile;
+-(void)invalidate;
+-(NSString*)summary;
+
++(NSDictionary*)lookUpBarcode: (NSString*)barcode 
+                inDb: (NSString*)dbFile 
+                customer: (id <customerProtocol>)source;
+
+@end
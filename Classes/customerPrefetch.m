@@ -0,0 +1,238 @@
+//
+//  customerPrefetch.m
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief Looks customers up while their card is still being decoded
+ *
+ * A customer used to be looked up only after the scanner had confirmed the
+ * card and posted ASE_BarcodeScanned.  ZBar usually reads the card a few
+ * frames before that, as an uncertain symbol the scanner's cache hasn't
+ * confirmed yet, or as a single agreeing scanline.  The scanner posts
+ * those as ASE_BarcodeCandidate, and the prefetch looks the customer up
+ * on a background queue straight away.  When the confirmed scan arrives
+ * its customer is usually already here, and the screen updates without
+ * waiting on the database.
+ *
+ * A prefetched customer is kept for CUSTOMER_PREFETCH_TTL seconds, and is
+ * used at most once.  Any write to the database invalidates every entry,
+ * so a confirmed scan never shows data from before a write.  Entries are
+ * tagged with the invalidation generation they were started in, and a
+ * lookup that finishes after an invalidate is dropped, even if the same
+ * barcode has been prefetched again since.
+ *
+ * The counters say whether prefetching pays: hits are confirmed scans
+ * served from a prefetch, misses had to look the customer up themselves,
+ * and wasted prefetches expired or were invalidated unused, typically
+ * from a misread.
+ *
+ * Methods can be called from any thread.
+ *
+ */
+
+#import "customerPrefetch.h"
+
+/// Entry keys
+#define ENTRY_SNAPSHOT @"snapshot"
+#define ENTRY_DB @"db"
+#define ENTRY_TIME @"time"
+#define ENTRY_GENERATION @"generation"
+
+@interface customerPrefetch (PrivateMethods)
+-(void)expireEntriesAt: (NSTimeInterval)now;
+@end
+
+@implementation customerPrefetch
+
+@synthesize prefetches;
+@synthesize hits;
+@synthesize misses;
+@synthesize wasted;
+
+/**
+ * \brief Create a prefetch over a customer database
+ *
+ * \param source Customer protocol implementation to look customers up with
+ * \return Initialized instance
+ */
+-(id)initWithCustomer: (id <customerProtocol>)source {
+  if (self = [super init]) {
+    customer = [source retain];
+    entries = [[NSMutableDictionary alloc] init];
+    lookupQueue = dispatch_queue_create("customerPrefetch", NULL);
+  }
+  return self;
+}
+
+-(void)dealloc {
+  dispatch_sync(lookupQueue, ^{});
+  dispatch_release(lookupQueue);
+  [customer release];
+  [entries release];
+  [super dealloc];
+}
+
+/**
+ * \brief Start looking a customer up in the background
+ *
+ * Does nothing if the customer is already prefetched or being fetched.
+ *
+ * \param barcode Candidate barcode, not yet confirmed
+ * \param dbFile Database to look it up in
+ */
+-(void)prefetchBarcode: (NSString*)barcode fromDb: (NSString*)dbFile {
+  if (!barcode || !dbFile) return;
+  NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+  int started;
+  @synchronized(self) {
+    [self expireEntriesAt: now];
+    if ([entries objectForKey: barcode] || 
+        [entries count] >= CUSTOMER_PREFETCH_CAPACITY)
+      return;
+    // Placeholder until the lookup finishes, so it isn't started twice
+    started = generation;
+    [entries setObject: [NSMutableDictionary dictionaryWithObjectsAndKeys:
+        dbFile, ENTRY_DB, 
+        [NSNumber numberWithDouble: now], ENTRY_TIME, 
+        [NSNumber numberWithInt: started], ENTRY_GENERATION, nil] 
+      forKey: barcode];
+    prefetches++;
+  }
+  
+  barcode = [[barcode copy] autorelease];
+  dispatch_async(lookupQueue, ^{
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSDictionary *snapshot = [customerPrefetch lookUpBarcode: barcode 
+                                               inDb: dbFile 
+                                               customer: customer];
+    @synchronized(self) {
+      NSMutableDictionary *entry = [entries objectForKey: barcode];
+      // Dropped if invalidated while the lookup ran; a placeholder from
+      // after the invalidate waits for its own lookup
+      if (started == generation && entry && 
+          [[entry objectForKey: ENTRY_GENERATION] intValue] == started) 
+        [entry setObject: snapshot ? (id)snapshot : (id)[NSNull null] 
+               forKey: ENTRY_SNAPSHOT];
+    }
+    [pool drain];
+  });
+}
+
+/**
+ * \brief Customer for a confirmed scan, prefetched if possible
+ *
+ * A prefetch still running is waited for, since it is at least as far
+ * along as a new lookup would be.
+ *
+ * \param barcode Confirmed barcode
+ * \param dbFile Database to look it up in
+ * \return Snapshot as from lookUpBarcode:inDb:customer:, or nil if there
+ *         is no such customer
+ */
+-(NSDictionary*)snapshotForBarcode: (NSString*)barcode 
+                fromDb: (NSString*)dbFile {
+  NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+  BOOL pending = NO;
+  @synchronized(self) {
+    [self expireEntriesAt: now];
+    NSDictionary *entry = [entries objectForKey: barcode];
+    pending = entry && ![entry objectForKey: ENTRY_SNAPSHOT] &&
+      [[entry objectForKey: ENTRY_DB] isEqualToString: dbFile];
+  }
+  if (pending) dispatch_sync(lookupQueue, ^{});
+  
+  @synchronized(self) {
+    NSDictionary *entry = [[[entries objectForKey: barcode] retain] 
+      autorelease];
+    id snapshot = [entry objectForKey: ENTRY_SNAPSHOT];
+    if (snapshot && [[entry objectForKey: ENTRY_DB] isEqualToString: dbFile]) {
+      [entries removeObjectForKey: barcode];
+      hits++;
+      return snapshot == [NSNull null] ? nil : snapshot;
+    }
+    misses++;
+  }
+  return [customerPrefetch lookUpBarcode: barcode inDb: dbFile 
+                           customer: customer];
+}
+
+/**
+ * \brief Drop every prefetched customer; call after writing the database
+ */
+-(void)invalidate {
+  @synchronized(self) {
+    wasted += [entries count];
+    [entries removeAllObjects];
+    generation++;
+  }
+}
+
+/**
+ * \brief Counters, for the log
+ */
+-(NSString*)summary {
+  @synchronized(self) {
+    return [NSString stringWithFormat: 
+      @"customer prefetch: %d prefetched, %d hits, %d misses, %d wasted "
+       "(%.0f%% hit rate, %.0f%% waste)",
+      prefetches, hits, misses, wasted,
+      hits + misses ? 100.0 * hits / (hits + misses) : 0.0,
+      prefetches ? 100.0 * wasted / prefetches : 0.0];
+  }
+}
+
+/**
+ * \brief Everything the customer view shows about a customer
+ *
+ * \param barcode Customer's barcode
+ * \param dbFile Database to look it up in
+ * \param source Customer protocol implementation to look it up with
+ * \return Dictionary of name, barcode, level, discount, credit and
+ *         referrals as strings, or nil if there is no such customer
+ */
++(NSDictionary*)lookUpBarcode: (NSString*)barcode 
+                inDb: (NSString*)dbFile 
+                customer: (id <customerProtocol>)source {
+  customerSnapshot *snapshot = [source snapshotFromDb: dbFile 
+                                       withBarcode: barcode];
+  if (![snapshot.name length]) return nil;
+  return [snapshot displayValues];
+}
+
+@end
+
+@implementation customerPrefetch (PrivateMethods)
+
+/**
+ * \brief Drop entries older than CUSTOMER_PREFETCH_TTL; caller holds lock
+ */
+-(void)expireEntriesAt: (NSTimeInterval)now {
+  for (NSString *barcode in [entries allKeys]) {
+    NSDictionary *entry = [entries objectForKey: barcode];
+    if (now - [[entry objectForKey: ENTRY_TIME] doubleValue] < 
+        CUSTOMER_PREFETCH_TTL)
+      continue;
+    [entries removeObjectForKey: barcode];
+    wasted++;
+  }
+}
+
+@end
@@ -42,6 +42,7 @@
  */
  
 #import <UIKit/UIKit.h>
+#import "customerSnapshot.h"
 
 
 @protocol customerProtocol
@@ -161,6 +162,19 @@
  */
 -(NSArray*)allCustomersInDb: (NSString*)dbFile;
 
+/**
+ * \brief Get everything shown about a customer when their card is scanned
+ *
+ * Reads the customer's name, level, discount, credit and referral count
+ * together, so a scan costs one lookup rather than one per value.
+ *
+ * \param dbFile Database to search
+ * \param barcode Barcode number to match
+ * \return Snapshot of the customer, or nil if there is no such customer
+ */
+-(customerSnapshot*)snapshotFromDb: (NSString*)dbFile 
+                    withBarcode: (NSString*)barcode;
+
 /**
  * \brief Get customer name
  * \param dbFile Database to search
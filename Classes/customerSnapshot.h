@@ -0,0 +1,58 @@
+//
+//  customerSnapshot.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#import <Foundation/Foundation.h>
+
+
+@interface customerSnapshot : NSObject {
+  @private
+    NSString *barcode;
+    NSString *name;
+    int level;
+    int discount;
+    int credit;
+    int referrals;
+}
+
+/// Customer's barcode
+@property (nonatomic, readonly) NSString *barcode;
+/// Customer's name
+@property (nonatomic, readonly) NSString *name;
+/// Rewards level
+@property (nonatomic, readonly) int level;
+/// Percent discount
+@property (nonatomic, readonly) int discount;
+/// Monetary credit
+@property (nonatomic, readonly) int credit;
+/// Number of customers they have referred
+@property (nonatomic, readonly) int referrals;
+
+-(id)initWithBarcode: (NSString*)code 
+     name: (NSString*)customerName 
+     level: (int)rewardLevel 
+     discount: (int)percent 
+     credit: (int)amount 
+     referrals: (int)referralCount;
+-(NSDictionary*)displayValues;
+
+@end
@@ -0,0 +1,103 @@
+//
+//  customerSnapshot.m
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief Everything the scan screen shows about a customer, read at once
+ *
+ * A scan used to make five customerProtocol calls, each resolving the
+ * barcode again.  A snapshot is read with one query instead (see
+ * customerProtocol's snapshotFromDb:withBarcode:), and the scalar lookups
+ * are views over it.
+ *
+ * Snapshots are immutable, so they can be cached and handed between
+ * threads without locking.
+ *
+ */
+
+#import "customerSnapshot.h"
+
+@implementation customerSnapshot
+
+@synthesize barcode;
+@synthesize name;
+@synthesize level;
+@synthesize discount;
+@synthesize credit;
+@synthesize referrals;
+
+/**
+ * \brief Create a snapshot
+ *
+ * \param code Customer's barcode; copied
+ * \param customerName Customer's name; copied
+ * \param rewardLevel Rewards level
+ * \param percent Percent discount
+ * \param amount Monetary credit
+ * \param referralCount Customers they have referred
+ * \return Initialized instance
+ */
+-(id)initWithBarcode: (NSString*)code 
+     name: (NSString*)customerName 
+     level: (int)rewardLevel 
+     discount: (int)percent 
+     credit: (int)amount 
+     referrals: (int)referralCount {
+  if (self = [super init]) {
+    barcode = [code copy];
+    name = [customerName copy];
+    level = rewardLevel;
+    discount = percent;
+    credit = amount;
+    referrals = referralCount;
+  }
+  return self;
+}
+
+-(void)dealloc {
+  [barcode release];
+  [name release];
+  [super dealloc];
+}
+
+-(NSString*)description {
+  return [NSString stringWithFormat: @"%@ [%@] level %d, %d%%, $%d, %d refs", 
+    name, barcode, level, discount, credit, referrals];
+}
+
+/**
+ * \brief Values as customerInfoView displays them
+ *
+ * \return Dictionary of name, barcode, level, discount, credit and
+ *         referrals, all strings
+ */
+-(NSDictionary*)displayValues {
+  return [NSDictionary dictionaryWithObjectsAndKeys:
+    name, @"name",
+    barcode, @"barcode",
+    [NSString stringWithFormat: @"%d", level], @"level",
+    [NSString stringWithFormat: @"%d", discount], @"discount",
+    [NSString stringWithFormat: @"%d", credit], @"credit",
+    [NSString stringWithFormat: @"%d", referrals], @"referrals",
+    nil];
+}
+
+@end
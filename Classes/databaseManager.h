@@ -24,15 +24,19 @@
     
 #import <Foundation/Foundation.h>
 #import <sqlite3.h>
+#import "logWriter.h"
+#import "scanJournal.h"
 
 @interface databaseManager : NSObject {
   NSString *databasePath;
   NSString *logFile;
+  NSString *journalFile;
   NSString *logPrefix;
   
   @private
     NSString *databaseFile;
-    NSFileHandle *logFileHandle;
+    logWriter *writer;
+    scanJournal *journal;
     sqlite3 *globalDB;
 }
 
@@ -40,12 +44,20 @@
 @property (nonatomic, retain) NSString *databasePath;
 /// Full path and filename of log file
 @property (nonatomic, retain) NSString *logFile;
+/// Full path and filename of binary journal, kept next to the log file
+@property (nonatomic, retain) NSString *journalFile;
 /// String prefix for log files
 @property (nonatomic, retain) NSString *logPrefix;
 
 -(id)initWithFile: (NSString*)file;
 -(BOOL)reloadWithNewDatabaseFile: (NSURL*)url;
 -(BOOL)logString:(NSString*)str;
+-(BOOL)logDurableString:(NSString*)str;
+-(BOOL)journalEvent: (scanJournalEvent)event 
+       barcode: (NSString*)barcode 
+       values: (NSDictionary*)values;
+-(BOOL)flushLog;
+-(NSString*)logSummary;
 
 +(BOOL) openDbFile: (NSString*)file usingDbPointer: (sqlite3**) db;
 +(void) closeDb: (sqlite3**)db;
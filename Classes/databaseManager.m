@@ -30,8 +30,15 @@
  * the correct location on the filesystem, and retrieving an updated
  * db from a remote location.
  *
+ * It also keeps the scan log.  Lines are handed to a logWriter, whose
+ * thread writes and fsync()s them in batches, so logging a scan doesn't
+ * wait for the disk.  A redemption is logged with logDurableString:,
+ * which returns once the line is on disk.  The same events also go to a
+ * compact binary scanJournal next to the log, for analysis.
+ *
  */
 #import "databaseManager.h"
+#import "sqliteConnection.h"
 
 @interface databaseManager (PrivateMethods)
 -(NSString*) pathFromFile: (NSString*)file;
@@ -43,20 +50,24 @@
 @interface databaseManager () 
 /// Just filename of database without path
 @property (nonatomic, retain) NSString *databaseFile;
-/// Handle for access to logFile
-@property (nonatomic, retain) NSFileHandle *logFileHandle;
 /// Handle for customer database
 @property (nonatomic, assign) sqlite3 *globalDB;
 @end
 
 
+/// Copy a log line to the console from the writer thread, as NSLog did
+static void echoLogLine(const char *text, size_t length, void *context) {
+  NSLog(@"%.*s", (int)length, text);
+}
+
+
 @implementation databaseManager
 
 @synthesize databasePath;
 @synthesize databaseFile;
 @synthesize globalDB;
 @synthesize logFile;
-@synthesize logFileHandle;
+@synthesize journalFile;
 @synthesize logPrefix;
 
 /**
@@ -117,11 +128,10 @@
  * \brief Generate name for log file and open it
  *
  * Log file name: ase_log-[devce UDID]-[epoch time].log
+ * Journal file name: the same, ending .journal
  *
  */
 -(void)generateLogFileNameAndOpen {
-  BOOL err = YES;
-  
   long epoch = (long)([[NSDate date] timeIntervalSince1970]);
 	NSArray *docPaths = NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, 
                                                           NSUserDomainMask, 
@@ -132,27 +142,112 @@
   self.logFile = [docPath stringByAppendingPathComponent: filename];
   NSLog(@"Logfile: %@", self.logFile);
   
-  NSFileManager *fileManager = [[NSFileManager defaultManager] autorelease];
-  err = [fileManager createFileAtPath:self.logFile contents:nil attributes:nil];
-  self.logFileHandle = [NSFileHandle fileHandleForWritingAtPath:self.logFile];
-  [self.logFileHandle seekToEndOfFile];
+  writer = logWriterOpen([self.logFile fileSystemRepresentation], 
+                         echoLogLine, NULL);
+  if (!writer) NSLog(@"Couldn't open log file %@", self.logFile);
+  
+  self.journalFile = [[self.logFile stringByDeletingPathExtension] 
+                       stringByAppendingPathExtension: @"journal"];
+  journal = scanJournalOpen([self.journalFile fileSystemRepresentation]);
+  if (!journal) NSLog(@"Couldn't open journal %@", self.journalFile);
 }
 
 /**
- * \brief Write a string to the open log file and flush to disk
+ * \brief Queue a string for the log file, without waiting for the disk
+ *
+ * The line is timestamped when queued, and is on disk within
+ * LOG_WRITER_SYNC_MS.
  *
  * \param str String to write to log file
- * \return Yes on success, no if log file is not open
+ * \return Yes on success, no if log file is not open or the log is too
+ *         far behind to take the line
  */
 -(BOOL)logString:(NSString*)str {
-  if (!self.logFileHandle) return NO;
-  NSString *logstr = [NSString stringWithFormat:@"%@: %@\n",
-    [NSDate date], str];
-  [self.logFileHandle writeData:
-    [logstr dataUsingEncoding: NSUTF8StringEncoding]];
-  NSLog(@"%@",logstr);
-  [self.logFileHandle synchronizeFile];
-  return YES;
+  if (!writer) return NO;
+  const char *line = [str UTF8String];
+  if (logWriterAppend(writer, line, strlen(line))) return YES;
+  NSLog(@"Log full, dropped: %@", str);
+  return NO;
+}
+
+/**
+ * \brief Write a string to the log file and wait until it is on disk
+ *
+ * For lines that must survive a crash right after, such as redemptions.
+ * Everything logged before it is on disk too.
+ *
+ * \param str String to write to log file
+ * \return Yes once written, no if log file is not open or writing failed
+ */
+-(BOOL)logDurableString:(NSString*)str {
+  if (!writer) return NO;
+  const char *line = [str UTF8String];
+  uint64_t ticket = logWriterAppend(writer, line, strlen(line));
+  if (!ticket) {
+    // Let the writer catch up rather than lose this one
+    logWriterFlush(writer);
+    ticket = logWriterAppend(writer, line, strlen(line));
+  }
+  return ticket && logWriterSync(writer, ticket) == 0;
+}
+
+/**
+ * \brief Add an event to the binary journal
+ *
+ * Values are read from the "level", "discount", "referrals" and "credit"
+ * keys, as strings or numbers; missing keys aren't recorded.  Scans are
+ * written a block at a time, and are on disk after flushLog; a redemption
+ * is on disk, with every event before it, when this returns.
+ *
+ * \param event SCAN_JOURNAL_SCAN or SCAN_JOURNAL_CREDIT
+ * \param barcode Customer's barcode
+ * \param values Fields to record
+ * \return Yes on success, no if journal is not open or writing failed
+ */
+-(BOOL)journalEvent: (scanJournalEvent)event 
+       barcode: (NSString*)barcode 
+       values: (NSDictionary*)values {
+  if (!journal) return NO;
+  scanJournalRecord record;
+  record.event = event;
+  record.fields = 0;
+  const char *code = [barcode UTF8String];
+  record.barcodeLength = code ? MIN(strlen(code), SCAN_JOURNAL_MAX_BARCODE) : 0;
+  if (code) memcpy(record.barcode, code, record.barcodeLength);
+  
+  NSString *keys[] = { @"level", @"discount", @"referrals", @"credit" };
+  uint32_t *fields[] = { &record.level, &record.discount, 
+                         &record.referrals, &record.credit };
+  for (int i = 0; i < 4; i++) {
+    id value = [values objectForKey: keys[i]];
+    *fields[i] = [value intValue];
+    if (value) record.fields |= 1 << i;
+  }
+  return scanJournalAppend(journal, &record) == 0;
+}
+
+/**
+ * \brief Wait until everything logged so far is on disk
+ *
+ * \return Yes once written, no if log file is not open or writing failed
+ */
+-(BOOL)flushLog {
+  BOOL journaled = !journal || scanJournalFlush(journal, 1) == 0;
+  return writer && logWriterFlush(writer) == 0 && journaled;
+}
+
+/**
+ * \brief Log writer counters, for the console
+ */
+-(NSString*)logSummary {
+  if (!writer) return @"log: not open";
+  logWriterStats stats;
+  logWriterGetStats(writer, &stats);
+  return [NSString stringWithFormat: 
+    @"log: %llu lines in %llu writes, %llu fsyncs (%llu for redemptions), "
+     "%llu dropped, %llu errors",
+    stats.appended, stats.batches, stats.syncs, stats.barriers, 
+    stats.dropped, stats.errors];
 }
 
 /**
@@ -165,6 +260,9 @@
  * This method is expected to be called when an external application, such as
  * an e-mail client, delegates All-Seeing Eye to open a database.
  *
+ * The shared sqliteConnection to the old file is closed first, and no
+ * query can open the file again until the new one is in place.
+ *
  * \param url Full path to new database file
  * \return Whether overwrite was successful
  *
@@ -173,6 +271,7 @@
   NSError *err = nil;
   
   [self closeGlobalDB];
+  [sqliteConnection beginReplacingFile: self.databasePath];
 	NSFileManager *fileManager = [[NSFileManager defaultManager] autorelease];  
   
   /* If a database is already in user's Documents, delete it. */
@@ -184,6 +283,7 @@
   /* Copy new database to user's Documents */
   //[fileManager copyItemAtPath: url.absoluteString toPath: self.databasePath error: &err];
   [fileManager copyItemAtPath: url.path toPath: self.databasePath error: &err];
+  [sqliteConnection endReplacingFile: self.databasePath];
   if (err != nil) {
   	NSLog(@"Copy error: %@", [err localizedDescription]);
     return NO;
@@ -222,12 +322,13 @@
 
 -(void) dealloc {
 	[self closeGlobalDB];
-  if (self.logFileHandle) {
-    [self.logFileHandle closeFile];
-    self.logFileHandle = nil;
-  }
+  logWriterClose(writer);
+  writer = NULL;
+  scanJournalClose(journal);
+  journal = NULL;
 	[databasePath release];
   [databaseFile release];
+  [journalFile release];
   [super dealloc];
 }
 
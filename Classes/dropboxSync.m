@@ -278,6 +278,8 @@ NSString *g_lockfile = @"dropbox.lock";
 -(void)uploadLogFile {
   mainAppDelegate *delegate = 
     (mainAppDelegate*)[[UIApplication sharedApplication] delegate];
+  // Upload the current log complete
+  [delegate.dbManager flushLog];
 
   NSFileManager *fileManager = [[NSFileManager defaultManager] autorelease];
 	NSArray *docPaths = NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, 
@@ -538,6 +540,7 @@ NSString *g_lockfile = @"dropbox.lock";
       (mainAppDelegate*)[[UIApplication sharedApplication] delegate];
   NSURL *tmpurl = [NSURL fileURLWithPath:destPath];
 	[delegate.dbManager reloadWithNewDatabaseFile: tmpurl];
+  [delegate.prefetch invalidate];
 
   // For debugging, simulate a successful scan
   //[delegate.scanner simulatorDebug];
@@ -588,9 +591,11 @@ NSString *g_lockfile = @"dropbox.lock";
   // Was this a log file upload?
   NSError *error;
   if ([[srcPath lastPathComponent] hasPrefix:delegate.dbManager.logPrefix]) {
-    // Don't delete the current log file
+    // Don't delete the current log file or journal
     if (![[srcPath lastPathComponent] isEqual: 
-      [delegate.dbManager.logFile lastPathComponent]]) {
+          [delegate.dbManager.logFile lastPathComponent]] &&
+        ![[srcPath lastPathComponent] isEqual: 
+          [delegate.dbManager.journalFile lastPathComponent]]) {
       // Delete old log
       NSFileManager *fileManager = [[NSFileManager defaultManager] autorelease];
       [fileManager removeItemAtPath:srcPath error:&error];
@@ -0,0 +1,66 @@
+//
+//  frameRateGovernor.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#import <Foundation/Foundation.h>
+#import <AVFoundation/AVFoundation.h>
+
+/// Camera frame rate while someone is at the counter
+#define FRAME_RATE_ACTIVE_FPS 10
+/// Camera frame rate while the scene is static
+#define FRAME_RATE_IDLE_FPS 2
+/// Seconds of static scene before dropping to the idle rate
+#define FRAME_RATE_IDLE_SECONDS 30.0
+/// Mean luma difference between frames that counts as activity
+#define FRAME_RATE_MOTION_THRESHOLD 6.0
+
+
+@interface frameRateGovernor : NSObject {
+  BOOL enabled;
+  int idlePeriods;
+  int wakeups;
+  
+  @private
+    AVCaptureVideoDataOutput *output;
+    volatile BOOL idle;
+    uint64_t lastActivity;
+    uint64_t idleStart;
+    double idleTotal;
+}
+
+/// Whether the rate is ever lowered
+@property (nonatomic) BOOL enabled;
+/// Whether the camera is running at the idle rate
+@property (nonatomic, readonly) BOOL idle;
+/// Times the camera dropped to the idle rate
+@property (nonatomic, readonly) int idlePeriods;
+/// Times activity brought the camera back to full rate
+@property (nonatomic, readonly) int wakeups;
+
+-(id)initWithOutput: (AVCaptureVideoDataOutput*)videoOutput;
+-(void)frameWithMotion: (double)motion time: (uint64_t)machTime;
+-(void)decodedAtTime: (uint64_t)machTime;
+-(double)frameInterval;
+-(double)idleSeconds;
+-(NSString*)summary;
+
+@end
@@ -0,0 +1,170 @@
+//
+//  frameRateGovernor.m
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief Lowers the camera frame rate while nobody is at the counter
+ *
+ * The camera used to run at FRAME_RATE_ACTIVE_FPS all day.  With the idle
+ * timer disabled, the devices ran hot through a whole shift even when the
+ * counter was empty.  The governor watches the motion score the scan
+ * worker already computes for every frame.  After FRAME_RATE_IDLE_SECONDS
+ * with no motion and no decodes, it lowers the capture output's
+ * minFrameDuration to FRAME_RATE_IDLE_FPS.  The first frame with motion,
+ * or any decode, puts it straight back.
+ *
+ * While idle, the first frame of a card arriving is up to one idle frame
+ * interval late, and the frames until the rate change takes effect come
+ * at the idle rate.  frameReplay measures what that costs, by replaying a
+ * recording with and without a governor and comparing decodes and CPU
+ * time.  With no output, a governor only tracks state, which is how the
+ * replay uses one.
+ *
+ * The observe methods are called from the scan worker.  The frame rate is
+ * changed on the main thread.
+ *
+ */
+
+#import "frameRateGovernor.h"
+#import "scanMetrics.h"
+#import <mach/mach_time.h>
+
+@interface frameRateGovernor (PrivateMethods)
+-(void)setIdle: (BOOL)isIdle time: (uint64_t)machTime;
+-(void)applyFrameRate: (NSNumber*)fps;
+@end
+
+@implementation frameRateGovernor
+
+@synthesize enabled;
+@synthesize idlePeriods;
+@synthesize wakeups;
+
+/**
+ * \brief Create a governor for a capture output
+ *
+ * \param videoOutput Output whose frame rate is changed, or nil to only
+ *                    track state
+ * \return Initialized instance
+ */
+-(id)initWithOutput: (AVCaptureVideoDataOutput*)videoOutput {
+  if (self = [super init]) {
+    output = [videoOutput retain];
+    self.enabled = YES;
+  }
+  return self;
+}
+
+-(void)dealloc {
+  [output release];
+  [super dealloc];
+}
+
+-(BOOL)idle {
+  return idle;
+}
+
+/**
+ * \brief Note the motion score of a frame
+ *
+ * \param motion Mean luma difference from the previous frame
+ * \param machTime mach_absolute_time() when the frame arrived
+ */
+-(void)frameWithMotion: (double)motion time: (uint64_t)machTime {
+  if (!lastActivity || motion >= FRAME_RATE_MOTION_THRESHOLD) {
+    lastActivity = machTime;
+    if (idle) [self setIdle: NO time: machTime];
+  }
+  else if (!idle && self.enabled && machTimeToMs(machTime - lastActivity) >= 
+           FRAME_RATE_IDLE_SECONDS * 1000.0) {
+    [self setIdle: YES time: machTime];
+  }
+}
+
+/**
+ * \brief Note a decode; a card at the counter counts as activity
+ *
+ * \param machTime mach_absolute_time() when the frame arrived
+ */
+-(void)decodedAtTime: (uint64_t)machTime {
+  lastActivity = machTime;
+  if (idle) [self setIdle: NO time: machTime];
+}
+
+/**
+ * \brief Shortest time between frames at the current rate, in seconds
+ */
+-(double)frameInterval {
+  return 1.0 / (idle ? FRAME_RATE_IDLE_FPS : FRAME_RATE_ACTIVE_FPS);
+}
+
+/**
+ * \brief Total time spent at the idle rate, in seconds
+ */
+-(double)idleSeconds {
+  return idleTotal + (idle && idleStart ? 
+    machTimeToMs(mach_absolute_time() - idleStart) / 1000.0 : 0.0);
+}
+
+/**
+ * \brief Idle counts, for the scan worker's log
+ */
+-(NSString*)summary {
+  return [NSString stringWithFormat: 
+    @"frame rate %d fps, idle %d times for %.0f s, %d wakeups",
+    idle ? FRAME_RATE_IDLE_FPS : FRAME_RATE_ACTIVE_FPS,
+    idlePeriods, [self idleSeconds], wakeups];
+}
+
+@end
+
+@implementation frameRateGovernor (PrivateMethods)
+
+/**
+ * \brief Switch between the idle and active rates
+ */
+-(void)setIdle: (BOOL)isIdle time: (uint64_t)machTime {
+  idle = isIdle;
+  if (isIdle) {
+    idlePeriods++;
+    idleStart = machTime;
+  }
+  else {
+    wakeups++;
+    idleTotal += machTimeToMs(machTime - idleStart) / 1000.0;
+  }
+  
+  NSLog(@"Frame rate governor: %@", isIdle ? @"idle" : @"active");
+  if (output)
+    [self performSelectorOnMainThread: @selector(applyFrameRate:) 
+          withObject: [NSNumber numberWithInt: isIdle ? 
+                        FRAME_RATE_IDLE_FPS : FRAME_RATE_ACTIVE_FPS]
+          waitUntilDone: NO];
+}
+
+/**
+ * \brief Set the capture output's frame rate cap; main thread only
+ */
+-(void)applyFrameRate: (NSNumber*)fps {
+  output.minFrameDuration = CMTimeMake(1, [fps intValue]);
+}
+
+@end
@@ -0,0 +1,56 @@
+//
+//  frameRecorder.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+#import <stdio.h>
+#import "frameRecording.h"
+
+
+@interface frameRecorder : NSObject {
+  NSString *path;
+  int width;
+  int height;
+  int framesWritten;
+  
+  @private
+    FILE *out;
+    uint64_t firstFrameTime;
+}
+
+/// File the recording is written to
+@property (nonatomic, readonly, retain) NSString *path;
+/// Width every frame must have
+@property (nonatomic, readonly) int width;
+/// Height every frame must have
+@property (nonatomic, readonly) int height;
+/// Number of frames written so far
+@property (nonatomic, readonly) int framesWritten;
+
+-(id)initWithPath: (NSString*)file width: (int)frameWidth 
+     height: (int)frameHeight;
+-(BOOL)appendPlane: (const uint8_t*)plane bytesPerRow: (size_t)bytesPerRow 
+       region: (CGRect)region time: (uint64_t)machTime;
+-(void)close;
+
+@end
@@ -0,0 +1,143 @@
+//
+//  frameRecorder.m
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief Writes video frames to a frame recording
+ *
+ * Appends greyscale frames, with the time each arrived, to a file in the
+ * format read by frameRecording.  Frames are cut out of a larger plane as
+ * they are written, so the scan worker can record the displayed strip of
+ * a camera frame without copying it first.
+ *
+ * Every frame must be the size given when the recorder was created.  Each
+ * frame is flushed as it is written, so a recording survives the app being
+ * killed, minus at most the frame being written.
+ *
+ * Not thread safe.
+ *
+ */
+
+#import "frameRecorder.h"
+#import "ZBarSDK.h"
+#import <libkern/OSByteOrder.h>
+#import <mach/mach_time.h>
+
+@interface frameRecorder ()
+@property (nonatomic, readwrite, retain) NSString *path;
+@end
+
+@implementation frameRecorder
+
+@synthesize path;
+@synthesize width;
+@synthesize height;
+@synthesize framesWritten;
+
+/**
+ * \brief Create a recording file and write its header
+ *
+ * \param file Path of the recording; an existing file is replaced
+ * \param frameWidth Width of every frame in pixels
+ * \param frameHeight Height of every frame in pixels
+ * \return Initialized instance, or nil if the file can't be written
+ */
+-(id)initWithPath: (NSString*)file width: (int)frameWidth 
+     height: (int)frameHeight {
+  if (self = [super init]) {
+    self.path = file;
+    width = frameWidth;
+    height = frameHeight;
+    out = fopen([file fileSystemRepresentation], "wb");
+    
+    frameRecordingHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FRAME_RECORDING_MAGIC, sizeof(header.magic));
+    header.version = OSSwapHostToLittleInt32(FRAME_RECORDING_VERSION);
+    header.width = OSSwapHostToLittleInt32(width);
+    header.height = OSSwapHostToLittleInt32(height);
+    header.fourcc = OSSwapHostToLittleInt32(zbar_fourcc('Y','8','0','0'));
+    header.headerLength = OSSwapHostToLittleInt32(sizeof(header));
+    if (!out || width <= 0 || height <= 0 ||
+        fwrite(&header, sizeof(header), 1, out) != 1) {
+      NSLog(@"Frame recorder: can't write %@", file);
+      [self release];
+      return nil;
+    }
+  }
+  return self;
+}
+
+-(void)dealloc {
+  [self close];
+  [path release];
+  [super dealloc];
+}
+
+/**
+ * \brief Append a region of a greyscale plane as the next frame
+ *
+ * \param plane First byte of the plane
+ * \param bytesPerRow Row stride of the plane in bytes
+ * \param region Region of the plane to record; must be width x height
+ * \param machTime mach_absolute_time() when the frame arrived
+ * \return NO if the region is the wrong size or the write failed
+ */
+-(BOOL)appendPlane: (const uint8_t*)plane bytesPerRow: (size_t)bytesPerRow 
+       region: (CGRect)region time: (uint64_t)machTime {
+  region = CGRectIntegral(region);
+  if (!out || !plane || 
+      (int)region.size.width != width || (int)region.size.height != height)
+    return NO;
+  
+  if (!framesWritten) firstFrameTime = machTime;
+  mach_timebase_info_data_t timebase;
+  mach_timebase_info(&timebase);
+  frameRecordingFrame prefix;
+  prefix.timestamp = OSSwapHostToLittleInt64(
+    (machTime - firstFrameTime) * timebase.numer / timebase.denom);
+  prefix.length = OSSwapHostToLittleInt32(width * height);
+  
+  BOOL ok = fwrite(&prefix, sizeof(prefix), 1, out) == 1;
+  const uint8_t *row = plane + (size_t)region.origin.y * bytesPerRow + 
+    (size_t)region.origin.x;
+  for (int y = 0; ok && y < height; y++, row += bytesPerRow)
+    ok = fwrite(row, width, 1, out) == 1;
+  ok = ok && fflush(out) == 0;
+  
+  if (!ok) {
+    NSLog(@"Frame recorder: write to %@ failed, stopping", self.path);
+    [self close];
+    return NO;
+  }
+  framesWritten++;
+  return YES;
+}
+
+/**
+ * \brief Finish the recording; later frames are ignored
+ */
+-(void)close {
+  if (out) fclose(out);
+  out = NULL;
+}
+
+@end
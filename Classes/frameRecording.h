@@ -0,0 +1,85 @@
+//
+//  frameRecording.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#import <Foundation/Foundation.h>
+
+/// File extension of frame recordings
+#define FRAME_RECORDING_EXTENSION @"asefr"
+/// First eight bytes of every frame recording
+#define FRAME_RECORDING_MAGIC "ASEFRAME"
+/// Format version written by frameRecorder
+#define FRAME_RECORDING_VERSION 1
+
+/**
+ * File header of a frame recording.  All fields are little-endian.  The
+ * header is followed by frames, each a frameRecordingFrame followed by
+ * length bytes of Y800 data with packed rows.
+ */
+typedef struct {
+  char magic[8];          ///< FRAME_RECORDING_MAGIC, not NUL terminated
+  uint32_t version;       ///< FRAME_RECORDING_VERSION
+  uint32_t width;         ///< Frame width in pixels
+  uint32_t height;        ///< Frame height in pixels
+  uint32_t fourcc;        ///< Pixel format, always Y800 for now
+  uint32_t headerLength;  ///< Bytes from start of file to the first frame
+  uint32_t reserved;
+} frameRecordingHeader;
+
+/// Prefix of each frame in a recording
+typedef struct {
+  uint64_t timestamp;     ///< Nanoseconds since the first frame
+  uint32_t length;        ///< Bytes of pixel data that follow
+} __attribute__((packed)) frameRecordingFrame;
+
+
+@interface frameRecording : NSObject {
+  NSString *path;
+  int width;
+  int height;
+  uint32_t fourcc;
+  
+  @private
+    NSData *mapping;
+    NSUInteger *offsets;
+    uint64_t *timestamps;
+    int frameCount;
+}
+
+/// File the recording was read from
+@property (nonatomic, readonly, retain) NSString *path;
+/// Width of every frame in pixels
+@property (nonatomic, readonly) int width;
+/// Height of every frame in pixels
+@property (nonatomic, readonly) int height;
+/// Pixel format of every frame
+@property (nonatomic, readonly) uint32_t fourcc;
+/// Number of complete frames in the recording
+@property (nonatomic, readonly) int frameCount;
+
++(frameRecording*)recordingWithContentsOfFile: (NSString*)file;
+-(id)initWithContentsOfFile: (NSString*)file;
+-(const uint8_t*)frameAtIndex: (int)index;
+-(uint64_t)timestampAtIndex: (int)index;
+-(NSData*)frameDataAtIndex: (int)index;
+
+@end
@@ -0,0 +1,176 @@
+//
+//  frameRecording.m
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief Read-only view of a recorded sequence of video frames
+ *
+ * A frame recording holds the greyscale frames the scanner saw, with the
+ * time each one arrived, so a scan problem seen in the field can be played
+ * back through the scanner exactly (see frameReplay), or the frames used as
+ * a benchmark corpus.  Recordings are written by frameRecorder.
+ *
+ * The file is a frameRecordingHeader giving the size and pixel format of
+ * the frames, followed by the frames.  Each frame is a frameRecordingFrame
+ * prefix with its timestamp and length, then the pixel data.
+ *
+ * The file is memory-mapped rather than read, so opening a long recording
+ * costs one pass to index the frames and frame data is never copied.  A
+ * frame cut short at the end of the file, as happens if the app dies while
+ * recording, is ignored.
+ *
+ */
+
+#import "frameRecording.h"
+#import "ZBarSDK.h"
+#import <libkern/OSByteOrder.h>
+
+@interface frameRecording ()
+@property (nonatomic, readwrite, retain) NSString *path;
+@end
+
+@implementation frameRecording
+
+@synthesize path;
+@synthesize width;
+@synthesize height;
+@synthesize fourcc;
+@synthesize frameCount;
+
+/**
+ * \brief Open a frame recording
+ * \param file Path of the recording
+ * \return Autoreleased recording, or nil if the file isn't a valid recording
+ */
++(frameRecording*)recordingWithContentsOfFile: (NSString*)file {
+  return [[[frameRecording alloc] initWithContentsOfFile: file] autorelease];
+}
+
+/**
+ * \brief Map a frame recording and index its frames
+ * \param file Path of the recording
+ * \return Initialized instance, or nil if the file isn't a valid recording
+ */
+-(id)initWithContentsOfFile: (NSString*)file {
+  if (self = [super init]) {
+    self.path = file;
+    NSData *mapped = [NSData dataWithContentsOfFile: file 
+                             options: NSDataReadingMappedAlways 
+                             error: nil];
+    const frameRecordingHeader *header = [mapped bytes];
+    if ([mapped length] < sizeof(frameRecordingHeader) ||
+        memcmp(header->magic, FRAME_RECORDING_MAGIC, 8) ||
+        OSSwapLittleToHostInt32(header->version) != FRAME_RECORDING_VERSION) {
+      NSLog(@"Frame recording: %@ is not a recording", file);
+      [self release];
+      return nil;
+    }
+    width = OSSwapLittleToHostInt32(header->width);
+    height = OSSwapLittleToHostInt32(header->height);
+    fourcc = OSSwapLittleToHostInt32(header->fourcc);
+    if (fourcc != zbar_fourcc('Y','8','0','0') || width <= 0 || height <= 0 ||
+        (uint64_t)width * height > UINT32_MAX) {
+      NSLog(@"Frame recording: %@ has an unsupported format", file);
+      [self release];
+      return nil;
+    }
+    // Frames can't start inside the header, or past the end of the file
+    NSUInteger offset = OSSwapLittleToHostInt32(header->headerLength);
+    if (offset < sizeof(frameRecordingHeader) || offset > [mapped length]) {
+      NSLog(@"Frame recording: %@ has a bad header length", file);
+      [self release];
+      return nil;
+    }
+    mapping = [mapped retain];
+    
+    // Index the frames in one pass over the prefixes
+    const uint8_t *bytes = [mapped bytes];
+    NSUInteger length = [mapped length];
+    int capacity = 0;
+    while (offset + sizeof(frameRecordingFrame) <= length) {
+      const frameRecordingFrame *frame = 
+        (const frameRecordingFrame*)(bytes + offset);
+      NSUInteger frameLength = OSSwapLittleToHostInt32(frame->length);
+      NSUInteger data = offset + sizeof(frameRecordingFrame);
+      if (frameLength < (NSUInteger)width * height || 
+          data + frameLength > length)
+        break;
+      
+      if (frameCount == capacity) {
+        capacity = capacity ? capacity * 2 : 256;
+        NSUInteger *newOffsets = realloc(offsets, capacity * sizeof(*offsets));
+        if (newOffsets) offsets = newOffsets;
+        uint64_t *newTimestamps = realloc(timestamps, 
+                                          capacity * sizeof(*timestamps));
+        if (newTimestamps) timestamps = newTimestamps;
+        if (!newOffsets || !newTimestamps) {
+          [self release];
+          return nil;
+        }
+      }
+      offsets[frameCount] = data;
+      timestamps[frameCount] = OSSwapLittleToHostInt64(frame->timestamp);
+      frameCount++;
+      offset = data + frameLength;
+    }
+  }
+  return self;
+}
+
+-(void)dealloc {
+  [path release];
+  [mapping release];
+  free(offsets);
+  free(timestamps);
+  [super dealloc];
+}
+
+/**
+ * \brief Pixel data of a frame, width * height bytes with packed rows
+ *
+ * Points into the mapped file, so it is only valid while the recording is.
+ *
+ * \param index Frame number
+ * \return Pointer to the first pixel, or NULL if index is out of range
+ */
+-(const uint8_t*)frameAtIndex: (int)index {
+  if (index < 0 || index >= frameCount) return NULL;
+  return (const uint8_t*)[mapping bytes] + offsets[index];
+}
+
+/**
+ * \brief Time a frame arrived, in nanoseconds since the first frame
+ */
+-(uint64_t)timestampAtIndex: (int)index {
+  if (index < 0 || index >= frameCount) return 0;
+  return timestamps[index];
+}
+
+/**
+ * \brief Pixel data of a frame as an object that keeps the mapping alive
+ */
+-(NSData*)frameDataAtIndex: (int)index {
+  if (index < 0 || index >= frameCount) return nil;
+  return [mapping subdataWithRange: NSMakeRange(offsets[index], 
+                                              (NSUInteger)width * height)];
+}
+
+@end
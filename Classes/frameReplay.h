@@ -0,0 +1,63 @@
+//
+//  frameReplay.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#import <Foundation/Foundation.h>
+#import <CoreVideo/CoreVideo.h>
+#import "frameRecording.h"
+
+@class codeScanner;
+@class frameRateGovernor;
+
+/// Directory in Documents holding recordings to replay
+#define FRAME_REPLAY_DIRECTORY @"scan_replay"
+/// User default, set from the Settings app, that requests one replay
+#define FRAME_REPLAY_DEFAULTS_KEY @"ASE_ReplayRecordedFrames"
+/// Optional file in FRAME_REPLAY_DIRECTORY holding the replay speed
+#define FRAME_REPLAY_SPEED_FILE @"speed.txt"
+
+
+@interface frameReplay : NSObject {
+  frameRecording *recording;
+  codeScanner *scanner;
+  double speed;
+  frameRateGovernor *governor;
+  
+  @private
+    NSMutableData *chroma;
+    int decodes;
+}
+
+/// Recording being played back
+@property (nonatomic, readonly, retain) frameRecording *recording;
+/// Replay scanner the frames are submitted to, new for each run
+@property (nonatomic, readonly, retain) codeScanner *scanner;
+/// Playback rate; 1 is real time, 0 scans every frame as fast as possible
+@property (nonatomic) double speed;
+/// Governor to throttle the recording with, as it would the camera, or nil
+@property (nonatomic, retain) frameRateGovernor *governor;
+
+-(id)initWithRecording: (frameRecording*)frames;
+-(NSDictionary*)run;
++(void)replayInBackgroundIfRequested;
+
+@end
@@ -0,0 +1,320 @@
+//
+//  frameReplay.m
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief Plays a frame recording back through the scanner
+ *
+ * Each recorded frame is wrapped in a bi-planar YUV pixel buffer, like the
+ * camera delivers, and submitted to a codeScanner the same way cameraView
+ * does.  Everything after the camera runs exactly as it does live: the
+ * scan worker, density control, coalescing and metrics.  That makes a
+ * problem recorded in the field reproducible, and lets pipeline changes be
+ * compared on the same frames.
+ *
+ * Each run gets a new scanner of its own, made with initForReplay, so runs
+ * start from the same state and the camera's scanner is never touched.  A
+ * replay scanner posts its decodes as ASE_ReplayBarcodeScanned, so the
+ * customer screen doesn't look up customers for recorded cards.
+ *
+ * At a speed of 1 frames are submitted at the times they were recorded,
+ * so frames the scanner can't keep up with are dropped as they would be
+ * live.  Higher speeds compress the gaps.  A speed of 0 is lockstep: each
+ * frame is submitted once the previous one has been scanned, so every
+ * frame is scanned and runs are deterministic.
+ *
+ * The luma plane points straight into the mapped recording.  The chroma
+ * plane is a single neutral grey buffer shared by every frame, since the
+ * scanner never reads it.
+ *
+ * With a frameRateGovernor set, the replay scanner feeds it, and recorded
+ * frames closer together than the governor's current frame interval are
+ * skipped, as the camera would not have delivered them.  Comparing a run
+ * with a governor against one without shows how many decodes idling costs
+ * and how much CPU time it saves.  The governor goes idle on real time, so
+ * this needs a speed of 1.
+ *
+ * Recordings in the Documents/scan_replay directory are played back by
+ * replayInBackgroundIfRequested, once "Replay recorded frames" is switched
+ * on in the app's Settings, at the speed given in scan_replay/speed.txt,
+ * or real time if there is none.  Each is played once without a governor
+ * and once with one.
+ *
+ */
+
+#import "frameReplay.h"
+#import "codeScanner.h"
+#import "cameraView.h"
+#import <mach/mach_time.h>
+#import <sys/resource.h>
+
+@interface frameReplay (PrivateMethods)
+-(CVPixelBufferRef)createBufferForFrame: (int)index;
+-(void)scanHandler: (NSNotification*)notif;
++(void)replayThread: (NSString*)path;
+@end
+
+@interface frameReplay ()
+@property (nonatomic, readwrite, retain) frameRecording *recording;
+@property (nonatomic, readwrite, retain) codeScanner *scanner;
+@end
+
+/**
+ * \brief CPU time used by the whole process so far, in ms
+ */
+static double processCpuMs(void) {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage)) return 0.0;
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 + 
+    (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+}
+
+/**
+ * \brief Pixel buffer release callback; drops the frame's recording
+ */
+static void releaseReplayFrame(void *refCon, const void *dataPtr, 
+                               size_t dataSize, size_t numberOfPlanes, 
+                               const void *planeAddresses[]) {
+  [(frameRecording*)refCon release];
+}
+
+@implementation frameReplay
+
+@synthesize recording;
+@synthesize scanner;
+@synthesize speed;
+@synthesize governor;
+
+/**
+ * \brief Create a replay of a recording
+ *
+ * \param frames Recording to play back
+ * \return Initialized instance, playing at real time
+ */
+-(id)initWithRecording: (frameRecording*)frames {
+  if (self = [super init]) {
+    self.recording = frames;
+    self.speed = 1.0;
+    
+    // Interleaved CbCr at half resolution in each direction, all neutral
+    chroma = [[NSMutableData alloc] initWithLength: 
+      frames.width * ((frames.height + 1) / 2)];
+    memset([chroma mutableBytes], 128, [chroma length]);
+  }
+  return self;
+}
+
+-(void)dealloc {
+  [recording release];
+  [scanner release];
+  [chroma release];
+  [governor release];
+  [super dealloc];
+}
+
+/**
+ * \brief Play the whole recording, blocking until it has been scanned
+ *
+ * \return Dictionary with frames, delivered, decodes, elapsed_ms, cpu_ms
+ *         and recorded_ms
+ */
+-(NSDictionary*)run {
+  mach_timebase_info_data_t timebase;
+  mach_timebase_info(&timebase);
+  
+  decodes = 0;
+  self.scanner = [[[codeScanner alloc] initForReplay] autorelease];
+  [[NSNotificationCenter defaultCenter] 
+    addObserver: self 
+    selector: @selector(scanHandler:) 
+    name: SCAN_REPLAY_SCANNED_NOTIFICATION 
+    object: self.scanner];
+  
+  self.scanner.governor = self.governor;
+  CGRect crop = CGRectMake(0, 0, recording.width, recording.height);
+  CGRect target = [cameraView targetRectInStrip: crop];
+  int count = recording.frameCount, delivered = 0;
+  uint64_t lastDelivered = 0;
+  double cpuStart = processCpuMs();
+  uint64_t start = mach_absolute_time();
+  for (int i = 0; i < count; i++) {
+    // Skip frames the governed camera wouldn't have delivered
+    uint64_t recorded = [recording timestampAtIndex: i];
+    if (self.governor && delivered && 
+        recorded - lastDelivered < [self.governor frameInterval] * 1e9)
+      continue;
+    lastDelivered = recorded;
+    delivered++;
+    
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    if (self.speed > 0) {
+      uint64_t due = [recording timestampAtIndex: i] / self.speed * 
+        timebase.denom / timebase.numer;
+      mach_wait_until(start + due);
+    }
+    
+    CVPixelBufferRef buffer = [self createBufferForFrame: i];
+    if (buffer) {
+      [self.scanner submitPixelBuffer: buffer crop: crop target: target];
+      CVPixelBufferRelease(buffer);
+    }
+    if (self.speed <= 0) [self.scanner waitUntilIdle];
+    [pool drain];
+  }
+  [self.scanner waitUntilIdle];
+  uint64_t elapsed = mach_absolute_time() - start;
+  double cpu = processCpuMs() - cpuStart;
+  
+  [[NSNotificationCenter defaultCenter] removeObserver: self];
+  
+  return [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSNumber numberWithInt: count], @"frames",
+    [NSNumber numberWithInt: delivered], @"delivered",
+    [NSNumber numberWithInt: decodes], @"decodes",
+    [NSNumber numberWithDouble: cpu], @"cpu_ms",
+    [NSNumber numberWithDouble: 
+      (double)elapsed * timebase.numer / timebase.denom / 1e6], @"elapsed_ms",
+    [NSNumber numberWithDouble: 
+      count ? [recording timestampAtIndex: count - 1] / 1e6 : 0], 
+      @"recorded_ms",
+    nil];
+}
+
+/**
+ * \brief Replay installed recordings on a background thread if requested
+ *
+ * Checks, and clears, the Settings switch so each request plays once, then
+ * plays every recording in the Documents/scan_replay directory, in name
+ * order, without blocking the caller.
+ */
++(void)replayInBackgroundIfRequested {
+  NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+  if (![defaults boolForKey: FRAME_REPLAY_DEFAULTS_KEY])
+    return;
+  [defaults setBool: NO forKey: FRAME_REPLAY_DEFAULTS_KEY];
+  [defaults synchronize];
+  
+	NSArray *docPaths = NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, 
+                                                          NSUserDomainMask, 
+                                                          YES);
+  NSString *path = [[docPaths objectAtIndex: 0] 
+    stringByAppendingPathComponent: FRAME_REPLAY_DIRECTORY];
+  BOOL isDir = NO;
+  if (![[NSFileManager defaultManager] fileExistsAtPath: path 
+                                       isDirectory: &isDir] || !isDir) {
+    NSLog(@"Frame replay: no %@ directory in Documents", 
+          FRAME_REPLAY_DIRECTORY);
+    return;
+  }
+  
+  [NSThread detachNewThreadSelector: @selector(replayThread:) 
+            toTarget: self 
+            withObject: path];
+}
+
+@end
+
+@implementation frameReplay (PrivateMethods)
+
+/**
+ * \brief Wrap a recorded frame in a bi-planar pixel buffer without copying
+ *
+ * The buffer keeps the recording alive until it is released.
+ *
+ * \param index Frame number
+ * \return New pixel buffer the caller must release, or NULL on failure
+ */
+-(CVPixelBufferRef)createBufferForFrame: (int)index {
+  void *planes[2] = {
+    (void*)[recording frameAtIndex: index], [chroma mutableBytes]
+  };
+  size_t widths[2] = { recording.width, recording.width / 2 };
+  size_t heights[2] = { recording.height, (recording.height + 1) / 2 };
+  size_t bytesPerRow[2] = { recording.width, recording.width };
+  if (!planes[0]) return NULL;
+  
+  CVPixelBufferRef buffer = NULL;
+  [recording retain];
+  CVReturn err = CVPixelBufferCreateWithPlanarBytes(kCFAllocatorDefault, 
+    recording.width, recording.height, 
+    kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange, NULL, 0, 
+    2, planes, widths, heights, bytesPerRow, 
+    releaseReplayFrame, recording, NULL, &buffer);
+  if (err != kCVReturnSuccess) {
+    [recording release];
+    return NULL;
+  }
+  return buffer;
+}
+
+/**
+ * \brief Count scan notifications from the scanner being replayed into
+ */
+-(void)scanHandler: (NSNotification*)notif {
+  decodes++;
+}
+
+/**
+ * \brief Thread body for replayInBackgroundIfRequested
+ */
++(void)replayThread: (NSString*)path {
+  NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+  
+  NSString *speedText = [NSString stringWithContentsOfFile: 
+      [path stringByAppendingPathComponent: FRAME_REPLAY_SPEED_FILE]
+    encoding: NSUTF8StringEncoding error: nil];
+  double speed = speedText ? [speedText doubleValue] : 1.0;
+  
+  NSArray *files = [[[NSFileManager defaultManager] 
+      contentsOfDirectoryAtPath: path error: nil] 
+    sortedArrayUsingSelector: @selector(compare:)];
+  for (NSString *name in files) {
+    if (![[[name pathExtension] lowercaseString] 
+          isEqualToString: FRAME_RECORDING_EXTENSION])
+      continue;
+    
+    NSAutoreleasePool *filePool = [[NSAutoreleasePool alloc] init];
+    frameRecording *frames = [frameRecording recordingWithContentsOfFile: 
+      [path stringByAppendingPathComponent: name]];
+    if (frames) {
+      frameReplay *replay = [[[frameReplay alloc] initWithRecording: frames] 
+        autorelease];
+      replay.speed = speed;
+      NSDictionary *ungoverned = [replay run];
+      replay.governor = [[[frameRateGovernor alloc] initWithOutput: nil] 
+        autorelease];
+      NSDictionary *governed = [replay run];
+      NSLog(@"Frame replay: %@ at speed %g: %@, with frame rate governor: "
+             "%@, %d decodes missed, %.0f ms CPU saved, %@", 
+            name, speed, ungoverned, governed,
+            [[ungoverned objectForKey: @"decodes"] intValue] - 
+              [[governed objectForKey: @"decodes"] intValue],
+            [[ungoverned objectForKey: @"cpu_ms"] doubleValue] - 
+              [[governed objectForKey: @"cpu_ms"] doubleValue],
+            [replay.governor summary]);
+    }
+    [filePool drain];
+  }
+  
+  [pool release];
+}
+
+@end
@@ -0,0 +1,348 @@
+//
+//  logWriter.c
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "logWriter.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Room for the timestamp and separator before each line */
+#define STAMP_BYTES 32
+/* Bytes the writer collects before each write() */
+#define BATCH_BYTES (LOG_WRITER_SYNC_BYTES + \
+                     LOG_WRITER_RECORD_BYTES + STAMP_BYTES + 1)
+/* Longest the writer sleeps with nothing to do, in milliseconds */
+#define IDLE_MS 1000
+
+#define LOAD(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define STORE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#define COUNT(p, n) __atomic_fetch_add(p, n, __ATOMIC_RELAXED)
+
+typedef struct {
+  /* Position + 1 once filled; position + ring size once drained */
+  uint64_t sequence;
+  int64_t timeUs;
+  uint32_t length;
+  char text[LOG_WRITER_RECORD_BYTES];
+} logRecord;
+
+struct logWriter {
+  logRecord *ring;
+  uint64_t head;
+  
+  int fd;
+  logWriterEchoFunc echo;
+  void *echoContext;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  /* Signalled when there's work for a sleeping writer */
+  pthread_cond_t wake;
+  /* Broadcast after each fsync() */
+  pthread_cond_t synced;
+  int sleeping;
+  int stopping;
+  int failed;
+  /* Highest ticket waited for, and highest on disk */
+  uint64_t syncRequested;
+  uint64_t durable;
+  
+  /* Writer thread only */
+  uint64_t tail;
+  char *batch;
+  int64_t stampSecond;
+  char stamp[STAMP_BYTES];
+  size_t stampLength;
+  
+  logWriterStats stats;
+};
+
+static int64_t nowUs(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/* Absolute time for pthread_cond_timedwait() */
+static struct timespec deadlineAt(int64_t us) {
+  struct timespec ts;
+  ts.tv_sec = (time_t)(us / 1000000);
+  ts.tv_nsec = (long)(us % 1000000) * 1000;
+  return ts;
+}
+
+/* Copy a record's line, timestamped, into the batch */
+static size_t formatRecord(logWriter *writer, const logRecord *record, 
+                           char *out) {
+  int64_t second = record->timeUs / 1000000;
+  // Lines come in bursts within a second; format its timestamp once
+  if (second != writer->stampSecond) {
+    time_t t = (time_t)second;
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    writer->stampLength = strftime(writer->stamp, sizeof(writer->stamp), 
+                                   "%Y-%m-%d %H:%M:%S +0000: ", &tm);
+    writer->stampSecond = second;
+  }
+  size_t stampLength = writer->stampLength;
+  memcpy(out, writer->stamp, stampLength);
+  memcpy(out + stampLength, record->text, record->length);
+  out[stampLength + record->length] = '\n';
+  return stampLength + record->length + 1;
+}
+
+/* Move ready records into the batch; returns bytes collected */
+static size_t drain(logWriter *writer, uint64_t *lines) {
+  size_t bytes = 0;
+  *lines = 0;
+  while (bytes + LOG_WRITER_RECORD_BYTES + STAMP_BYTES + 1 <= BATCH_BYTES) {
+    logRecord *record = 
+      &writer->ring[writer->tail & (LOG_WRITER_RING_RECORDS - 1)];
+    if (LOAD(&record->sequence) != writer->tail + 1) break;
+    bytes += formatRecord(writer, record, writer->batch + bytes);
+    // Echo before the slot is handed back to producers
+    if (writer->echo) 
+      writer->echo(record->text, record->length, writer->echoContext);
+    STORE(&record->sequence, writer->tail + LOG_WRITER_RING_RECORDS);
+    writer->tail++;
+    (*lines)++;
+  }
+  return bytes;
+}
+
+static int writeAll(int fd, const char *bytes, size_t length) {
+  while (length) {
+    ssize_t written = write(fd, bytes, length);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    bytes += written;
+    length -= (size_t)written;
+  }
+  return 0;
+}
+
+/* Whether a record is waiting at the tail */
+static int ready(logWriter *writer) {
+  const logRecord *record = 
+    &writer->ring[writer->tail & (LOG_WRITER_RING_RECORDS - 1)];
+  return LOAD(&record->sequence) == writer->tail + 1;
+}
+
+static void *writerThread(void *arg) {
+  logWriter *writer = arg;
+  uint64_t written = 0;
+  size_t unsyncedBytes = 0;
+  int64_t unsyncedSince = 0;
+  
+  for (;;) {
+    uint64_t lines;
+    size_t bytes = drain(writer, &lines);
+    if (bytes) {
+      if (writeAll(writer->fd, writer->batch, bytes) && !writer->failed) {
+        COUNT(&writer->stats.errors, 1);
+        pthread_mutex_lock(&writer->mutex);
+        writer->failed = 1;
+        pthread_cond_broadcast(&writer->synced);
+        pthread_mutex_unlock(&writer->mutex);
+      }
+      written = writer->tail;
+      if (!unsyncedBytes) unsyncedSince = nowUs();
+      unsyncedBytes += bytes;
+      COUNT(&writer->stats.batches, 1);
+      COUNT(&writer->stats.bytesWritten, bytes);
+      if (lines > LOAD(&writer->stats.maxBatch))
+        STORE(&writer->stats.maxBatch, lines);
+    }
+    
+    // Group commit: one fsync() for everything written since the last
+    uint64_t requested = LOAD(&writer->syncRequested);
+    int barrier = requested > LOAD(&writer->durable) && written >= requested;
+    if (unsyncedBytes && 
+        (barrier || unsyncedBytes >= LOG_WRITER_SYNC_BYTES || 
+         LOAD(&writer->stopping) || 
+         nowUs() - unsyncedSince >= LOG_WRITER_SYNC_MS * 1000)) {
+      int failed = fsync(writer->fd) != 0;
+      pthread_mutex_lock(&writer->mutex);
+      if (failed) {
+        writer->failed = 1;
+        COUNT(&writer->stats.errors, 1);
+      }
+      writer->durable = written;
+      pthread_cond_broadcast(&writer->synced);
+      pthread_mutex_unlock(&writer->mutex);
+      COUNT(&writer->stats.syncs, 1);
+      if (barrier) COUNT(&writer->stats.barriers, 1);
+      unsyncedBytes = 0;
+    }
+    if (bytes) continue;
+    
+    pthread_mutex_lock(&writer->mutex);
+    if (writer->stopping && !unsyncedBytes && !ready(writer)) {
+      pthread_mutex_unlock(&writer->mutex);
+      break;
+    }
+    // A producer checks sleeping after publishing its record, so either
+    // it sees the flag and signals, or the record is seen here
+    STORE(&writer->sleeping, 1);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!ready(writer) && !writer->stopping && 
+        writer->syncRequested <= writer->durable) {
+      struct timespec deadline = deadlineAt(unsyncedBytes ? 
+        unsyncedSince + LOG_WRITER_SYNC_MS * 1000 : 
+        nowUs() + IDLE_MS * 1000);
+      pthread_cond_timedwait(&writer->wake, &writer->mutex, &deadline);
+    }
+    STORE(&writer->sleeping, 0);
+    pthread_mutex_unlock(&writer->mutex);
+  }
+  return NULL;
+}
+
+logWriter *logWriterOpen(const char *path, logWriterEchoFunc echo, 
+                         void *context) {
+  logWriter *writer = calloc(1, sizeof(*writer));
+  if (!writer) return NULL;
+  writer->ring = calloc(LOG_WRITER_RING_RECORDS, sizeof(logRecord));
+  writer->batch = malloc(BATCH_BYTES);
+  writer->fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (!writer->ring || !writer->batch || writer->fd < 0) {
+    if (writer->fd >= 0) close(writer->fd);
+    free(writer->ring);
+    free(writer->batch);
+    free(writer);
+    return NULL;
+  }
+  for (uint64_t i = 0; i < LOG_WRITER_RING_RECORDS; i++)
+    writer->ring[i].sequence = i;
+  writer->echo = echo;
+  writer->echoContext = context;
+  writer->stampSecond = -1;
+  pthread_mutex_init(&writer->mutex, NULL);
+  pthread_cond_init(&writer->wake, NULL);
+  pthread_cond_init(&writer->synced, NULL);
+  if (pthread_create(&writer->thread, NULL, writerThread, writer)) {
+    pthread_mutex_destroy(&writer->mutex);
+    pthread_cond_destroy(&writer->wake);
+    pthread_cond_destroy(&writer->synced);
+    close(writer->fd);
+    free(writer->ring);
+    free(writer->batch);
+    free(writer);
+    return NULL;
+  }
+  return writer;
+}
+
+void logWriterClose(logWriter *writer) {
+  if (!writer) return;
+  pthread_mutex_lock(&writer->mutex);
+  STORE(&writer->stopping, 1);
+  pthread_cond_signal(&writer->wake);
+  pthread_mutex_unlock(&writer->mutex);
+  pthread_join(writer->thread, NULL);
+  
+  close(writer->fd);
+  pthread_mutex_destroy(&writer->mutex);
+  pthread_cond_destroy(&writer->wake);
+  pthread_cond_destroy(&writer->synced);
+  free(writer->ring);
+  free(writer->batch);
+  free(writer);
+}
+
+uint64_t logWriterAppend(logWriter *writer, const char *text, size_t length) {
+  uint64_t position = __atomic_load_n(&writer->head, __ATOMIC_RELAXED);
+  logRecord *record;
+  for (;;) {
+    record = &writer->ring[position & (LOG_WRITER_RING_RECORDS - 1)];
+    int64_t lag = (int64_t)(LOAD(&record->sequence) - position);
+    if (lag == 0) {
+      if (__atomic_compare_exchange_n(&writer->head, &position, position + 1,
+                                      1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        break;
+    }
+    else if (lag < 0) {
+      // The writer hasn't drained this slot since its last lap
+      COUNT(&writer->stats.dropped, 1);
+      return 0;
+    }
+    else {
+      position = __atomic_load_n(&writer->head, __ATOMIC_RELAXED);
+    }
+  }
+  
+  if (length > LOG_WRITER_RECORD_BYTES) {
+    length = LOG_WRITER_RECORD_BYTES;
+    COUNT(&writer->stats.truncated, 1);
+  }
+  record->timeUs = nowUs();
+  record->length = (uint32_t)length;
+  memcpy(record->text, text, length);
+  STORE(&record->sequence, position + 1);
+  COUNT(&writer->stats.appended, 1);
+  
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (LOAD(&writer->sleeping)) {
+    pthread_mutex_lock(&writer->mutex);
+    pthread_cond_signal(&writer->wake);
+    pthread_mutex_unlock(&writer->mutex);
+  }
+  return position + 1;
+}
+
+int logWriterSync(logWriter *writer, uint64_t ticket) {
+  if (!ticket) return -1;
+  pthread_mutex_lock(&writer->mutex);
+  if (ticket > writer->syncRequested) 
+    STORE(&writer->syncRequested, ticket);
+  if (writer->durable < ticket) pthread_cond_signal(&writer->wake);
+  while (writer->durable < ticket && !writer->failed)
+    pthread_cond_wait(&writer->synced, &writer->mutex);
+  int result = writer->failed ? -1 : 0;
+  pthread_mutex_unlock(&writer->mutex);
+  return result;
+}
+
+int logWriterFlush(logWriter *writer) {
+  uint64_t head = LOAD(&writer->head);
+  return head ? logWriterSync(writer, head) : 0;
+}
+
+void logWriterGetStats(logWriter *writer, logWriterStats *stats) {
+  stats->appended = LOAD(&writer->stats.appended);
+  stats->dropped = LOAD(&writer->stats.dropped);
+  stats->truncated = LOAD(&writer->stats.truncated);
+  stats->batches = LOAD(&writer->stats.batches);
+  stats->syncs = LOAD(&writer->stats.syncs);
+  stats->barriers = LOAD(&writer->stats.barriers);
+  stats->bytesWritten = LOAD(&writer->stats.bytesWritten);
+  stats->errors = LOAD(&writer->stats.errors);
+  stats->maxBatch = LOAD(&writer->stats.maxBatch);
+}
@@ -0,0 +1,137 @@
+//
+//  logWriter.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#ifndef LOG_WRITER_H
+#define LOG_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Append-only text log written by a background thread, with group commit.
+ *
+ * Producers copy a line into a bounded ring (a sequence number per slot,
+ * claimed with one compare-and-swap) and return; they never wait for the
+ * disk or allocate, and take a lock only to wake the writer when it's
+ * asleep.  If the ring is full the line is dropped and counted rather than
+ * blocking the caller.
+ *
+ * The writer thread drains the ring in order, stamps each line with the
+ * time it was appended, writes the batch with one write() and calls
+ * fsync() once LOG_WRITER_SYNC_BYTES are unsynced, once the oldest
+ * unsynced line is LOG_WRITER_SYNC_MS old, or as soon as a producer waits
+ * in logWriterSync().  Lines look the way NSDate printed them:
+ *
+ *   2026-10-17 21:04:11 +0000: SCAN [...]
+ */
+
+/// Longest line kept, in bytes; longer lines are truncated
+#define LOG_WRITER_RECORD_BYTES 240
+/// Lines the ring holds; a power of two
+#define LOG_WRITER_RING_RECORDS 1024
+/// Unsynced bytes that force an fsync()
+#define LOG_WRITER_SYNC_BYTES (32 * 1024)
+/// Longest a written line waits for fsync(), in milliseconds
+#define LOG_WRITER_SYNC_MS 250
+
+typedef struct logWriter logWriter;
+
+/**
+ * \brief Called from the writer thread with each line as it's batched
+ *
+ * \param text Line, without the timestamp or newline; not terminated
+ * \param length Bytes of text
+ * \param context As passed to logWriterOpen()
+ */
+typedef void (*logWriterEchoFunc)(const char *text, size_t length, 
+                                  void *context);
+
+typedef struct {
+  uint64_t appended;
+  /// Lines lost because the ring was full
+  uint64_t dropped;
+  uint64_t truncated;
+  /// write() calls, each one batch
+  uint64_t batches;
+  uint64_t syncs;
+  /// fsync() calls made early for logWriterSync()
+  uint64_t barriers;
+  uint64_t bytesWritten;
+  uint64_t errors;
+  /// Most lines in one batch
+  uint64_t maxBatch;
+} logWriterStats;
+
+/**
+ * \brief Open a log file for appending and start its writer thread
+ *
+ * \param path File to append to; created if it doesn't exist
+ * \param echo Called with every line, from the writer thread, or NULL
+ * \param context Passed to echo
+ * \return New writer, or NULL if the file couldn't be opened
+ */
+logWriter *logWriterOpen(const char *path, logWriterEchoFunc echo, 
+                         void *context);
+
+/**
+ * \brief Write everything appended, fsync() it and close the file
+ *
+ * Nothing may be appended during or after the close.
+ */
+void logWriterClose(logWriter *writer);
+
+/**
+ * \brief Queue a line, without waiting
+ *
+ * \param text Line, without the timestamp or newline
+ * \param length Bytes of text
+ * \return Ticket for logWriterSync(), or 0 if the ring was full
+ */
+uint64_t logWriterAppend(logWriter *writer, const char *text, size_t length);
+
+/**
+ * \brief Wait until a line, and every line before it, is on disk
+ *
+ * \param ticket Returned by logWriterAppend()
+ * \return 0 once durable, -1 if writing failed
+ */
+int logWriterSync(logWriter *writer, uint64_t ticket);
+
+/**
+ * \brief Wait until every line appended so far is on disk
+ *
+ * \return 0 once durable, -1 if writing failed
+ */
+int logWriterFlush(logWriter *writer);
+
+void logWriterGetStats(logWriter *writer, logWriterStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -26,6 +26,7 @@
 #import "codeScanner.h"
 #import "databaseManager.h"
 #import "customerProtocol.h"
+#import "customerPrefetch.h"
 #import "dropboxSync.h"
 
 #define ASE_VERSION @"1.0"
@@ -38,6 +39,7 @@
     databaseManager *dbManager;
     dropboxSync *dropbox;
     id <customerProtocol> customer;
+    customerPrefetch *prefetch;
     NSURL *newDatabaseFileUrl;
 }
 
@@ -55,6 +57,8 @@
 @property (nonatomic, retain) dropboxSync *dropbox;
 /// Class instance that handles getting customer info from database
 @property (nonatomic, retain) id <customerProtocol> customer;
+/// Looks customers up ahead of confirmed scans; invalidate after writes
+@property (nonatomic, retain) customerPrefetch *prefetch;
 /// URL of new database file from external application
 @property (nonatomic, retain) NSURL *newDatabaseFileUrl;
 
@@ -30,7 +30,10 @@
  */
  
 #import "mainAppDelegate.h"
-#import "stubCustomer.h"
+#import "sqliteCustomer.h"
+#import "scanBenchmark.h"
+#import "frameReplay.h"
+#import "memberCard.h"
 
 @implementation mainAppDelegate
 
@@ -41,6 +44,7 @@
 @synthesize dbManager;
 @synthesize dropbox;
 @synthesize customer;
+@synthesize prefetch;
 @synthesize newDatabaseFileUrl;
 
 
@@ -55,8 +59,14 @@
     window = [[UIWindow alloc] initWithFrame:[[UIScreen mainScreen] bounds]]; 
     self.scanner = [[codeScanner alloc] init];
     self.dbManager = [[databaseManager alloc] initWithFile: @"database.sql"];
-    self.customer = [[stubCustomer alloc] init];
+    self.customer = [[sqliteCustomer alloc] init];
+    self.prefetch = [[[customerPrefetch alloc] initWithCustomer: self.customer]
+      autorelease];
     self.dropbox = [[dropboxSync alloc] init];
+    
+    // Sign every customer's membership card if the shop asked for them
+    [memberCard signCardsInBackgroundIfRequestedFrom: self.customer 
+                db: self.dbManager.databasePath];
       
     NSString *message = [NSString stringWithFormat:
         @"This is All-Seeing Eye %@\n"
@@ -154,6 +164,7 @@
   
     if (self.newDatabaseFileUrl) {
       [dbManager reloadWithNewDatabaseFile: self.newDatabaseFileUrl];
+      [self.prefetch invalidate];
     }
   }
 }
@@ -163,6 +174,8 @@
    Sent when the application is about to move from active to inactive state. This can occur for certain types of temporary interruptions (such as an incoming phone call or SMS message) or when the user quits the application and it begins the transition to the background state.
    Use this method to pause ongoing tasks, disable timers, and throttle down OpenGL ES frame rates. Games should use this method to pause the game.
    */
+  // The app may not come back; put the scan log on disk
+  [dbManager flushLog];
 }
 
 
@@ -170,6 +183,10 @@
   /*
    Restart any tasks that were paused (or not yet started) while the application was inactive.
    */
+  // Benchmark scanner configurations if asked to from Settings
+  [scanBenchmark runInBackgroundIfRequested];
+  // Replay recorded camera frames if asked to from Settings
+  [frameReplay replayInBackgroundIfRequested];
 }
 
 
@@ -179,6 +196,7 @@
    */
    // Re-enable auto-dimming
   [[UIApplication sharedApplication] setIdleTimerDisabled:NO];
+  [dbManager flushLog];
 
 }
 
@@ -0,0 +1,71 @@
+//
+//  memberCard.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#import <Foundation/Foundation.h>
+#import "customerProtocol.h"
+
+/// First field of every signed card payload; also its format version
+#define MEMBER_CARD_PREFIX @"ASE1"
+/// Bytes of HMAC-SHA256 kept in a card's signature
+#define MEMBER_CARD_SIGNATURE_BYTES 10
+/// Shortest card key accepted, in bytes
+#define MEMBER_CARD_MIN_KEY_BYTES 16
+/// File in Documents holding the card signing key
+#define MEMBER_CARD_KEY_FILE @"card_key"
+/// File in Documents whose presence asks for every customer's card to be
+/// signed; removed once the cards are written
+#define MEMBER_CARD_SIGN_REQUEST @"sign_cards"
+/// File in Documents that signed cards are written to
+#define MEMBER_CARD_EXPORT_FILE @"member_cards.csv"
+/// Cards a signing worker takes at once
+#define MEMBER_CARD_SIGN_CHUNK 64
+
+
+@interface memberCard : NSObject {
+  @private
+    NSString *barcode;
+    int tier;
+    NSString *payload;
+}
+
+/// Customer's barcode in the database
+@property (nonatomic, readonly) NSString *barcode;
+/// Customer's rewards level when the card was signed
+@property (nonatomic, readonly) int tier;
+/// Signed contents of the card, as printed in its QR code
+@property (nonatomic, readonly) NSString *payload;
+
++(memberCard*)cardFromPayload: (NSString*)data key: (NSData*)key;
++(BOOL)isCardPayload: (NSString*)data;
++(NSString*)payloadForBarcode: (NSString*)code 
+            tier: (int)level 
+            key: (NSData*)key;
++(NSData*)installedKey;
++(NSString*)barcodeForScan: (NSString*)data;
++(NSArray*)payloadsForCustomers: (NSArray*)customers 
+           tiers: (const int*)tiers 
+           key: (NSData*)key;
++(void)signCardsInBackgroundIfRequestedFrom: (id <customerProtocol>)source 
+      db: (NSString*)dbFile;
+
+@end
@@ -0,0 +1,341 @@
+//
+//  memberCard.m
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief Signed membership cards that can be checked without the database
+ *
+ * A plain card only carries the customer's barcode, so nothing is known
+ * about it until the database has been searched, and a device with a
+ * stale copy of the database can't tell a new customer from a bad card.
+ *
+ * A signed card is a QR code whose payload carries the barcode and the
+ * customer's rewards level, signed with a key the shop installs on its
+ * devices:
+ *
+ *   ASE1:<level>:<signature>:<barcode>
+ *
+ * The signature is the first MEMBER_CARD_SIGNATURE_BYTES of the
+ * HMAC-SHA256 of everything before it plus the barcode, as upper case hex.
+ * The barcode is last so it can hold any characters, including colons.
+ *
+ * The key is read from MEMBER_CARD_KEY_FILE in Documents, installed through
+ * iTunes file sharing like the database.  It is a shared secret: every
+ * device that checks cards can also sign them.
+ *
+ * Placing a MEMBER_CARD_SIGN_REQUEST file in Documents signs a card for
+ * every customer at launch, in parallel, and writes them to
+ * MEMBER_CARD_EXPORT_FILE for a QR printing tool.
+ *
+ */
+
+#import "memberCard.h"
+#import <CommonCrypto/CommonHMAC.h>
+
+@interface memberCard (PrivateMethods)
+-(id)initWithBarcode: (NSString*)code 
+     tier: (int)level 
+     payload: (NSString*)signedData;
++(NSString*)signatureOf: (NSString*)message key: (NSData*)key;
++(void)signThread: (NSDictionary*)job;
+@end
+
+@implementation memberCard
+
+@synthesize barcode;
+@synthesize tier;
+@synthesize payload;
+
+-(void)dealloc {
+  [barcode release];
+  [payload release];
+  [super dealloc];
+}
+
+-(NSString*)description {
+  return [NSString stringWithFormat: @"card %@ level %d", barcode, tier];
+}
+
+/**
+ * \brief Read a signed card from scanned data
+ *
+ * \param data Scanned barcode contents
+ * \param key Signing key
+ * \return Autoreleased card, or nil if the data isn't a card signed with
+ *         the key
+ */
++(memberCard*)cardFromPayload: (NSString*)data key: (NSData*)key {
+  if (!key || ![memberCard isCardPayload: data]) return nil;
+  
+  // Split at the first three colons only; the barcode may contain more
+  NSString *fields[3];
+  NSRange rest = NSMakeRange(0, [data length]);
+  for (int i = 0; i < 3; i++) {
+    NSRange colon = [data rangeOfString: @":" options: 0 range: rest];
+    if (colon.location == NSNotFound) return nil;
+    fields[i] = [data substringWithRange: 
+      NSMakeRange(rest.location, colon.location - rest.location)];
+    rest = NSMakeRange(NSMaxRange(colon), [data length] - NSMaxRange(colon));
+  }
+  NSString *code = [data substringWithRange: rest];
+  if (![code length]) return nil;
+  
+  NSScanner *scanner = [NSScanner scannerWithString: fields[1]];
+  int level;
+  if (![scanner scanInt: &level] || ![scanner isAtEnd]) return nil;
+  
+  // Compare every byte so timing doesn't reveal how much matched
+  NSString *expected = [memberCard signatureOf: 
+    [NSString stringWithFormat: @"%@:%@:%@", fields[0], fields[1], code] 
+    key: key];
+  NSData *a = [expected dataUsingEncoding: NSASCIIStringEncoding];
+  NSData *b = [[fields[2] uppercaseString] 
+    dataUsingEncoding: NSASCIIStringEncoding];
+  if ([a length] != [b length]) return nil;
+  const uint8_t *pa = [a bytes], *pb = [b bytes];
+  uint8_t diff = 0;
+  for (NSUInteger i = 0; i < [a length]; i++) diff |= pa[i] ^ pb[i];
+  if (diff) return nil;
+  
+  return [[[memberCard alloc] initWithBarcode: code 
+                              tier: level 
+                              payload: data] autorelease];
+}
+
+/**
+ * \brief Whether scanned data claims to be a signed card
+ *
+ * Doesn't check the signature; a payload that claims to be a card but
+ * doesn't verify is forged or corrupt.
+ */
++(BOOL)isCardPayload: (NSString*)data {
+  return [data hasPrefix: MEMBER_CARD_PREFIX @":"];
+}
+
+/**
+ * \brief Sign a card
+ *
+ * \param code Customer's barcode
+ * \param level Customer's rewards level
+ * \param key Signing key
+ * \return Payload to print in the card's QR code
+ */
++(NSString*)payloadForBarcode: (NSString*)code 
+            tier: (int)level 
+            key: (NSData*)key {
+  NSString *prefix = [NSString stringWithFormat: @"%@:%d", 
+    MEMBER_CARD_PREFIX, level];
+  NSString *signature = [memberCard signatureOf: 
+    [NSString stringWithFormat: @"%@:%@", prefix, code] key: key];
+  return [NSString stringWithFormat: @"%@:%@:%@", prefix, signature, code];
+}
+
+/**
+ * \brief Signing key installed in Documents
+ *
+ * Read once it is found, since it only changes when the app is reinstalled.
+ *
+ * \return Key, or nil if none is installed or it is too short
+ */
++(NSData*)installedKey {
+  static NSData *key = nil;
+  @synchronized([memberCard class]) {
+    if (key) return key;
+    NSArray *docPaths = NSSearchPathForDirectoriesInDomains(
+      NSDocumentDirectory, NSUserDomainMask, YES);
+    NSData *contents = [NSData dataWithContentsOfFile: 
+      [[docPaths objectAtIndex: 0] 
+        stringByAppendingPathComponent: MEMBER_CARD_KEY_FILE]];
+    if ([contents length] >= MEMBER_CARD_MIN_KEY_BYTES) 
+      key = [contents retain];
+    return key;
+  }
+}
+
+/**
+ * \brief Database barcode for scanned data
+ *
+ * \param data Scanned barcode contents
+ * \return Barcode of a signed card, the data itself if it isn't a signed
+ *         card, or nil for a card whose signature doesn't verify
+ */
++(NSString*)barcodeForScan: (NSString*)data {
+  if (![memberCard isCardPayload: data]) return data;
+  return [memberCard cardFromPayload: data 
+                     key: [memberCard installedKey]].barcode;
+}
+
+/**
+ * \brief Sign cards for many customers in parallel
+ *
+ * Workers take MEMBER_CARD_SIGN_CHUNK customers at a time across every
+ * core.  Customers without a barcode get an empty payload.
+ *
+ * \param customers Customer dictionaries with "barcode" keys, as from
+ *        allCustomersInDb:
+ * \param tiers Rewards level of each customer
+ * \param key Signing key
+ * \return Payloads in the same order as customers
+ */
++(NSArray*)payloadsForCustomers: (NSArray*)customers 
+           tiers: (const int*)tiers 
+           key: (NSData*)key {
+  size_t count = [customers count];
+  NSString **payloads = calloc(count ? count : 1, sizeof(NSString*));
+  size_t chunks = (count + MEMBER_CARD_SIGN_CHUNK - 1) / MEMBER_CARD_SIGN_CHUNK;
+  
+  dispatch_apply(chunks, dispatch_get_global_queue(0, 0), ^(size_t chunk) {
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    size_t end = MIN(count, (chunk + 1) * MEMBER_CARD_SIGN_CHUNK);
+    for (size_t i = chunk * MEMBER_CARD_SIGN_CHUNK; i < end; i++) {
+      NSString *code = [[customers objectAtIndex: i] objectForKey: @"barcode"];
+      payloads[i] = [code length] ? 
+        [[memberCard payloadForBarcode: code tier: tiers[i] key: key] retain] :
+        @"";
+    }
+    [pool drain];
+  });
+  
+  NSArray *result = [NSArray arrayWithObjects: payloads count: count];
+  for (size_t i = 0; i < count; i++) [payloads[i] release];
+  free(payloads);
+  return result;
+}
+
+/**
+ * \brief Sign every customer's card if a signing request was installed
+ *
+ * \param source Customer protocol implementation to read customers with
+ * \param dbFile Database to read customers from
+ */
++(void)signCardsInBackgroundIfRequestedFrom: (id <customerProtocol>)source 
+      db: (NSString*)dbFile {
+  NSArray *docPaths = NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, 
+                                                          NSUserDomainMask, 
+                                                          YES);
+  NSString *request = [[docPaths objectAtIndex: 0] 
+    stringByAppendingPathComponent: MEMBER_CARD_SIGN_REQUEST];
+  if (![[NSFileManager defaultManager] fileExistsAtPath: request]) return;
+  if (![memberCard installedKey]) {
+    NSLog(@"Card signing requested, but no %@ is installed", 
+          MEMBER_CARD_KEY_FILE);
+    return;
+  }
+  
+  NSDictionary *job = [NSDictionary dictionaryWithObjectsAndKeys:
+    source, @"customer", dbFile, @"db", request, @"request", nil];
+  [NSThread detachNewThreadSelector: @selector(signThread:) 
+            toTarget: [memberCard class] 
+            withObject: job];
+}
+
+@end
+
+@implementation memberCard (PrivateMethods)
+
+-(id)initWithBarcode: (NSString*)code 
+     tier: (int)level 
+     payload: (NSString*)signedData {
+  if (self = [super init]) {
+    barcode = [code copy];
+    tier = level;
+    payload = [signedData copy];
+  }
+  return self;
+}
+
+/**
+ * \brief Truncated HMAC-SHA256 of a message, as upper case hex
+ */
++(NSString*)signatureOf: (NSString*)message key: (NSData*)key {
+  NSData *bytes = [message dataUsingEncoding: NSUTF8StringEncoding];
+  unsigned char mac[CC_SHA256_DIGEST_LENGTH];
+  CCHmac(kCCHmacAlgSHA256, [key bytes], [key length], 
+         [bytes bytes], [bytes length], mac);
+  
+  char hex[MEMBER_CARD_SIGNATURE_BYTES * 2 + 1];
+  for (int i = 0; i < MEMBER_CARD_SIGNATURE_BYTES; i++)
+    snprintf(hex + i * 2, 3, "%02X", mac[i]);
+  return [NSString stringWithUTF8String: hex];
+}
+
+/**
+ * \brief Thread spawned by signCardsInBackgroundIfRequestedFrom:db:
+ *
+ * Customers and levels are read serially, since the customer protocol
+ * isn't thread safe; only the signing runs in parallel.  Writes one CSV
+ * line per customer, then removes the request.
+ */
++(void)signThread: (NSDictionary*)job {
+  NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+  id <customerProtocol> source = [job objectForKey: @"customer"];
+  NSString *dbFile = [job objectForKey: @"db"];
+  
+  NSArray *customers = [source allCustomersInDb: dbFile];
+  size_t count = [customers count];
+  int *tiers = malloc((count ? count : 1) * sizeof(int));
+  for (size_t i = 0; i < count; i++) {
+    tiers[i] = [source levelFromDb: dbFile withBarcode: 
+      [[customers objectAtIndex: i] objectForKey: @"barcode"]];
+  }
+  
+  NSDate *start = [NSDate date];
+  NSArray *payloads = [memberCard payloadsForCustomers: customers 
+                                  tiers: tiers 
+                                  key: [memberCard installedKey]];
+  double elapsed = -[start timeIntervalSinceNow];
+  
+  NSMutableString *csv = [NSMutableString stringWithString: 
+    @"barcode,name,level,payload\n"];
+  for (size_t i = 0; i < count; i++) {
+    NSDictionary *row = [customers objectAtIndex: i];
+    NSString *name = [[row objectForKey: @"name"] 
+      stringByReplacingOccurrencesOfString: @"\"" withString: @"\"\""];
+    NSString *code = [[row objectForKey: @"barcode"] 
+      stringByReplacingOccurrencesOfString: @"\"" withString: @"\"\""];
+    NSString *signedData = [[payloads objectAtIndex: i] 
+      stringByReplacingOccurrencesOfString: @"\"" withString: @"\"\""];
+    [csv appendFormat: @"\"%@\",\"%@\",%d,\"%@\"\n", 
+      code, name, tiers[i], signedData];
+  }
+  free(tiers);
+  
+  NSArray *docPaths = NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, 
+                                                          NSUserDomainMask, 
+                                                          YES);
+  NSString *outFile = [[docPaths objectAtIndex: 0] 
+    stringByAppendingPathComponent: MEMBER_CARD_EXPORT_FILE];
+  NSError *err = nil;
+  if (![csv writeToFile: outFile atomically: YES 
+            encoding: NSUTF8StringEncoding error: &err]) {
+    NSLog(@"Card signing: couldn't write %@: %@", outFile, err);
+  }
+  else {
+    [[NSFileManager defaultManager] removeItemAtPath: 
+      [job objectForKey: @"request"] error: nil];
+    NSLog(@"Card signing: %zu cards in %.3f s (%.0f cards/sec), written to %@",
+          count, elapsed, elapsed > 0.0 ? count / elapsed : 0.0, outFile);
+  }
+  
+  [pool drain];
+}
+
+@end
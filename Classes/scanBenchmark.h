@@ -0,0 +1,66 @@
+//
+//  scanBenchmark.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#import <Foundation/Foundation.h>
+#import "ZBarSDK.h"
+#import "scanPyramid.h"
+
+/// Directory in Documents that holds the benchmark frame corpus
+#define SCAN_CORPUS_DIRECTORY @"scan_corpus"
+/// File in Documents that benchmark results are written to
+#define SCAN_BENCHMARK_RESULTS @"scan_benchmark.json"
+/// User default, set from the Settings app, that requests one benchmark run
+#define SCAN_BENCHMARK_DEFAULTS_KEY @"ASE_RunScanBenchmark"
+
+
+@interface scanBenchmark : NSObject {
+  NSString *corpusPath;
+  NSDictionary *configurations;
+  
+  @private
+    NSMutableArray *frames;
+}
+
+/// Directory containing PGM/Y800 frames to scan
+@property (nonatomic, retain) NSString *corpusPath;
+/// Scanner configurations to compare, name -> array of ZBar config strings
+@property (nonatomic, retain) NSDictionary *configurations;
+
+-(id)initWithCorpus: (NSString*)path;
+-(int)loadCorpus;
+-(NSDictionary*)runConfiguration: (NSArray*)config;
+-(NSDictionary*)runScanner: (ZBarImageScanner*)scanner;
+-(NSDictionary*)runScanner: (ZBarImageScanner*)scanner targetOnly: (BOOL)target;
+-(NSDictionary*)runScanner: (ZBarImageScanner*)scanner 
+                targetOnly: (BOOL)target 
+                pyramid: (scanPyramid*)pyramid;
+-(NSDictionary*)runScanlines: (NSDictionary*)profile;
+-(NSDictionary*)runGate: (ZBarImageScanner*)scanner;
+-(NSString*)run;
+
++(NSDictionary*)defaultConfigurations;
++(NSDictionary*)benchmarkKernels;
++(NSDictionary*)checkScanlineOrientation: (NSDictionary*)profile;
++(void)runInBackgroundIfRequested;
+
+@end
@@ -0,0 +1,963 @@
+//
+//  scanBenchmark.m
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief Measures barcode decode throughput over a corpus of frames
+ *
+ * Loads a directory of greyscale frames and runs every frame through a
+ * ZBar image scanner once per scanner configuration.  For each
+ * configuration it reports frames/sec, median and 99th percentile per-frame
+ * scan time, hit rate, and how many symbols of each symbology were decoded.
+ * Results are written as JSON so different configurations can be compared
+ * before they are rolled out.
+ *
+ * Frames can be binary PGM files (P5, 8-bit), or raw Y800 files named
+ * with their size, e.g. "frame0001-240x720.y800".  An optional configs.plist
+ * in the corpus directory replaces the default configurations; it holds a
+ * dictionary of configuration name to an array of ZBar config strings, as
+ * accepted by ZBarImageScanner's parseConfig:.  Frame recordings (.asefr,
+ * see frameRecording) in the corpus directory contribute all their frames.
+ *
+ * Every scan profile from scanProfiles.plist is benchmarked as well, under
+ * the name "profile:<name>", so the per-frame cost of a restricted profile
+ * can be compared against the all-symbologies default.
+ *
+ * Corpus frames are expected to be dumps of the displayed strip.  The
+ * default profile is also run on just the overlay's target window of each
+ * frame, as "target-window", which reports how many fewer pixels are
+ * scanned and how much faster it is than scanning the whole strip.
+ *
+ * The image kernels from scanKernels.h are timed too, under "kernels": the
+ * SIMD and scalar versions of each are run on the same synthetic frame, and
+ * their outputs are compared byte for byte.
+ *
+ * The target window is scanned through a scanPyramid too, as "pyramid",
+ * which reports its speedup over "target-window" and the hits it gained
+ * (or, if negative, lost) by scanning at half size first.
+ *
+ * The scanline fast path is compared with a full image scan of the
+ * target window under "scanlines": the mean per-frame cost of each path on
+ * its own and of the two combined, and how many frames each decodes.
+ *
+ * Under "orientation", a Code 128 card is drawn into a synthetic strip
+ * the way the camera captures one held in the target brackets, with its
+ * bars along frame rows, and the fast path must decode it.
+ *
+ * The scanGate is tuned under "gate": the target window of every frame is
+ * scanned once, in order as if from the camera, and then the gate is
+ * replayed over the same frames at each pair of GATE_BENCH_SHARPNESS and
+ * GATE_BENCH_MOTION, with motion measured by a scanDensityController as
+ * the scan worker does.  For each pair it reports how many frames were
+ * skipped, how many decodes the skips cost, how long arrivals took to
+ * decode, and the effective cost per frame including the gate itself.  The
+ * cheapest pair that loses no decodes is reported as "tuned" and saved for
+ * the live gate.
+ *
+ * The benchmark is run on request, by switching on "Run scan benchmark" in
+ * the app's Settings, and scans the scan_corpus directory in the
+ * application's Documents directory the next time the app becomes active.
+ * tools/scanBench.c runs the same comparison on a desktop.
+ *
+ */
+
+#import "scanBenchmark.h"
+#import "codeScanner.h"
+#import "cameraView.h"
+#import "JSON.h"
+#import <mach/mach_time.h>
+#import "scanKernels.h"
+#import "frameRecording.h"
+
+/// Size of the synthetic frame the image kernels are timed on
+#define KERNEL_BENCH_WIDTH 1280
+#define KERNEL_BENCH_HEIGHT 720
+/// Times each image kernel is run per measurement
+#define KERNEL_BENCH_ITERATIONS 50
+/// Sharpness thresholds the gate is replayed with
+#define GATE_BENCH_SHARPNESS {0.0, 2.0, 4.0, 6.0, 8.0, 12.0}
+/// Motion thresholds the gate is replayed with
+#define GATE_BENCH_MOTION {12.0, 24.0, 48.0}
+/// Time between corpus frames as seen by the gate, in ms
+#define GATE_BENCH_FRAME_MS (1000.0 / 30.0)
+/// Displayed strip the orientation check draws its card into (iPad)
+#define ORIENTATION_CHECK_WIDTH 240
+#define ORIENTATION_CHECK_HEIGHT 720
+/// Digits on the orientation check's card, an even number of them
+#define ORIENTATION_CHECK_DATA "12345678"
+
+@interface scanBenchmark (PrivateMethods)
+-(NSDictionary*)frameFromPGM: (NSData*)file;
+-(NSDictionary*)frameFromY800: (NSData*)file named: (NSString*)name;
+-(void)benchmarkThread;
+@end
+
+/// Signature shared by the plane-to-plane image kernels
+typedef void (*imageKernel)(const uint8_t*, size_t, uint8_t*, size_t, int, int);
+
+@interface scanBenchmark ()
+/// Loaded frames, each a dictionary with width, height and data
+@property (nonatomic, retain) NSMutableArray *frames;
+@end
+
+/**
+ * \brief Sort comparator for per-frame scan times
+ */
+static int compareDoubles(const void *a, const void *b) {
+  double da = *(const double*)a, db = *(const double*)b;
+  return (da > db) - (da < db);
+}
+
+/// Code 128 bar and space widths, in modules, of each symbol value
+static const char *code128Widths[107] = {
+  "212222", "222122", "222221", "121223", "121322", "131222", "122213", "122312",
+  "132212", "221213", "221312", "231212", "112232", "122132", "122231", "113222",
+  "123122", "123221", "223211", "221132", "221231", "213212", "223112", "312131",
+  "311222", "321122", "321221", "312212", "322112", "322211", "212123", "212321",
+  "232121", "111323", "131123", "131321", "112313", "132113", "132311", "211313",
+  "231113", "231311", "112133", "112331", "132131", "113123", "113321", "133121",
+  "313121", "211331", "231131", "213113", "213311", "213131", "311123", "311321",
+  "331121", "312113", "312311", "332111", "314111", "221411", "431111", "111224",
+  "111422", "121124", "121421", "141122", "141221", "112214", "112412", "122114",
+  "122411", "142112", "142211", "241211", "221114", "413111", "241112", "134111",
+  "111242", "121142", "121241", "114212", "124112", "124211", "411212", "421112",
+  "421211", "212141", "214121", "412121", "111143", "111341", "131141", "114113",
+  "114311", "411113", "411311", "113141", "114131", "311141", "411131", "211412",
+  "211214", "211232", "2331112"
+};
+
+/**
+ * \brief Draw digits as a Code 128 card the way the camera captures one
+ *
+ * The card is held horizontally in the overlay's target brackets, so in
+ * the unrotated frame its bars run along rows, and it reads from the
+ * bottom of the window up (display x maps to frame height - y).  Uses
+ * code set C, so the digits must come in pairs.
+ *
+ * \param plane Greyscale plane, already filled with the background
+ * \param bytesPerRow Row stride of the plane in bytes
+ * \param window Target window, in plane pixels
+ * \param digits Data to encode
+ */
+static void drawCaptureOrientedCard(uint8_t *plane, size_t bytesPerRow, 
+                                    CGRect window, const char *digits) {
+  int values[64], count = 0;
+  values[count++] = 105;    // Start C
+  for (const char *d = digits; d[0] && d[1] && count < 60; d += 2)
+    values[count++] = (d[0] - '0') * 10 + (d[1] - '0');
+  int check = values[0];
+  for (int i = 1; i < count; i++) check += i * values[i];
+  values[count++] = check % 103;
+  values[count++] = 106;    // Stop
+  
+  // Ten modules of quiet zone either side
+  int modules = 20;
+  for (int i = 0; i < count; i++)
+    for (const char *w = code128Widths[values[i]]; *w; w++) 
+      modules += *w - '0';
+  int module = MAX(1, (int)(window.size.height * 0.9) / modules);
+  int left = window.origin.x + window.size.width / 5;
+  int right = window.origin.x + window.size.width * 4 / 5;
+  int y = CGRectGetMaxY(window) - 
+    (window.size.height - modules * module) / 2 - 10 * module;
+  
+  BOOL bar = YES;
+  for (int i = 0; i < count; i++) {
+    for (const char *w = code128Widths[values[i]]; *w; w++, bar = !bar) {
+      int height = (*w - '0') * module;
+      for (int row = y - height; bar && row < y; row++)
+        memset(plane + (size_t)row * bytesPerRow + left, 30, right - left);
+      y -= height;
+    }
+  }
+}
+
+@implementation scanBenchmark
+
+@synthesize corpusPath;
+@synthesize configurations;
+@synthesize frames;
+
+/**
+ * \brief Create a benchmark for the given corpus directory
+ *
+ * \param path Directory containing frames to scan
+ * \return Initialized instance
+ */
+-(id)initWithCorpus: (NSString*)path {
+  if (self = [super init]) {
+    self.corpusPath = path;
+    self.frames = [NSMutableArray array];
+    
+    NSString *configFile = [path stringByAppendingPathComponent: 
+      @"configs.plist"];
+    self.configurations = [NSDictionary dictionaryWithContentsOfFile: 
+      configFile];
+    if (!self.configurations)
+      self.configurations = [scanBenchmark defaultConfigurations];
+  }
+  return self;
+}
+
+-(void)dealloc {
+  [corpusPath release];
+  [configurations release];
+  [frames release];
+  [super dealloc];
+}
+
+/**
+ * \brief Scanner configurations compared when the corpus doesn't specify any
+ * \return Dictionary of configuration name to array of ZBar config strings
+ */
++(NSDictionary*)defaultConfigurations {
+  return [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSArray array], @"default",
+    [NSArray arrayWithObjects: @"x-density=2", @"y-density=2", nil], 
+      @"density-2",
+    [NSArray arrayWithObjects: @"disable", @"code128.enable", nil], 
+      @"code128-only",
+    nil];
+}
+
+/**
+ * \brief Load every readable frame in the corpus directory into memory
+ *
+ * Frames are loaded up front so file I/O is not included in scan times.
+ *
+ * \return Number of frames loaded
+ */
+-(int)loadCorpus {
+  NSFileManager *fileManager = [NSFileManager defaultManager];
+  NSArray *files = [[fileManager contentsOfDirectoryAtPath: self.corpusPath 
+                                 error: nil] 
+    sortedArrayUsingSelector: @selector(compare:)];
+    
+  [self.frames removeAllObjects];
+  for (NSString *name in files) {
+    NSString *ext = [[name pathExtension] lowercaseString];
+    if ([ext isEqualToString: FRAME_RECORDING_EXTENSION]) {
+      frameRecording *recording = [frameRecording recordingWithContentsOfFile: 
+        [self.corpusPath stringByAppendingPathComponent: name]];
+      for (int i = 0; i < recording.frameCount; i++) {
+        [self.frames addObject: [NSDictionary dictionaryWithObjectsAndKeys:
+          [NSNumber numberWithInt: recording.width], @"width",
+          [NSNumber numberWithInt: recording.height], @"height",
+          [recording frameDataAtIndex: i], @"data",
+          nil]];
+      }
+      continue;
+    }
+    NSDictionary *frame = nil;
+    if ([ext isEqualToString: @"pgm"] || [ext isEqualToString: @"y800"]) {
+      NSData *file = [NSData dataWithContentsOfFile: 
+        [self.corpusPath stringByAppendingPathComponent: name]];
+      if ([ext isEqualToString: @"pgm"])
+        frame = [self frameFromPGM: file];
+      else
+        frame = [self frameFromY800: file named: name];
+    }
+    if (frame)
+      [self.frames addObject: frame];
+    else if ([ext isEqualToString: @"pgm"] || [ext isEqualToString: @"y800"])
+      NSLog(@"Scan benchmark: skipping unreadable frame %@", name);
+  }
+  return [self.frames count];
+}
+
+/**
+ * \brief Scan every loaded frame with one scanner configuration
+ *
+ * \param config Array of ZBar config strings applied to a fresh scanner
+ * \return Dictionary of results for this configuration
+ */
+-(NSDictionary*)runConfiguration: (NSArray*)config {
+  ZBarImageScanner *scanner = [[[ZBarImageScanner alloc] init] autorelease];
+  for (NSString *setting in config)
+    [scanner parseConfig: setting];
+  
+  NSMutableDictionary *results = [[[self runScanner: scanner] 
+    mutableCopy] autorelease];
+  [results setObject: config forKey: @"config"];
+  return results;
+}
+
+/**
+ * \brief Scan every loaded frame with an already configured scanner
+ *
+ * \param scanner Scanner to benchmark
+ * \return Dictionary of results for this scanner
+ */
+-(NSDictionary*)runScanner: (ZBarImageScanner*)scanner {
+  return [self runScanner: scanner targetOnly: NO pyramid: nil];
+}
+
+/**
+ * \brief Scan every loaded frame, optionally only inside the target window
+ *
+ * \param scanner Scanner to benchmark
+ * \param target Whether to crop each frame to the overlay's target window
+ * \return Dictionary of results for this scanner
+ */
+-(NSDictionary*)runScanner: (ZBarImageScanner*)scanner targetOnly: (BOOL)target {
+  return [self runScanner: scanner targetOnly: target pyramid: nil];
+}
+
+/**
+ * \brief Scan every loaded frame, optionally through a scanPyramid
+ *
+ * \param scanner Scanner to benchmark
+ * \param target Whether to crop each frame to the overlay's target window
+ * \param pyramid Pyramid to scan each frame through, or nil to scan frames
+ *                at full size
+ * \return Dictionary of results for this scanner
+ */
+-(NSDictionary*)runScanner: (ZBarImageScanner*)scanner 
+                targetOnly: (BOOL)target 
+                pyramid: (scanPyramid*)pyramid {
+  int count = [self.frames count];
+  if (!count) return nil;
+  uint64_t pixels = 0;
+  
+  double *times = malloc(count * sizeof(double));
+  NSMutableDictionary *symbologies = [NSMutableDictionary dictionary];
+  int hits = 0;
+  double total = 0.0;
+  
+  mach_timebase_info_data_t timebase;
+  mach_timebase_info(&timebase);
+  
+  zbar_image_t *zimg = zbar_image_create();
+  zbar_image_set_format(zimg, zbar_fourcc('Y','8','0','0'));
+  ZBarImage *image = [[[ZBarImage alloc] initWithImage: zimg] autorelease];
+  zbar_image_destroy(zimg); // ZBarImage holds its own reference
+  
+  for (int i = 0; i < count; i++) {
+    NSDictionary *frame = [self.frames objectAtIndex: i];
+    NSData *data = [frame objectForKey: @"data"];
+    int width = [[frame objectForKey: @"width"] intValue];
+    int height = [[frame objectForKey: @"height"] intValue];
+    CGRect crop = CGRectMake(0, 0, width, height);
+    if (target)
+      crop = [cameraView targetRectInStrip: crop];
+    zbar_image_set_size(zimg, width, height);
+    zbar_image_set_crop(zimg, crop.origin.x, crop.origin.y, 
+                        crop.size.width, crop.size.height);
+    zbar_image_set_data(zimg, [data bytes], [data length], NULL);
+    pixels += crop.size.width * crop.size.height;
+    
+    uint64_t start = mach_absolute_time();
+    zbar_image_t *decoded = NULL;
+    if (pyramid)
+      decoded = [pyramid scanImage: zimg 
+                         withScanner: [scanner zbarImageScanner]];
+    else if ([scanner scanImage: image] > 0)
+      decoded = zimg;
+    uint64_t elapsed = mach_absolute_time() - start;
+    
+    times[i] = (double)elapsed * timebase.numer / timebase.denom / 1e6;
+    total += times[i];
+    if (!decoded) continue;
+    hits++;
+    
+    const zbar_symbol_t *sym = zbar_image_first_symbol(decoded);
+    for (; sym; sym = zbar_symbol_next(sym)) {
+      NSString *name = [NSString stringWithUTF8String: 
+        zbar_get_symbol_name(zbar_symbol_get_type(sym))];
+      int n = [[symbologies objectForKey: name] intValue];
+      [symbologies setObject: [NSNumber numberWithInt: n + 1] forKey: name];
+    }
+  }
+  zbar_image_set_data(zimg, NULL, 0, NULL);
+  
+  qsort(times, count, sizeof(double), compareDoubles);
+  NSDictionary *results = [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSNumber numberWithInt: count], @"frames",
+    [NSNumber numberWithInt: hits], @"hits",
+    [NSNumber numberWithDouble: (double)hits / count], @"hit_rate",
+    [NSNumber numberWithDouble: total > 0 ? count / (total / 1000.0) : 0],
+      @"frames_per_sec",
+    [NSNumber numberWithDouble: (double)pixels / count], @"pixels_per_frame",
+    [NSNumber numberWithDouble: total / count], @"mean_ms",
+    [NSNumber numberWithDouble: times[count / 2]], @"p50_ms",
+    [NSNumber numberWithDouble: times[(count * 99) / 100]], @"p99_ms",
+    symbologies, @"symbologies",
+    nil];
+  free(times);
+  return results;
+}
+
+/**
+ * \brief Compare the scanline fast path with a full image scan
+ *
+ * Each frame's target window is tried with a scanlineDecoder, and scanned
+ * as an image only if that fails, as the scan worker does.  Every frame is
+ * also scanned as an image alone, for the per-frame cost of each path.
+ *
+ * \param profile Scan profile to configure both paths with
+ * \return Dictionary with the hits and mean per-frame cost of the fast
+ *         path, the image scan, and the two combined
+ */
+-(NSDictionary*)runScanlines: (NSDictionary*)profile {
+  int count = [self.frames count];
+  if (!count) return nil;
+  
+  ZBarImageScanner *scanner = [codeScanner scannerWithProfile: profile];
+  scanlineDecoder *scanlines = [[[scanlineDecoder alloc] 
+    initWithProfile: profile] autorelease];
+  mach_timebase_info_data_t timebase;
+  mach_timebase_info(&timebase);
+  
+  zbar_image_t *zimg = zbar_image_create();
+  zbar_image_set_format(zimg, zbar_fourcc('Y','8','0','0'));
+  ZBarImage *image = [[[ZBarImage alloc] initWithImage: zimg] autorelease];
+  zbar_image_destroy(zimg); // ZBarImage holds its own reference
+  
+  int fastHits = 0, imageHits = 0, combinedHits = 0;
+  double fastTotal = 0.0, imageTotal = 0.0, combinedTotal = 0.0;
+  for (int i = 0; i < count; i++) {
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSDictionary *frame = [self.frames objectAtIndex: i];
+    NSData *data = [frame objectForKey: @"data"];
+    int width = [[frame objectForKey: @"width"] intValue];
+    int height = [[frame objectForKey: @"height"] intValue];
+    CGRect crop = [cameraView targetRectInStrip: 
+      CGRectMake(0, 0, width, height)];
+    zbar_image_set_size(zimg, width, height);
+    zbar_image_set_crop(zimg, crop.origin.x, crop.origin.y, 
+                        crop.size.width, crop.size.height);
+    zbar_image_set_data(zimg, [data bytes], [data length], NULL);
+    
+    uint64_t start = mach_absolute_time();
+    BOOL fast = [scanlines scanImage: zimg offset: CGPointZero] != nil;
+    double fastMs = (double)(mach_absolute_time() - start) * 
+      timebase.numer / timebase.denom / 1e6;
+    
+    start = mach_absolute_time();
+    BOOL full = [scanner scanImage: image] > 0;
+    double imageMs = (double)(mach_absolute_time() - start) * 
+      timebase.numer / timebase.denom / 1e6;
+    
+    fastTotal += fastMs;
+    imageTotal += imageMs;
+    combinedTotal += fast ? fastMs : fastMs + imageMs;
+    if (fast) fastHits++;
+    if (full) imageHits++;
+    if (fast || full) combinedHits++;
+    [pool drain];
+  }
+  zbar_image_set_data(zimg, NULL, 0, NULL);
+  
+  return [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSNumber numberWithInt: count], @"frames",
+    [NSNumber numberWithInt: fastHits], @"scanline_hits",
+    [NSNumber numberWithDouble: fastTotal / count], @"scanline_ms",
+    [NSNumber numberWithInt: imageHits], @"image_hits",
+    [NSNumber numberWithDouble: imageTotal / count], @"image_ms",
+    [NSNumber numberWithInt: combinedHits], @"hits",
+    [NSNumber numberWithDouble: combinedTotal / count], @"mean_ms",
+    [NSNumber numberWithDouble: combinedTotal > 0 ? 
+        imageTotal / combinedTotal : 0], 
+      @"speedup",
+    nil];
+}
+
+/**
+ * \brief Replay the scanGate over the corpus at several pairs of thresholds
+ *
+ * The target window of every frame is scanned once, without a gate, for
+ * its hit and scan time.  Each pair then only runs the gate; a skipped
+ * frame saves its scan time, and loses its decode if it had one.  Frames
+ * are spaced GATE_BENCH_FRAME_MS apart, as if from the camera.
+ *
+ * The pair with the lowest effective cost that loses no decodes is saved
+ * with scanGate's saveTunedSharpness:motion:.
+ *
+ * \param scanner Scanner to scan with
+ * \return Dictionary of thresholds to skip_rate, hits, lost_hits,
+ *         first_decode_ms and effective_ms, plus the ungated baseline and
+ *         the tuned pair
+ */
+-(NSDictionary*)runGate: (ZBarImageScanner*)scanner {
+  int count = [self.frames count];
+  if (!count) return nil;
+  
+  double *times = malloc(count * sizeof(double));
+  BOOL *hits = malloc(count * sizeof(BOOL));
+  if (!times || !hits) {
+    free(times);
+    free(hits);
+    return nil;
+  }
+  
+  mach_timebase_info_data_t timebase;
+  mach_timebase_info(&timebase);
+  uint64_t frameInterval = GATE_BENCH_FRAME_MS * 1e6 * timebase.denom / 
+    timebase.numer;
+  
+  zbar_image_t *zimg = zbar_image_create();
+  zbar_image_set_format(zimg, zbar_fourcc('Y','8','0','0'));
+  ZBarImage *image = [[[ZBarImage alloc] initWithImage: zimg] autorelease];
+  zbar_image_destroy(zimg); // ZBarImage holds its own reference
+  
+  int baselineHits = 0;
+  double baselineTotal = 0.0;
+  for (int i = 0; i < count; i++) {
+    NSDictionary *frame = [self.frames objectAtIndex: i];
+    NSData *data = [frame objectForKey: @"data"];
+    int width = [[frame objectForKey: @"width"] intValue];
+    int height = [[frame objectForKey: @"height"] intValue];
+    CGRect crop = [cameraView targetRectInStrip: 
+      CGRectMake(0, 0, width, height)];
+    zbar_image_set_size(zimg, width, height);
+    zbar_image_set_crop(zimg, crop.origin.x, crop.origin.y, 
+                        crop.size.width, crop.size.height);
+    zbar_image_set_data(zimg, [data bytes], [data length], NULL);
+    
+    uint64_t start = mach_absolute_time();
+    hits[i] = [scanner scanImage: image] > 0;
+    times[i] = (double)(mach_absolute_time() - start) * 
+      timebase.numer / timebase.denom / 1e6;
+    baselineTotal += times[i];
+    if (hits[i]) baselineHits++;
+  }
+  zbar_image_set_data(zimg, NULL, 0, NULL);
+  
+  NSMutableDictionary *results = [NSMutableDictionary dictionary];
+  [results setObject: [NSDictionary dictionaryWithObjectsAndKeys:
+      [NSNumber numberWithInt: baselineHits], @"hits",
+      [NSNumber numberWithDouble: baselineTotal / count], @"effective_ms",
+      nil]
+    forKey: @"off"];
+  
+  const double sharpnesses[] = GATE_BENCH_SHARPNESS;
+  const double motions[] = GATE_BENCH_MOTION;
+  int pairs = sizeof(sharpnesses)/sizeof(*sharpnesses) * 
+    sizeof(motions)/sizeof(*motions);
+  NSDictionary *tuned = nil;
+  double tunedTotal = baselineTotal;
+  for (int t = 0; t < pairs; t++) {
+    scanGate *gate = [[[scanGate alloc] init] autorelease];
+    gate.minSharpness = sharpnesses[t / (sizeof(motions)/sizeof(*motions))];
+    gate.maxMotion = motions[t % (sizeof(motions)/sizeof(*motions))];
+    scanDensityController *density = [[[scanDensityController alloc] init] 
+      autorelease];
+    int gatedHits = 0, lostHits = 0;
+    double total = 0.0;
+    
+    for (int i = 0; i < count; i++) {
+      NSDictionary *frame = [self.frames objectAtIndex: i];
+      const uint8_t *plane = [[frame objectForKey: @"data"] bytes];
+      int width = [[frame objectForKey: @"width"] intValue];
+      int height = [[frame objectForKey: @"height"] intValue];
+      CGRect crop = [cameraView targetRectInStrip: 
+        CGRectMake(0, 0, width, height)];
+      
+      uint64_t start = mach_absolute_time();
+      double motion = [density observeLumaPlane: plane 
+                               bytesPerRow: width 
+                               region: crop];
+      scanGateDecision decision = [gate evaluateLumaPlane: plane 
+                                        bytesPerRow: width 
+                                        region: crop 
+                                        motion: motion 
+                                        time: i * frameInterval];
+      total += (double)(mach_absolute_time() - start) * 
+        timebase.numer / timebase.denom / 1e6;
+      
+      if (decision != SCAN_GATE_SCAN) {
+        if (hits[i]) lostHits++;
+        continue;
+      }
+      total += times[i];
+      if (hits[i]) gatedHits++;
+      [gate scanFinished: hits[i] time: i * frameInterval];
+    }
+    
+    [results setObject: [NSDictionary dictionaryWithObjectsAndKeys:
+        [NSNumber numberWithDouble: (double)[gate skipped] / count], 
+          @"skip_rate",
+        [NSNumber numberWithInt: gate.skippedBlurry], @"skipped_blurry",
+        [NSNumber numberWithInt: gate.skippedMoving], @"skipped_moving",
+        [NSNumber numberWithInt: gate.skippedUnchanged], @"skipped_unchanged",
+        [NSNumber numberWithInt: gatedHits], @"hits",
+        [NSNumber numberWithInt: lostHits], @"lost_hits",
+        [NSNumber numberWithInt: gate.arrivals], @"arrivals",
+        [NSNumber numberWithDouble: [gate meanTimeToFirstDecode]], 
+          @"first_decode_ms",
+        [NSNumber numberWithDouble: total / count], @"effective_ms",
+        nil]
+      forKey: [NSString stringWithFormat: @"sharpness:%g,motion:%g", 
+                gate.minSharpness, gate.maxMotion]];
+    
+    if (!lostHits && total < tunedTotal) {
+      tunedTotal = total;
+      tuned = [NSDictionary dictionaryWithObjectsAndKeys:
+        [NSNumber numberWithDouble: gate.minSharpness], 
+          SCAN_GATE_MIN_SHARPNESS_KEY,
+        [NSNumber numberWithDouble: gate.maxMotion], SCAN_GATE_MAX_MOTION_KEY,
+        nil];
+    }
+  }
+  
+  // Never saved from a corpus nothing decodes in, which would tune nothing
+  if (tuned && baselineHits) {
+    [scanGate saveTunedSharpness: 
+        [[tuned objectForKey: SCAN_GATE_MIN_SHARPNESS_KEY] doubleValue] 
+      motion: [[tuned objectForKey: SCAN_GATE_MAX_MOTION_KEY] doubleValue]];
+    [results setObject: tuned forKey: @"tuned"];
+  }
+  
+  free(times);
+  free(hits);
+  return results;
+}
+
+/**
+ * \brief Time the SIMD image kernels against their scalar references
+ *
+ * Every kernel runs on the same pseudo-random frame, and the outputs of the
+ * two versions must match exactly.
+ *
+ * \return Dictionary of kernel name to scalar_ms, simd_ms, speedup and
+ *         matches, plus the name of the SIMD implementation
+ */
++(NSDictionary*)benchmarkKernels {
+  const int w = KERNEL_BENCH_WIDTH, h = KERNEL_BENCH_HEIGHT;
+  const struct {
+    const char *name;
+    imageKernel simd, scalar;
+    int bytesPerPixel;    // of the source
+    size_t dstStride;
+  } kernels[] = {
+    {"bgra_to_y8", scanBgraToY8, scanBgraToY8Scalar, 4, w},
+    {"downscale_2x", scanDownscale2x, scanDownscale2xScalar, 1, w/2},
+    {"downscale_4x", scanDownscale4x, scanDownscale4xScalar, 1, w/4},
+    {"rotate_90", scanRotate90, scanRotate90Scalar, 1, h},
+  };
+  
+  uint8_t *src = malloc(w * h * 4);
+  uint8_t *simdOut = malloc(w * h);
+  uint8_t *scalarOut = malloc(w * h);
+  NSMutableDictionary *results = [NSMutableDictionary dictionary];
+  if (!src || !simdOut || !scalarOut) {
+    free(src);
+    free(simdOut);
+    free(scalarOut);
+    return results;
+  }
+  
+  mach_timebase_info_data_t timebase;
+  mach_timebase_info(&timebase);
+  
+  srandom(1);
+  for (int i = 0; i < w * h * 4; i++) src[i] = random();
+  
+  for (int k = 0; k < sizeof(kernels)/sizeof(*kernels); k++) {
+    size_t srcStride = w * kernels[k].bytesPerPixel;
+    double ms[2];
+    for (int pass = 0; pass < 2; pass++) {
+      imageKernel fn = pass ? kernels[k].scalar : kernels[k].simd;
+      uint8_t *out = pass ? scalarOut : simdOut;
+      memset(out, 0, w * h);
+      uint64_t start = mach_absolute_time();
+      for (int i = 0; i < KERNEL_BENCH_ITERATIONS; i++)
+        fn(src, srcStride, out, kernels[k].dstStride, w, h);
+      uint64_t elapsed = mach_absolute_time() - start;
+      ms[pass] = (double)elapsed * timebase.numer / timebase.denom / 1e6 / 
+        KERNEL_BENCH_ITERATIONS;
+    }
+    BOOL matches = memcmp(simdOut, scalarOut, w * h) == 0;
+    if (!matches)
+      NSLog(@"Scan benchmark: %s differs from scalar reference", 
+            kernels[k].name);
+    [results setObject: [NSDictionary dictionaryWithObjectsAndKeys:
+        [NSNumber numberWithDouble: ms[1]], @"scalar_ms",
+        [NSNumber numberWithDouble: ms[0]], @"simd_ms",
+        [NSNumber numberWithDouble: ms[0] > 0 ? ms[1] / ms[0] : 0], 
+          @"speedup",
+        [NSNumber numberWithBool: matches], @"matches",
+        nil]
+      forKey: [NSString stringWithUTF8String: kernels[k].name]];
+  }
+  [results setObject: [NSString stringWithUTF8String: 
+      scanKernelsImplementation()] 
+    forKey: @"implementation"];
+  
+  free(src);
+  free(simdOut);
+  free(scalarOut);
+  return results;
+}
+
+/**
+ * \brief Check the scanlineDecoder reads a card in capture orientation
+ *
+ * Draws a Code 128 card into the target window of a synthetic strip, as
+ * the camera captures a card presented as the overlay asks, and runs the
+ * fast path over it.
+ *
+ * \param profile Scan profile that accepts Code 128
+ * \return Dictionary with the expected and decoded data, and whether they
+ *         match
+ */
++(NSDictionary*)checkScanlineOrientation: (NSDictionary*)profile {
+  const int w = ORIENTATION_CHECK_WIDTH, h = ORIENTATION_CHECK_HEIGHT;
+  uint8_t *plane = malloc(w * h);
+  if (!plane) return nil;
+  memset(plane, 220, w * h);
+  CGRect window = [cameraView targetRectInStrip: CGRectMake(0, 0, w, h)];
+  drawCaptureOrientedCard(plane, w, window, ORIENTATION_CHECK_DATA);
+  
+  scanlineDecoder *scanlines = [[[scanlineDecoder alloc] 
+    initWithProfile: profile] autorelease];
+  scanResult *result = [scanlines scanPlane: plane bytesPerRow: w 
+                                  region: window sequence: 0];
+  free(plane);
+  
+  NSString *expected = @ORIENTATION_CHECK_DATA;
+  BOOL matches = [result.data isEqualToString: expected];
+  if (!matches) 
+    NSLog(@"Scanline orientation check FAILED: decoded %@", result.data);
+  return [NSDictionary dictionaryWithObjectsAndKeys:
+    expected, @"expected",
+    result.data ? result.data : @"", @"decoded",
+    [NSNumber numberWithBool: matches], @"matches",
+    nil];
+}
+
+/**
+ * \brief Run every configuration over the corpus
+ *
+ * Results are logged and written to scan_benchmark.json in the Documents 
+ * directory.
+ *
+ * \return Results as a JSON string, or nil if the corpus is empty
+ */
+-(NSString*)run {
+  if (![self.frames count] && ![self loadCorpus]) {
+    NSLog(@"Scan benchmark: no frames in %@", self.corpusPath);
+    return nil;
+  }
+  
+  NSMutableDictionary *results = [NSMutableDictionary dictionary];
+  for (NSString *name in self.configurations) {
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSDictionary *result = [self runConfiguration: 
+      [self.configurations objectForKey: name]];
+    if (result) [results setObject: result forKey: name];
+    [pool drain];
+  }
+  
+  NSDictionary *profiles = [codeScanner scanProfiles];
+  for (NSString *name in profiles) {
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSDictionary *result = [self runScanner: 
+      [codeScanner scannerWithProfile: [profiles objectForKey: name]]];
+    if (result) [results setObject: result 
+                         forKey: [@"profile:" stringByAppendingString: name]];
+    [pool drain];
+  }
+  
+  NSDictionary *strip = [results objectForKey: 
+    [@"profile:" stringByAppendingString: SCAN_PROFILE_DEFAULT]];
+  NSMutableDictionary *window = [[[self runScanner: 
+      [codeScanner scannerWithProfile: 
+        [profiles objectForKey: SCAN_PROFILE_DEFAULT]]
+    targetOnly: YES] mutableCopy] autorelease];
+  if (window && strip && [[window objectForKey: @"mean_ms"] doubleValue] > 0) {
+    [window setObject: [NSNumber numberWithDouble: 
+        [[window objectForKey: @"pixels_per_frame"] doubleValue] / 
+        [[strip objectForKey: @"pixels_per_frame"] doubleValue]]
+      forKey: @"pixel_ratio"];
+    [window setObject: [NSNumber numberWithDouble: 
+        [[strip objectForKey: @"mean_ms"] doubleValue] / 
+        [[window objectForKey: @"mean_ms"] doubleValue]]
+      forKey: @"speedup"];
+    [results setObject: window forKey: @"target-window"];
+  }
+  
+  scanPyramid *pyramid = [[[scanPyramid alloc] init] autorelease];
+  NSMutableDictionary *coarse = [[[self runScanner: 
+      [codeScanner scannerWithProfile: 
+        [profiles objectForKey: SCAN_PROFILE_DEFAULT]]
+    targetOnly: YES pyramid: pyramid] mutableCopy] autorelease];
+  if (coarse && window && [[coarse objectForKey: @"mean_ms"] doubleValue] > 0) {
+    [coarse setObject: [NSNumber numberWithDouble: [pyramid pixelRatio]]
+      forKey: @"pixel_ratio"];
+    [coarse setObject: [NSNumber numberWithDouble: 
+        [[window objectForKey: @"mean_ms"] doubleValue] / 
+        [[coarse objectForKey: @"mean_ms"] doubleValue]]
+      forKey: @"speedup"];
+    [coarse setObject: [NSNumber numberWithInt: 
+        [[coarse objectForKey: @"hits"] intValue] - 
+        [[window objectForKey: @"hits"] intValue]]
+      forKey: @"hits_gained"];
+    [coarse setObject: [NSNumber numberWithInt: pyramid.coarseHits] 
+      forKey: @"coarse_hits"];
+    [coarse setObject: [NSNumber numberWithInt: pyramid.refined] 
+      forKey: @"refined"];
+    [coarse setObject: [NSNumber numberWithInt: pyramid.fullScans] 
+      forKey: @"full_scans"];
+    [results setObject: coarse forKey: @"pyramid"];
+  }
+  
+  NSDictionary *scanlines = [self runScanlines: 
+    [profiles objectForKey: SCAN_PROFILE_DEFAULT]];
+  if (scanlines) [results setObject: scanlines forKey: @"scanlines"];
+  
+  NSDictionary *gate = [self runGate: [codeScanner scannerWithProfile: 
+    [profiles objectForKey: SCAN_PROFILE_DEFAULT]]];
+  if (gate) [results setObject: gate forKey: @"gate"];
+  
+  [results setObject: [scanBenchmark benchmarkKernels] forKey: @"kernels"];
+  NSDictionary *orientation = [scanBenchmark checkScanlineOrientation: 
+    [profiles objectForKey: @"card"]];
+  if (orientation) [results setObject: orientation forKey: @"orientation"];
+  
+  NSString *json = [results JSONRepresentation];
+  NSLog(@"Scan benchmark: %@", json);
+  
+  NSArray *docPaths = NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, 
+                                                          NSUserDomainMask, 
+                                                          YES);
+  NSString *outFile = [[docPaths objectAtIndex: 0] 
+    stringByAppendingPathComponent: SCAN_BENCHMARK_RESULTS];
+  [json writeToFile: outFile atomically: YES 
+        encoding: NSUTF8StringEncoding error: nil];
+  return json;
+}
+
+/**
+ * \brief Run the benchmark on a background thread if one was requested
+ *
+ * Checks, and clears, the Settings switch so each request runs once, then
+ * benchmarks the scan_corpus directory in the application's Documents 
+ * directory without blocking the caller.
+ */
++(void)runInBackgroundIfRequested {
+  NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+  if (![defaults boolForKey: SCAN_BENCHMARK_DEFAULTS_KEY])
+    return;
+  [defaults setBool: NO forKey: SCAN_BENCHMARK_DEFAULTS_KEY];
+  [defaults synchronize];
+  
+	NSArray *docPaths = NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, 
+                                                          NSUserDomainMask, 
+                                                          YES);
+  NSString *path = [[docPaths objectAtIndex: 0] 
+    stringByAppendingPathComponent: SCAN_CORPUS_DIRECTORY];
+  BOOL isDir = NO;
+  if (![[NSFileManager defaultManager] fileExistsAtPath: path 
+                                       isDirectory: &isDir] || !isDir) {
+    NSLog(@"Scan benchmark: no %@ directory in Documents", 
+          SCAN_CORPUS_DIRECTORY);
+    return;
+  }
+  
+  scanBenchmark *bench = [[[scanBenchmark alloc] initWithCorpus: path] 
+    autorelease];
+  [NSThread detachNewThreadSelector: @selector(benchmarkThread) 
+            toTarget: bench 
+            withObject: nil];
+}
+
+@end
+
+@implementation scanBenchmark (PrivateMethods)
+
+/**
+ * \brief Parse a binary 8-bit PGM (P5) file
+ * \param file Contents of the file
+ * \return Frame dictionary, or nil if the file isn't an 8-bit P5 PGM
+ */
+-(NSDictionary*)frameFromPGM: (NSData*)file {
+  const char *bytes = [file bytes];
+  NSUInteger len = [file length];
+  NSUInteger pos = 2;
+  int fields[3];
+  
+  if (len < 2 || bytes[0] != 'P' || bytes[1] != '5') return nil;
+  
+  // Header is width, height and maxval separated by whitespace and comments
+  for (int i = 0; i < 3; i++) {
+    while (pos < len && (isspace(bytes[pos]) || bytes[pos] == '#')) {
+      if (bytes[pos] == '#')
+        while (pos < len && bytes[pos] != '\n') pos++;
+      else
+        pos++;
+    }
+    if (pos >= len || !isdigit(bytes[pos])) return nil;
+    fields[i] = 0;
+    while (pos < len && isdigit(bytes[pos]))
+      fields[i] = fields[i] * 10 + (bytes[pos++] - '0');
+  }
+  pos++; // single whitespace before pixel data
+  
+  int width = fields[0], height = fields[1];
+  if (fields[2] > 255 || width <= 0 || height <= 0 || 
+      len < pos + (NSUInteger)(width * height))
+    return nil;
+  
+  return [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSNumber numberWithInt: width], @"width",
+    [NSNumber numberWithInt: height], @"height",
+    [file subdataWithRange: NSMakeRange(pos, width * height)], @"data",
+    nil];
+}
+
+/**
+ * \brief Wrap a raw Y800 file whose size is given in its name
+ * \param file Contents of the file
+ * \param name Filename, containing WIDTHxHEIGHT before the extension
+ * \return Frame dictionary, or nil if size is missing or doesn't match
+ */
+-(NSDictionary*)frameFromY800: (NSData*)file named: (NSString*)name {
+  NSString *base = [name stringByDeletingPathExtension];
+  NSRange sep = [base rangeOfString: @"-" options: NSBackwardsSearch];
+  NSString *size = sep.location == NSNotFound ? base : 
+    [base substringFromIndex: sep.location + 1];
+  NSArray *dims = [[size lowercaseString] componentsSeparatedByString: @"x"];
+  if ([dims count] != 2) return nil;
+  
+  int width = [[dims objectAtIndex: 0] intValue];
+  int height = [[dims objectAtIndex: 1] intValue];
+  if (width <= 0 || height <= 0 || 
+      [file length] < (NSUInteger)(width * height))
+    return nil;
+  
+  return [NSDictionary dictionaryWithObjectsAndKeys:
+    [NSNumber numberWithInt: width], @"width",
+    [NSNumber numberWithInt: height], @"height",
+    [file subdataWithRange: NSMakeRange(0, width * height)], @"data",
+    nil];
+}
+
+/**
+ * \brief Thread spawned by runInBackgroundIfRequested
+ */
+-(void)benchmarkThread {
+  NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+  [self run];
+  [pool release];
+}
+
+@end
@@ -0,0 +1,51 @@
+//
+//  scanCoalescer.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#import <Foundation/Foundation.h>
+
+/// Seconds a card must be out of view before it can be presented again
+#define SCAN_REARM_TIMEOUT 3.0
+
+
+@interface scanCoalescer : NSObject {
+  NSTimeInterval rearmTimeout;
+  int presentations;
+  int suppressed;
+  
+  @private
+    NSString *currentCode;
+    NSTimeInterval lastSeen;
+}
+
+/// Seconds without seeing a card before it counts as a new presentation
+@property (nonatomic) NSTimeInterval rearmTimeout;
+/// Number of card presentations reported
+@property (nonatomic, readonly) int presentations;
+/// Number of duplicate decodes suppressed
+@property (nonatomic, readonly) int suppressed;
+
+-(BOOL)isNewPresentation: (NSString*)code;
+-(BOOL)isNewPresentation: (NSString*)code atTime: (NSTimeInterval)now;
+-(void)reset;
+
+@end
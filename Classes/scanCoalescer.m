@@ -0,0 +1,103 @@
+//
+//  scanCoalescer.m
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief Collapses repeated decodes of a card into one presentation
+ *
+ * While a card is held in front of the camera, nearly every frame decodes
+ * it.  Each decode that reaches the customer view costs several database
+ * lookups and a log write, so only the first decode of a presentation
+ * should get through.
+ *
+ * A presentation starts when a code is decoded that differs from the
+ * previous one, or when the same code is decoded after not being seen for
+ * rearmTimeout seconds.  Every decode of the same code refreshes the
+ * timeout, so a card that stays in view is never reported twice.
+ *
+ * Not thread safe; call from the scan worker only.
+ *
+ */
+
+#import "scanCoalescer.h"
+
+@interface scanCoalescer ()
+/// Code of the card currently being presented
+@property (nonatomic, retain) NSString *currentCode;
+@end
+
+@implementation scanCoalescer
+
+@synthesize rearmTimeout;
+@synthesize presentations;
+@synthesize suppressed;
+@synthesize currentCode;
+
+-(id)init {
+  if (self = [super init]) {
+    self.rearmTimeout = SCAN_REARM_TIMEOUT;
+  }
+  return self;
+}
+
+-(void)dealloc {
+  [currentCode release];
+  [super dealloc];
+}
+
+/**
+ * \brief Check whether a decode starts a new presentation
+ * \param code Decoded barcode data
+ * \return YES if the decode should be reported, NO if it is a duplicate
+ */
+-(BOOL)isNewPresentation: (NSString*)code {
+  return [self isNewPresentation: code 
+               atTime: [NSDate timeIntervalSinceReferenceDate]];
+}
+
+/**
+ * \brief Check whether a decode at a given time starts a new presentation
+ * \param code Decoded barcode data
+ * \param now Time of the decode, in seconds
+ * \return YES if the decode should be reported, NO if it is a duplicate
+ */
+-(BOOL)isNewPresentation: (NSString*)code atTime: (NSTimeInterval)now {
+  BOOL isDuplicate = [code isEqualToString: self.currentCode] && 
+                     now - lastSeen < self.rearmTimeout;
+  lastSeen = now;
+  if (isDuplicate) {
+    suppressed++;
+    return NO;
+  }
+  
+  self.currentCode = code;
+  presentations++;
+  return YES;
+}
+
+/**
+ * \brief Forget the current presentation, so the next decode is reported
+ */
+-(void)reset {
+  self.currentCode = nil;
+}
+
+@end
@@ -0,0 +1,64 @@
+//
+//  scanDensityController.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+
+/// Scan density used while no card is in view
+#define SCAN_DENSITY_SPARSE 4
+/// Scan density used while a card appears to be arriving
+#define SCAN_DENSITY_DENSE 1
+/// Per-frame scan time (ms) above which density is backed off
+#define SCAN_DENSITY_BUDGET_MS 60.0
+/// Mean luma difference between frames that counts as motion
+#define SCAN_DENSITY_MOTION_THRESHOLD 6.0
+/// Frames to stay dense after the last sign of a card
+#define SCAN_DENSITY_HOLD_FRAMES 15
+/// Samples per side of the grid used to estimate motion
+#define SCAN_DENSITY_GRID 16
+
+
+@interface scanDensityController : NSObject {
+  int density;
+  
+  @private
+    int holdFrames;
+    int cooldownFrames;
+    int overBudgetFrames;
+    BOOL haveSamples;
+    uint8_t samples[SCAN_DENSITY_GRID * SCAN_DENSITY_GRID];
+    double lastMotion;
+    int framesAtDensity[SCAN_DENSITY_SPARSE + 1];
+    int densityChanges;
+}
+
+/// Scanline density the next frame should be scanned with
+@property (nonatomic, readonly) int density;
+
+-(double)observeLumaPlane: (const uint8_t*)plane 
+         bytesPerRow: (size_t)bytesPerRow 
+         region: (CGRect)region;
+-(void)scanFinished: (double)ms found: (BOOL)found partial: (BOOL)partial;
+-(NSString*)summary;
+
+@end
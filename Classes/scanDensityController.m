@@ -0,0 +1,178 @@
+//
+//  scanDensityController.m
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief Chooses how densely ZBar walks scanlines on each frame
+ *
+ * ZBar's X and Y density settings control how many image rows and columns
+ * it scans; a density of N scans every Nth line.  Most frames don't have a
+ * card in them at all, so scanning them sparsely costs little and loses
+ * nothing.  Once something suggests a card is arriving -- motion in the
+ * target window, a decode that isn't confirmed yet, or a full decode -- the
+ * scanner is tightened to every line until things have been quiet for a
+ * while.
+ *
+ * If a frame takes longer than the per-frame budget to scan, density is
+ * backed off one step regardless, and isn't tightened again for a while, so
+ * a busy scene can't back up the scan worker.
+ *
+ * Every density change is logged with the reason and the inputs that
+ * caused it, so the thresholds can be tuned against the scan corpus.
+ *
+ */
+
+#import "scanDensityController.h"
+
+@interface scanDensityController (PrivateMethods)
+-(void)setDensity: (int)newDensity reason: (NSString*)reason scanTime: (double)ms;
+@end
+
+@implementation scanDensityController
+
+@synthesize density;
+
+-(id)init {
+  if (self = [super init]) {
+    density = SCAN_DENSITY_SPARSE;
+  }
+  return self;
+}
+
+/**
+ * \brief Estimate motion in a frame before it is scanned
+ *
+ * Samples a sparse grid over the region and compares it with the samples
+ * from the previous frame.  Motion above threshold tightens the density
+ * for this frame.
+ *
+ * \param plane 8-bit luma plane of the frame, or NULL if not available
+ * \param bytesPerRow Row stride of the plane
+ * \param region Region of the plane to sample
+ * \return Mean absolute luma difference from the previous frame
+ */
+-(double)observeLumaPlane: (const uint8_t*)plane 
+         bytesPerRow: (size_t)bytesPerRow 
+         region: (CGRect)region {
+  if (!plane || region.size.width < SCAN_DENSITY_GRID || 
+      region.size.height < SCAN_DENSITY_GRID) {
+    lastMotion = 0.0;
+    return lastMotion;
+  }
+  
+  int x0 = region.origin.x, y0 = region.origin.y;
+  int dx = region.size.width / SCAN_DENSITY_GRID;
+  int dy = region.size.height / SCAN_DENSITY_GRID;
+  unsigned diff = 0;
+  
+  for (int j = 0; j < SCAN_DENSITY_GRID; j++) {
+    const uint8_t *row = plane + (y0 + j * dy) * bytesPerRow + x0;
+    for (int i = 0; i < SCAN_DENSITY_GRID; i++) {
+      uint8_t v = row[i * dx];
+      uint8_t *prev = &samples[j * SCAN_DENSITY_GRID + i];
+      diff += v > *prev ? v - *prev : *prev - v;
+      *prev = v;
+    }
+  }
+  
+  if (!haveSamples) {
+    haveSamples = YES;
+    lastMotion = 0.0;
+  }
+  else {
+    lastMotion = (double)diff / (SCAN_DENSITY_GRID * SCAN_DENSITY_GRID);
+  }
+  
+  if (lastMotion >= SCAN_DENSITY_MOTION_THRESHOLD && !cooldownFrames) {
+    holdFrames = SCAN_DENSITY_HOLD_FRAMES;
+    if (density != SCAN_DENSITY_DENSE)
+      [self setDensity: SCAN_DENSITY_DENSE reason: @"motion" scanTime: 0.0];
+  }
+  return lastMotion;
+}
+
+/**
+ * \brief Update density from the outcome of the frame just scanned
+ *
+ * \param ms Time taken to scan the frame
+ * \param found Whether a symbol was decoded
+ * \param partial Whether a symbol was seen but not yet confirmed
+ */
+-(void)scanFinished: (double)ms found: (BOOL)found partial: (BOOL)partial {
+  framesAtDensity[density]++;
+  
+  if (ms > SCAN_DENSITY_BUDGET_MS) {
+    overBudgetFrames++;
+    cooldownFrames = SCAN_DENSITY_HOLD_FRAMES;
+    if (density < SCAN_DENSITY_SPARSE) {
+      [self setDensity: density + 1 reason: @"over budget" scanTime: ms];
+    }
+    return;
+  }
+  
+  if (cooldownFrames > 0) {
+    cooldownFrames--;
+  }
+  else if (found || partial) {
+    holdFrames = SCAN_DENSITY_HOLD_FRAMES;
+    if (density != SCAN_DENSITY_DENSE)
+      [self setDensity: SCAN_DENSITY_DENSE 
+            reason: found ? @"decode" : @"partial decode" 
+            scanTime: ms];
+  }
+  else if (holdFrames > 0) {
+    holdFrames--;
+  }
+  else if (density != SCAN_DENSITY_SPARSE) {
+    [self setDensity: SCAN_DENSITY_SPARSE reason: @"idle" scanTime: ms];
+  }
+}
+
+/**
+ * \brief Counters describing the controller's decisions so far
+ * \return One-line summary suitable for the log
+ */
+-(NSString*)summary {
+  NSMutableString *str = [NSMutableString stringWithFormat: 
+    @"density=%d changes=%d over_budget=%d frames_at_density=[", 
+    density, densityChanges, overBudgetFrames];
+  for (int i = SCAN_DENSITY_DENSE; i <= SCAN_DENSITY_SPARSE; i++)
+    [str appendFormat: i == SCAN_DENSITY_DENSE ? @"%d" : @",%d", 
+      framesAtDensity[i]];
+  [str appendString: @"]"];
+  return str;
+}
+
+@end
+
+@implementation scanDensityController (PrivateMethods)
+
+/**
+ * \brief Change density and log why
+ */
+-(void)setDensity: (int)newDensity reason: (NSString*)reason scanTime: (double)ms {
+  NSLog(@"Scan density: %d -> %d (%@) motion=%.1f scan_ms=%.1f", 
+    density, newDensity, reason, lastMotion, ms);
+  density = newDensity;
+  densityChanges++;
+}
+
+@end
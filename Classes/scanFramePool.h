@@ -0,0 +1,66 @@
+//
+//  scanFramePool.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#import <Foundation/Foundation.h>
+#import <CoreVideo/CoreVideo.h>
+#import <CoreGraphics/CoreGraphics.h>
+#import "ZBarSDK.h"
+#import "scanFrameSlots.h"
+
+@class scanFramePool;
+
+/// A pooled video frame, scanned through a zbar_image_t it owns
+typedef struct scanFrame {
+  scanFramePool *pool;      ///< Pool the frame belongs to (not retained)
+  zbar_image_t *image;      ///< Y800 image the frame is scanned through
+  CVImageBufferRef buffer;  ///< Retained pixel buffer, NULL while pooled
+  BOOL locked;              ///< Whether buffer's base address is locked
+  CGRect crop;              ///< Displayed region of the frame
+  CGRect target;            ///< Target window within the displayed region
+  CGPoint offset;           ///< Position in the frame of the image's origin
+  uint64_t submitTime;      ///< mach_absolute_time() when frame was submitted
+} scanFrame;
+
+
+@interface scanFramePool : NSObject {
+  @private
+    scanFrameSlots *slots;
+    scanFrame *frames;
+    int capacity;
+}
+
+/// Number of frames in the pool
+@property (nonatomic, readonly) int capacity;
+/// Number of frames not currently in use
+@property (nonatomic, readonly) int available;
+/// Number of times a frame was wanted but none were free
+@property (nonatomic, readonly) int exhausted;
+
+-(id)initWithCapacity: (int)count;
+-(scanFrame*)acquireFrameForBuffer: (CVImageBufferRef)buffer;
+-(uint8_t*)lumaBufferForFrame: (scanFrame*)frame length: (size_t)length;
+-(void)attachData: (const void*)data length: (size_t)length 
+        toFrame: (scanFrame*)frame;
+-(void)releaseFrame: (scanFrame*)frame;
+
+@end
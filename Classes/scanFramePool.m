@@ -0,0 +1,166 @@
+//
+//  scanFramePool.m
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief Fixed set of reusable frames for the scan worker
+ *
+ * Every frame handed from the camera to the scan worker used to cost a
+ * malloc for the mailbox record, plus the ZBar image and converted data
+ * for the scan.  The pool allocates a fixed number of frames up front, each
+ * with its own zbar_image_t, and hands them out and takes them back without
+ * locks, so steady-state scanning allocates nothing.  The images, their
+ * conversion buffers and the free mask live in scanFrameSlots, a plain C
+ * core that tools/scanFramePoolTest.c checks for allocations on a host.
+ *
+ * A frame's pixel data is attached to its zbar_image_t with a cleanup
+ * handler.  When the data is detached, or ZBar is otherwise done with it,
+ * the handler unlocks and releases the pixel buffer and puts the frame back
+ * in the pool.  Frames are only ever returned that way, or directly
+ * if they were dropped before any data was attached.
+ *
+ * If every frame is in use, acquireFrameForBuffer: returns NULL and the
+ * caller drops the video frame; the camera never waits on the scanner.
+ *
+ * Frames can be acquired and released from any thread.
+ *
+ */
+
+#import "scanFramePool.h"
+
+/**
+ * \brief Release a frame's pixel buffer as its slot is returned
+ *
+ * Called by scanFrameSlots before the slot can be handed out again.
+ */
+static void scanFrameReturn(int slot, void *context) {
+  scanFrame *frame = &((scanFrame*)context)[slot];
+  if (frame->locked)
+    CVPixelBufferUnlockBaseAddress(frame->buffer, 0);
+  CVPixelBufferRelease(frame->buffer);
+  frame->buffer = NULL;
+  frame->locked = NO;
+}
+
+@implementation scanFramePool
+
+@synthesize capacity;
+
+/**
+ * \brief Create a pool with a fixed number of frames
+ *
+ * \param count Number of frames; the most that can be in flight at once,
+ *              up to SCAN_FRAME_SLOTS_MAX
+ * \return Initialized instance
+ */
+-(id)initWithCapacity: (int)count {
+  if (self = [super init]) {
+    frames = calloc(count, sizeof(scanFrame));
+    slots = frames ? scanFrameSlotsCreate(count, scanFrameReturn, frames) : 
+      NULL;
+    if (!slots) {
+      free(frames);
+      frames = NULL;
+      [self release];
+      return nil;
+    }
+    capacity = count;
+    for (int i = 0; i < count; i++) {
+      frames[i].pool = self;
+      frames[i].image = scanFrameSlotsImage(slots, i);
+    }
+  }
+  return self;
+}
+
+-(void)dealloc {
+  // Frames still in use are returned by their cleanup handler here
+  scanFrameSlotsDestroy(slots);
+  free(frames);
+  [super dealloc];
+}
+
+-(int)available {
+  return scanFrameSlotsAvailable(slots);
+}
+
+-(int)exhausted {
+  return scanFrameSlotsExhausted(slots);
+}
+
+/**
+ * \brief Take a free frame for a video frame
+ *
+ * \param buffer Pixel buffer to retain in the frame
+ * \return Frame holding the buffer, or NULL if every frame is in use
+ */
+-(scanFrame*)acquireFrameForBuffer: (CVImageBufferRef)buffer {
+  int slot = scanFrameSlotsAcquire(slots);
+  if (slot < 0) return NULL;
+  scanFrame *frame = &frames[slot];
+  frame->buffer = CVPixelBufferRetain(buffer);
+  frame->locked = NO;
+  return frame;
+}
+
+/**
+ * \brief Conversion buffer of a frame, grown if it is too small
+ *
+ * The buffer is kept when the frame is returned, so it is only allocated
+ * the first time a frame needs it, or when the frame size grows.
+ *
+ * \param frame Frame in use
+ * \param length Bytes needed
+ * \return Buffer of at least length bytes, or NULL if it can't be allocated
+ */
+-(uint8_t*)lumaBufferForFrame: (scanFrame*)frame length: (size_t)length {
+  return scanFrameSlotsLuma(slots, frame - frames, length);
+}
+
+/**
+ * \brief Give a frame's image its pixel data
+ *
+ * The data is not copied.  It must stay valid until the frame is released,
+ * which is what the frame's locked pixel buffer guarantees.
+ *
+ * \param data First byte of Y800 data
+ * \param length Length of the data in bytes
+ * \param frame Frame in use
+ */
+-(void)attachData: (const void*)data length: (size_t)length 
+        toFrame: (scanFrame*)frame {
+  scanFrameSlotsAttach(slots, frame - frames, data, length);
+}
+
+/**
+ * \brief Give a frame back to the pool
+ *
+ * Detaching attached data runs the cleanup handler, which returns the
+ * frame.  A frame with nothing attached is returned directly.
+ *
+ * \param frame Frame in use, or NULL
+ */
+-(void)releaseFrame: (scanFrame*)frame {
+  if (!frame) return;
+  scanFrameSlotsRelease(slots, frame - frames);
+}
+
+@end
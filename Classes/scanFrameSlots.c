@@ -0,0 +1,197 @@
+//
+//  scanFrameSlots.c
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief Fixed set of reusable ZBar images, see scanFrameSlots.h
+ *
+ * A set bit in the free mask is a free slot.  Acquiring clears the lowest
+ * set bit with compare-and-swap, and releasing sets it again, so there is
+ * no list to corrupt and no ABA problem however slots are interleaved.
+ */
+
+#include <stdlib.h>
+#include "scanFrameSlots.h"
+
+typedef struct {
+  scanFrameSlots *set;      ///< Set the slot belongs to
+  int index;                ///< Position of the slot in the set
+  zbar_image_t *image;      ///< Y800 image the slot is scanned through
+  uint8_t *luma;            ///< Conversion buffer for frames with no Y plane
+  size_t lumaCapacity;      ///< Size of luma in bytes
+} scanFrameSlot;
+
+struct scanFrameSlots {
+  scanFrameSlot *slots;
+  int count;
+  scanFrameSlotsReturnFunc returnFunc;
+  void *context;
+  uint32_t freeMask;        ///< Bit n set while slot n is free
+  int32_t exhausted;        ///< Times a slot was wanted and none were free
+};
+
+/**
+ * \brief Hand a slot back to its owner, then mark it free
+ */
+static void returnSlot(scanFrameSlot *slot) {
+  scanFrameSlots *set = slot->set;
+  if (set->returnFunc) set->returnFunc(slot->index, set->context);
+  __atomic_fetch_or(&set->freeMask, 1u << slot->index, __ATOMIC_RELEASE);
+}
+
+/**
+ * \brief ZBar cleanup handler for data attached to a slot's image
+ *
+ * Called by ZBar when the data is replaced or the image is destroyed.
+ */
+static void slotCleanup(zbar_image_t *image) {
+  scanFrameSlot *slot = (scanFrameSlot*)zbar_image_get_userdata(image);
+  if (slot) returnSlot(slot);
+}
+
+/**
+ * \brief Create a set of slots, all free
+ *
+ * \param count Number of slots, at most SCAN_FRAME_SLOTS_MAX
+ * \param returnFunc Called as each slot's data is released, or NULL
+ * \param context Passed to returnFunc
+ * \return New set, or NULL if count is out of range or allocation failed
+ */
+scanFrameSlots *scanFrameSlotsCreate(int count, 
+                                     scanFrameSlotsReturnFunc returnFunc,
+                                     void *context) {
+  scanFrameSlots *set;
+  if (count <= 0 || count > SCAN_FRAME_SLOTS_MAX) return NULL;
+  if (!(set = calloc(1, sizeof(*set)))) return NULL;
+  if (!(set->slots = calloc(count, sizeof(scanFrameSlot)))) {
+    free(set);
+    return NULL;
+  }
+  set->count = count;
+  set->returnFunc = returnFunc;
+  set->context = context;
+  for (int i = 0; i < count; i++) {
+    scanFrameSlot *slot = &set->slots[i];
+    slot->set = set;
+    slot->index = i;
+    slot->image = zbar_image_create();
+    zbar_image_set_format(slot->image, zbar_fourcc('Y','8','0','0'));
+    zbar_image_set_userdata(slot->image, slot);
+  }
+  set->freeMask = count == 32 ? 0xffffffffu : (1u << count) - 1;
+  return set;
+}
+
+/**
+ * \brief Destroy a set
+ *
+ * Slots still holding data are returned through returnFunc first.
+ */
+void scanFrameSlotsDestroy(scanFrameSlots *set) {
+  if (!set) return;
+  for (int i = 0; i < set->count; i++) {
+    zbar_image_destroy(set->slots[i].image);
+    free(set->slots[i].luma);
+  }
+  free(set->slots);
+  free(set);
+}
+
+/**
+ * \brief Take a free slot
+ * \return Slot index, or -1 if every slot is in use
+ */
+int scanFrameSlotsAcquire(scanFrameSlots *set) {
+  uint32_t mask = __atomic_load_n(&set->freeMask, __ATOMIC_ACQUIRE);
+  while (mask) {
+    uint32_t taken = mask & (mask - 1);  // lowest set bit cleared
+    if (__atomic_compare_exchange_n(&set->freeMask, &mask, taken, 1,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+      return __builtin_ctz(mask);
+  }
+  __atomic_fetch_add(&set->exhausted, 1, __ATOMIC_RELAXED);
+  return -1;
+}
+
+/**
+ * \brief Give a slot back
+ *
+ * Detaching attached data runs the cleanup handler, which returns the
+ * slot.  A slot with nothing attached is returned directly.
+ */
+void scanFrameSlotsRelease(scanFrameSlots *set, int slot) {
+  if (slot < 0) return;
+  if (zbar_image_get_data(set->slots[slot].image))
+    zbar_image_set_data(set->slots[slot].image, NULL, 0, NULL);
+  else
+    returnSlot(&set->slots[slot]);
+}
+
+/**
+ * \brief Y800 image a slot is scanned through
+ */
+zbar_image_t *scanFrameSlotsImage(scanFrameSlots *set, int slot) {
+  return set->slots[slot].image;
+}
+
+/**
+ * \brief Conversion buffer of a slot, grown if it is too small
+ *
+ * The buffer is kept when the slot is released, so it is only allocated
+ * the first time a slot needs it, or when the frame size grows.
+ *
+ * \return Buffer of at least length bytes, or NULL if it can't be allocated
+ */
+uint8_t *scanFrameSlotsLuma(scanFrameSlots *set, int slot, size_t length) {
+  scanFrameSlot *s = &set->slots[slot];
+  if (s->lumaCapacity < length) {
+    uint8_t *luma = realloc(s->luma, length);
+    if (!luma) return NULL;
+    s->luma = luma;
+    s->lumaCapacity = length;
+  }
+  return s->luma;
+}
+
+/**
+ * \brief Give a slot's image its pixel data
+ *
+ * The data is not copied.  It must stay valid until the slot is released.
+ */
+void scanFrameSlotsAttach(scanFrameSlots *set, int slot, 
+                          const void *data, size_t length) {
+  zbar_image_set_data(set->slots[slot].image, data, length, slotCleanup);
+}
+
+/**
+ * \brief Number of slots not currently in use
+ */
+int scanFrameSlotsAvailable(scanFrameSlots *set) {
+  return __builtin_popcount(__atomic_load_n(&set->freeMask, 
+                                            __ATOMIC_RELAXED));
+}
+
+/**
+ * \brief Number of times a slot was wanted but none were free
+ */
+int scanFrameSlotsExhausted(scanFrameSlots *set) {
+  return __atomic_load_n(&set->exhausted, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,81 @@
+//
+//  scanFrameSlots.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+///\file
+
+#ifndef SCAN_FRAME_SLOTS_H
+#define SCAN_FRAME_SLOTS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "zbar.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fixed set of reusable ZBar images for the scan worker.
+ *
+ * Each slot owns a Y800 zbar_image_t and a conversion buffer, allocated
+ * once and kept for the life of the set.  Free slots are tracked in one
+ * atomic bitmask, so slots can be acquired and released from any thread
+ * without locks, and steady-state scanning allocates nothing.
+ *
+ * Pixel data attached to a slot's image gets a ZBar cleanup handler.  When
+ * the data is detached, or the image is destroyed, the handler calls the
+ * set's return function for the slot and then marks it free, so the owner
+ * can release whatever held the data before the slot is handed out again.
+ *
+ * This is the plain C core of scanFramePool, so it can be tested on a host
+ * against the system libzbar (tools/scanFramePoolTest.c).
+ */
+
+/// Most slots a set can hold, one per bit of the free mask
+#define SCAN_FRAME_SLOTS_MAX 32
+
+typedef struct scanFrameSlots scanFrameSlots;
+
+/// Called when a slot's data is released, before the slot is reused
+typedef void (*scanFrameSlotsReturnFunc)(int slot, void *context);
+
+scanFrameSlots *scanFrameSlotsCreate(int count, 
+                                     scanFrameSlotsReturnFunc returnFunc,
+                                     void *context);
+void scanFrameSlotsDestroy(scanFrameSlots *slots);
+
+int scanFrameSlotsAcquire(scanFrameSlots *slots);
+void scanFrameSlotsRelease(scanFrameSlots *slots, int slot);
+
+zbar_image_t *scanFrameSlotsImage(scanFrameSlots *slots, int slot);
+uint8_t *scanFrameSlotsLuma(scanFrameSlots *slots, int slot, size_t length);
+void scanFrameSlotsAttach(scanFrameSlots *slots, int slot, 
+                          const void *data, size_t length);
+
+int scanFrameSlotsAvailable(scanFrameSlots *slots);
+int scanFrameSlotsExhausted(scanFrameSlots *slots);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,112 @@
+//
+//  scanGate.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+#import "scanDensityController.h"
+
+/// NSUserDefaults key holding thresholds tuned by the scan benchmark
+#define SCAN_GATE_DEFAULTS_KEY @"ASE_ScanGateThresholds"
+/// Keys of the tuned thresholds dictionary
+#define SCAN_GATE_MIN_SHARPNESS_KEY @"min_sharpness"
+#define SCAN_GATE_MAX_MOTION_KEY @"max_motion"
+/// Mean gradient below which a frame is too blurred to decode, until tuned
+#define SCAN_GATE_MIN_SHARPNESS 6.0
+/// Motion score above which a frame is too blurred by motion, until tuned
+#define SCAN_GATE_MAX_MOTION 24.0
+/// Motion score below which a frame counts as unchanged
+#define SCAN_GATE_STILL_MOTION 1.5
+/// Largest sharpness change for a frame to count as unchanged
+#define SCAN_GATE_STILL_SHARPNESS 1.0
+/// Most frames skipped in a row before one is scanned anyway
+#define SCAN_GATE_MAX_SKIPS 8
+/// Only every Nth row of the region is measured for sharpness
+#define SCAN_GATE_ROW_STEP 4
+/// Motion score that starts timing a card presentation
+#define SCAN_GATE_ARRIVAL_MOTION SCAN_DENSITY_MOTION_THRESHOLD
+/// Seconds after which an undecoded arrival is given up on
+#define SCAN_GATE_ARRIVAL_TIMEOUT 5.0
+
+/// What to do with a frame
+typedef enum {
+  SCAN_GATE_SCAN = 0,         ///< Scan the frame
+  SCAN_GATE_SKIP_BLURRY,      ///< Too little detail to decode
+  SCAN_GATE_SKIP_MOVING,      ///< Too much motion to decode
+  SCAN_GATE_SKIP_UNCHANGED,   ///< Same as a frame that already decoded
+} scanGateDecision;
+
+
+@interface scanGate : NSObject {
+  BOOL enabled;
+  double minSharpness;
+  double maxMotion;
+  double sharpness;
+  double motion;
+  int evaluated;
+  int skippedBlurry;
+  int skippedMoving;
+  int skippedUnchanged;
+  int arrivals;
+  int arrivalsAbandoned;
+  double firstDecodeTotal;
+  
+  @private
+    BOOL lastScanFound;
+    double foundSharpness;
+    int skipsInRow;
+    uint64_t arrivalTime;
+}
+
+/// Whether frames are ever skipped; scores are measured either way
+@property (nonatomic) BOOL enabled;
+/// Mean gradient below which frames are skipped as blurry
+@property (nonatomic) double minSharpness;
+/// Motion score above which frames are skipped as moving
+@property (nonatomic) double maxMotion;
+/// Sharpness of the last frame evaluated
+@property (nonatomic, readonly) double sharpness;
+/// Motion of the last frame evaluated
+@property (nonatomic, readonly) double motion;
+/// Frames evaluated
+@property (nonatomic, readonly) int evaluated;
+/// Frames skipped for each reason
+@property (nonatomic, readonly) int skippedBlurry;
+@property (nonatomic, readonly) int skippedMoving;
+@property (nonatomic, readonly) int skippedUnchanged;
+/// Card arrivals that were timed, and those that never decoded
+@property (nonatomic, readonly) int arrivals;
+@property (nonatomic, readonly) int arrivalsAbandoned;
+
+-(scanGateDecision)evaluateLumaPlane: (const uint8_t*)plane 
+                   bytesPerRow: (size_t)bytesPerRow 
+                   region: (CGRect)region 
+                   motion: (double)motionScore 
+                   time: (uint64_t)machTime;
+-(double)scanFinished: (BOOL)found time: (uint64_t)machTime;
+-(int)skipped;
+-(double)meanTimeToFirstDecode;
+-(NSString*)summary;
+
++(BOOL)saveTunedSharpness: (double)sharpness motion: (double)motion;
+
+@end
@@ -0,0 +1,228 @@
+//
+//  scanGate.m
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief Skips frames that ZBar has no chance of decoding
+ *
+ * While a customer is fumbling a card into view, most frames are blurred
+ * by motion, and ZBar spends a full scan on each without decoding
+ * anything.  The gate checks two cheap scores over the target window
+ * first:
+ *   - sharpness -- mean absolute difference between neighbouring pixels,
+ *                  from the SIMD kernels in scanKernels.h; blur smears bar
+ *                  edges and drives it down
+ *   - motion    -- the scanDensityController's frame difference score,
+ *                  which the scan worker has already measured
+ *
+ * A frame is skipped when it is not sharp enough or moving too much.  It
+ * is also skipped when it is unchanged from a frame that already decoded,
+ * as happens while a card is held still: ZBar would only decode the same
+ * card again.  Only every SCAN_GATE_ROW_STEP-th row is measured for
+ * sharpness.
+ *
+ * After SCAN_GATE_MAX_SKIPS skipped frames in a row one frame is scanned
+ * regardless.  That bounds how long a bad threshold can hide a card, and
+ * keeps a held card refreshing the scanCoalescer well inside its rearm
+ * timeout.
+ *
+ * The gate also times card arrivals: from the first frame with motion
+ * while no card is decoding, to the first decode.  Comparing that time
+ * with the gate enabled and disabled shows what skipping costs in
+ * responsiveness.
+ *
+ * The blur and motion thresholds are tuned on a frame corpus by the "gate"
+ * section of the scan benchmark, which saves the pair that skips the most
+ * work without losing decodes with saveTunedSharpness:motion:.  A new gate
+ * starts with the saved pair, or SCAN_GATE_MIN_SHARPNESS and
+ * SCAN_GATE_MAX_MOTION if the benchmark hasn't run.
+ *
+ * Not thread safe; call from the scan worker only.
+ *
+ */
+
+#import "scanGate.h"
+#import "scanKernels.h"
+#import "scanMetrics.h"
+#import <mach/mach_time.h>
+#import <math.h>
+
+@implementation scanGate
+
+@synthesize enabled;
+@synthesize minSharpness;
+@synthesize maxMotion;
+@synthesize sharpness;
+@synthesize motion;
+@synthesize evaluated;
+@synthesize skippedBlurry;
+@synthesize skippedMoving;
+@synthesize skippedUnchanged;
+@synthesize arrivals;
+@synthesize arrivalsAbandoned;
+
+-(id)init {
+  if (self = [super init]) {
+    self.enabled = YES;
+    self.minSharpness = SCAN_GATE_MIN_SHARPNESS;
+    self.maxMotion = SCAN_GATE_MAX_MOTION;
+    
+    NSDictionary *tuned = [[NSUserDefaults standardUserDefaults] 
+      dictionaryForKey: SCAN_GATE_DEFAULTS_KEY];
+    NSNumber *tunedSharpness = [tuned objectForKey: 
+      SCAN_GATE_MIN_SHARPNESS_KEY];
+    NSNumber *tunedMotion = [tuned objectForKey: SCAN_GATE_MAX_MOTION_KEY];
+    if (tunedSharpness && tunedMotion) {
+      self.minSharpness = [tunedSharpness doubleValue];
+      self.maxMotion = [tunedMotion doubleValue];
+    }
+  }
+  return self;
+}
+
+/**
+ * \brief Score a frame and decide whether it is worth scanning
+ *
+ * \param plane First byte of the greyscale plane
+ * \param bytesPerRow Row stride of the plane in bytes
+ * \param region Region of the plane to measure, normally the target window
+ * \param motionScore Motion over the region, from scanDensityController's
+ *        observeLumaPlane:bytesPerRow:region:
+ * \param machTime mach_absolute_time() when the frame arrived
+ * \return SCAN_GATE_SCAN, or the reason to skip the frame
+ */
+-(scanGateDecision)evaluateLumaPlane: (const uint8_t*)plane 
+                   bytesPerRow: (size_t)bytesPerRow 
+                   region: (CGRect)region 
+                   motion: (double)motionScore 
+                   time: (uint64_t)machTime {
+  evaluated++;
+  region = CGRectIntegral(region);
+  int width = region.size.width, height = region.size.height;
+  if (!plane || width < 2 || height < 2) {
+    sharpness = motion = 0.0;
+    return SCAN_GATE_SCAN;
+  }
+  
+  const uint8_t *origin = plane + (size_t)region.origin.y * bytesPerRow + 
+    (size_t)region.origin.x;
+  sharpness = (double)scanGradientEnergy(origin, bytesPerRow, width, height, 
+                                         SCAN_GATE_ROW_STEP) / 
+    scanGradientSamples(width, height, SCAN_GATE_ROW_STEP);
+  motion = motionScore;
+  
+  // Time card arrivals whether or not frames are being skipped
+  if (arrivalTime && machTimeToMs(machTime - arrivalTime) > 
+      SCAN_GATE_ARRIVAL_TIMEOUT * 1000.0) {
+    arrivalsAbandoned++;
+    arrivalTime = 0;
+  }
+  if (!arrivalTime && !lastScanFound && motion >= SCAN_GATE_ARRIVAL_MOTION)
+    arrivalTime = machTime;
+  
+  scanGateDecision decision = SCAN_GATE_SCAN;
+  if (!self.enabled || skipsInRow >= SCAN_GATE_MAX_SKIPS)
+    decision = SCAN_GATE_SCAN;
+  else if (lastScanFound && motion <= SCAN_GATE_STILL_MOTION &&
+           fabs(sharpness - foundSharpness) <= SCAN_GATE_STILL_SHARPNESS)
+    decision = SCAN_GATE_SKIP_UNCHANGED;
+  else if (sharpness < self.minSharpness)
+    decision = SCAN_GATE_SKIP_BLURRY;
+  else if (motion > self.maxMotion)
+    decision = SCAN_GATE_SKIP_MOVING;
+  
+  switch (decision) {
+    case SCAN_GATE_SKIP_BLURRY: skippedBlurry++; break;
+    case SCAN_GATE_SKIP_MOVING: skippedMoving++; break;
+    case SCAN_GATE_SKIP_UNCHANGED: skippedUnchanged++; break;
+    default: break;
+  }
+  skipsInRow = decision == SCAN_GATE_SCAN ? 0 : skipsInRow + 1;
+  return decision;
+}
+
+/**
+ * \brief Tell the gate the outcome of a frame it let through
+ *
+ * \param found Whether a symbol was decoded
+ * \param machTime mach_absolute_time() when the frame arrived
+ * \return Time from the card's arrival to this decode in ms, or 0 if this
+ *         decode didn't end a timed arrival
+ */
+-(double)scanFinished: (BOOL)found time: (uint64_t)machTime {
+  lastScanFound = found;
+  if (!found) return 0.0;
+  
+  foundSharpness = sharpness;
+  if (!arrivalTime) return 0.0;
+  
+  double ms = machTimeToMs(machTime - arrivalTime);
+  firstDecodeTotal += ms;
+  arrivals++;
+  arrivalTime = 0;
+  return ms;
+}
+
+/**
+ * \brief Frames skipped for any reason
+ */
+-(int)skipped {
+  return skippedBlurry + skippedMoving + skippedUnchanged;
+}
+
+/**
+ * \brief Mean time from a card's arrival to its first decode, in ms
+ */
+-(double)meanTimeToFirstDecode {
+  return arrivals ? firstDecodeTotal / arrivals : 0.0;
+}
+
+/**
+ * \brief Skip counts and arrival timing, for the scan worker's log
+ */
+-(NSString*)summary {
+  return [NSString stringWithFormat: 
+    @"gate %@: %.0f%% of %d frames skipped (%d blurry, %d moving, "
+     "%d unchanged), first decode %.0f ms after arrival (%d timed, "
+     "%d abandoned)",
+    self.enabled ? @"on" : @"off",
+    evaluated ? 100.0 * [self skipped] / evaluated : 0.0, evaluated,
+    skippedBlurry, skippedMoving, skippedUnchanged,
+    [self meanTimeToFirstDecode], arrivals, arrivalsAbandoned];
+}
+
+/**
+ * \brief Save thresholds tuned on a frame corpus, for gates created later
+ *
+ * \param sharpness Mean gradient below which frames are skipped as blurry
+ * \param motion Motion score above which frames are skipped as moving
+ * \return Whether the thresholds were saved
+ */
++(BOOL)saveTunedSharpness: (double)sharpness motion: (double)motion {
+  NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+  [defaults setObject: [NSDictionary dictionaryWithObjectsAndKeys:
+      [NSNumber numberWithDouble: sharpness], SCAN_GATE_MIN_SHARPNESS_KEY,
+      [NSNumber numberWithDouble: motion], SCAN_GATE_MAX_MOTION_KEY, nil]
+    forKey: SCAN_GATE_DEFAULTS_KEY];
+  return [defaults synchronize];
+}
+
+@end
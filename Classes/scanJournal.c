@@ -0,0 +1,365 @@
+//
+//  scanJournal.c
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "scanJournal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+/* Longest record encoding: event, time, customer, fields, four values */
+#define MAX_RECORD_BYTES (1 + 10 + 2 + SCAN_JOURNAL_MAX_BARCODE + 1 + 4 * 5)
+
+struct scanJournal {
+  int fd;
+  pthread_mutex_t mutex;
+  uint64_t startMonotonicUs;
+  uint64_t lastUs;
+  int failed;
+  
+  /* Block being filled, with room for its header in front */
+  uint8_t block[SCAN_JOURNAL_BLOCK_HEADER_BYTES + SCAN_JOURNAL_BLOCK_BYTES];
+  size_t payloadBytes;
+  uint32_t records;
+  uint64_t blockUs;
+};
+
+static uint32_t crcTable[256];
+static pthread_once_t crcTableOnce = PTHREAD_ONCE_INIT;
+
+static void buildCrcTable(void) {
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc >> 1) ^ (crc & 1 ? 0xEDB88320u : 0);
+    crcTable[i] = crc;
+  }
+}
+
+uint32_t scanJournalCrc32(const void *data, size_t length) {
+  pthread_once(&crcTableOnce, buildCrcTable);
+  const uint8_t *bytes = data;
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < length; i++)
+    crc = crcTable[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+  return crc ^ 0xFFFFFFFFu;
+}
+
+static uint64_t monotonicUs(void) {
+#ifdef __APPLE__
+  static mach_timebase_info_data_t timebase;
+  if (!timebase.denom) mach_timebase_info(&timebase);
+  return mach_absolute_time() * timebase.numer / timebase.denom / 1000;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+static void put16(uint8_t *out, uint16_t value) {
+  out[0] = value;
+  out[1] = value >> 8;
+}
+
+static void put32(uint8_t *out, uint32_t value) {
+  for (int i = 0; i < 4; i++) out[i] = value >> (8 * i);
+}
+
+static void put64(uint8_t *out, uint64_t value) {
+  for (int i = 0; i < 8; i++) out[i] = value >> (8 * i);
+}
+
+static uint32_t get32(const uint8_t *in) {
+  return in[0] | in[1] << 8 | in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+static uint64_t get64(const uint8_t *in) {
+  return get32(in) | (uint64_t)get32(in + 4) << 32;
+}
+
+static uint8_t *putVarint(uint8_t *out, uint64_t value) {
+  while (value >= 0x80) {
+    *out++ = (uint8_t)value | 0x80;
+    value >>= 7;
+  }
+  *out++ = (uint8_t)value;
+  return out;
+}
+
+/* NULL if the varint runs past end or past 64 bits */
+static const uint8_t *getVarint(const uint8_t *in, const uint8_t *end, 
+                                uint64_t *value) {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 64 && in < end; shift += 7) {
+    uint8_t byte = *in++;
+    result |= (uint64_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      *value = result;
+      return in;
+    }
+  }
+  return NULL;
+}
+
+static int writeAll(int fd, const uint8_t *bytes, size_t length) {
+  while (length) {
+    ssize_t written = write(fd, bytes, length);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    bytes += written;
+    length -= (size_t)written;
+  }
+  return 0;
+}
+
+/* Write the block being filled, if it has records; called locked */
+static int writeBlock(scanJournal *journal) {
+  if (!journal->records) return 0;
+  uint8_t *header = journal->block;
+  uint8_t *payload = header + SCAN_JOURNAL_BLOCK_HEADER_BYTES;
+  put32(header, (uint32_t)journal->payloadBytes);
+  put32(header + 4, journal->records);
+  put32(header + 8, scanJournalCrc32(payload, journal->payloadBytes));
+  put64(header + 12, journal->blockUs);
+  int result = writeAll(journal->fd, header, 
+    SCAN_JOURNAL_BLOCK_HEADER_BYTES + journal->payloadBytes);
+  if (result) journal->failed = 1;
+  journal->payloadBytes = 0;
+  journal->records = 0;
+  return result;
+}
+
+scanJournal *scanJournalOpen(const char *path) {
+  scanJournal *journal = calloc(1, sizeof(*journal));
+  if (!journal) return NULL;
+  journal->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  uint8_t header[SCAN_JOURNAL_HEADER_BYTES];
+  memcpy(header, SCAN_JOURNAL_MAGIC, 4);
+  put16(header + 4, SCAN_JOURNAL_VERSION);
+  put16(header + 6, SCAN_JOURNAL_HEADER_BYTES);
+  put64(header + 8, (uint64_t)now.tv_sec * 1000000 + now.tv_usec);
+  if (journal->fd < 0 || writeAll(journal->fd, header, sizeof(header))) {
+    if (journal->fd >= 0) close(journal->fd);
+    free(journal);
+    return NULL;
+  }
+  journal->startMonotonicUs = monotonicUs();
+  pthread_mutex_init(&journal->mutex, NULL);
+  return journal;
+}
+
+void scanJournalClose(scanJournal *journal) {
+  if (!journal) return;
+  scanJournalFlush(journal, 1);
+  close(journal->fd);
+  pthread_mutex_destroy(&journal->mutex);
+  free(journal);
+}
+
+int scanJournalAppend(scanJournal *journal, const scanJournalRecord *record) {
+  size_t length = record->barcodeLength;
+  if (length > SCAN_JOURNAL_MAX_BARCODE) length = SCAN_JOURNAL_MAX_BARCODE;
+  
+  // Barcodes are nearly always digits, which pack into a varint; the
+  // length keeps any leading zeros
+  int numeric = length > 0 && length <= 19;
+  uint64_t number = 0;
+  for (size_t i = 0; numeric && i < length; i++) {
+    char c = record->barcode[i];
+    if (c < '0' || c > '9') numeric = 0;
+    else number = number * 10 + (uint64_t)(c - '0');
+  }
+  unsigned fields = record->fields & 
+    (SCAN_JOURNAL_LEVEL | SCAN_JOURNAL_DISCOUNT | 
+     SCAN_JOURNAL_REFERRALS | SCAN_JOURNAL_CREDIT_FIELD);
+  
+  pthread_mutex_lock(&journal->mutex);
+  int result = 0;
+  if (journal->payloadBytes + MAX_RECORD_BYTES > SCAN_JOURNAL_BLOCK_BYTES)
+    result = writeBlock(journal);
+  
+  uint64_t now = monotonicUs() - journal->startMonotonicUs;
+  if (now < journal->lastUs) now = journal->lastUs;
+  if (!journal->records) journal->blockUs = journal->lastUs = now;
+  
+  uint8_t *start = journal->block + SCAN_JOURNAL_BLOCK_HEADER_BYTES + 
+    journal->payloadBytes;
+  uint8_t *out = start;
+  out = putVarint(out, record->event);
+  out = putVarint(out, now - journal->lastUs);
+  out = putVarint(out, (uint64_t)length << 1 | numeric);
+  if (numeric) {
+    out = putVarint(out, number);
+  }
+  else {
+    memcpy(out, record->barcode, length);
+    out += length;
+  }
+  out = putVarint(out, fields);
+  if (fields & SCAN_JOURNAL_LEVEL) out = putVarint(out, record->level);
+  if (fields & SCAN_JOURNAL_DISCOUNT) out = putVarint(out, record->discount);
+  if (fields & SCAN_JOURNAL_REFERRALS) 
+    out = putVarint(out, record->referrals);
+  if (fields & SCAN_JOURNAL_CREDIT_FIELD) out = putVarint(out, record->credit);
+  
+  journal->payloadBytes += (size_t)(out - start);
+  journal->records++;
+  journal->lastUs = now;
+  
+  // A redemption must be on disk as soon as the text log's line is
+  if (record->event == SCAN_JOURNAL_CREDIT) {
+    if (writeBlock(journal) || fsync(journal->fd)) result = -1;
+  }
+  pthread_mutex_unlock(&journal->mutex);
+  return result;
+}
+
+int scanJournalFlush(scanJournal *journal, int sync) {
+  pthread_mutex_lock(&journal->mutex);
+  int result = writeBlock(journal);
+  if (sync && fsync(journal->fd)) result = -1;
+  if (journal->failed) result = -1;
+  pthread_mutex_unlock(&journal->mutex);
+  return result;
+}
+
+int scanJournalReaderInit(scanJournalReader *reader, 
+                          const void *data, size_t length) {
+  memset(reader, 0, sizeof(*reader));
+  const uint8_t *bytes = data;
+  if (length < SCAN_JOURNAL_HEADER_BYTES || 
+      memcmp(bytes, SCAN_JOURNAL_MAGIC, 4))
+    return -1;
+  reader->version = bytes[4] | bytes[5] << 8;
+  size_t headerBytes = bytes[6] | bytes[7] << 8;
+  if (reader->version != SCAN_JOURNAL_VERSION || 
+      headerBytes < SCAN_JOURNAL_HEADER_BYTES || headerBytes > length)
+    return -1;
+  reader->data = bytes;
+  reader->length = length;
+  reader->startUs = get64(bytes + 8);
+  reader->next = headerBytes;
+  return 0;
+}
+
+/* Move to the next block whose CRC checks out; 0 at the end */
+static int nextBlock(scanJournalReader *reader) {
+  while (reader->next < reader->length) {
+    if (reader->length - reader->next < SCAN_JOURNAL_BLOCK_HEADER_BYTES) {
+      reader->truncated = 1;
+      return 0;
+    }
+    const uint8_t *header = reader->data + reader->next;
+    uint32_t payloadBytes = get32(header);
+    if (payloadBytes > reader->length - reader->next - 
+                       SCAN_JOURNAL_BLOCK_HEADER_BYTES) {
+      reader->truncated = 1;
+      return 0;
+    }
+    const uint8_t *payload = header + SCAN_JOURNAL_BLOCK_HEADER_BYTES;
+    reader->next += SCAN_JOURNAL_BLOCK_HEADER_BYTES + payloadBytes;
+    reader->blocks++;
+    if (scanJournalCrc32(payload, payloadBytes) != get32(header + 8)) {
+      reader->badBlocks++;
+      continue;
+    }
+    reader->cursor = payload;
+    reader->blockEnd = payload + payloadBytes;
+    reader->recordsLeft = get32(header + 4);
+    reader->timeUs = get64(header + 12);
+    return 1;
+  }
+  return 0;
+}
+
+/* Decode one record at the cursor; 0 if the encoding is bad */
+static int decodeRecord(scanJournalReader *reader, scanJournalRecord *record) {
+  const uint8_t *in = reader->cursor, *end = reader->blockEnd;
+  uint64_t event, delta, customer, fields, value;
+  if (!(in = getVarint(in, end, &event)) || 
+      !(in = getVarint(in, end, &delta)) || 
+      !(in = getVarint(in, end, &customer)))
+    return 0;
+  
+  size_t length = (size_t)(customer >> 1);
+  if (length > SCAN_JOURNAL_MAX_BARCODE) return 0;
+  if (customer & 1) {
+    if (!(in = getVarint(in, end, &value))) return 0;
+    // Digits back out, right to left, zero-padded to the length
+    for (size_t i = length; i > 0; i--) {
+      record->barcode[i - 1] = (char)('0' + value % 10);
+      value /= 10;
+    }
+  }
+  else {
+    if ((size_t)(end - in) < length) return 0;
+    memcpy(record->barcode, in, length);
+    in += length;
+  }
+  record->barcode[length] = 0;
+  record->barcodeLength = length;
+  
+  if (!(in = getVarint(in, end, &fields))) return 0;
+  record->fields = (unsigned)fields;
+  uint32_t *values[] = { &record->level, &record->discount, 
+                         &record->referrals, &record->credit };
+  for (int i = 0; i < 4; i++) {
+    *values[i] = 0;
+    if (!(fields & (1u << i))) continue;
+    if (!(in = getVarint(in, end, &value))) return 0;
+    *values[i] = (uint32_t)value;
+  }
+  
+  reader->timeUs += delta;
+  record->event = (scanJournalEvent)event;
+  record->timeUs = reader->timeUs;
+  reader->cursor = in;
+  return 1;
+}
+
+int scanJournalNext(scanJournalReader *reader, scanJournalRecord *record) {
+  for (;;) {
+    if (reader->recordsLeft) {
+      reader->recordsLeft--;
+      if (decodeRecord(reader, record)) return 1;
+      // Passed its CRC but doesn't decode; drop the rest of the block
+      reader->badBlocks++;
+      reader->recordsLeft = 0;
+    }
+    if (!nextBlock(reader)) return 0;
+  }
+}
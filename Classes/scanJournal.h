@@ -0,0 +1,175 @@
+//
+//  scanJournal.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#ifndef SCAN_JOURNAL_H
+#define SCAN_JOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Binary journal of scans and redemptions, kept next to the text log.
+ *
+ * File layout, little-endian:
+ *
+ *   header  "ASEJ", u16 version, u16 header bytes, u64 start time
+ *           (microseconds since 1970)
+ *   blocks  u32 payload bytes, u32 records, u32 CRC-32 of the payload,
+ *           u64 time of the first record, then the payload
+ *
+ * Each record in a payload is a run of unsigned LEB128 varints:
+ *
+ *   event, microseconds since the previous record (the first since the
+ *   block's time), customer, field mask, then one value per field set
+ *
+ * Times come from a monotonic clock and count from the start time.  The
+ * customer is (length << 1 | numeric) followed by the barcode as one
+ * varint if it is all digits, or its bytes if not.  A block is decoded on
+ * its own, so one that fails its CRC (a torn write at a crash) costs only
+ * its own records.
+ *
+ * Scans collect in memory and are written a block at a time.  A
+ * redemption commits its block as it is appended, written and fsync()ed
+ * with every record before it, so the journal holds every redemption the
+ * text log made durable.
+ *
+ * A record costs about 10 bytes where its text log line costs about 80.
+ */
+
+#define SCAN_JOURNAL_MAGIC "ASEJ"
+#define SCAN_JOURNAL_VERSION 1
+#define SCAN_JOURNAL_HEADER_BYTES 16
+#define SCAN_JOURNAL_BLOCK_HEADER_BYTES 20
+/// Largest block payload written, in bytes
+#define SCAN_JOURNAL_BLOCK_BYTES 4096
+/// Longest barcode kept, in bytes; longer ones are truncated
+#define SCAN_JOURNAL_MAX_BARCODE 63
+
+typedef enum {
+  SCAN_JOURNAL_SCAN = 1,
+  SCAN_JOURNAL_CREDIT = 2
+} scanJournalEvent;
+
+/// Bits of scanJournalRecord.fields
+enum {
+  SCAN_JOURNAL_LEVEL = 1 << 0,
+  SCAN_JOURNAL_DISCOUNT = 1 << 1,
+  SCAN_JOURNAL_REFERRALS = 1 << 2,
+  SCAN_JOURNAL_CREDIT_FIELD = 1 << 3
+};
+
+typedef struct {
+  scanJournalEvent event;
+  /// Microseconds since the journal's start time
+  uint64_t timeUs;
+  char barcode[SCAN_JOURNAL_MAX_BARCODE + 1];
+  size_t barcodeLength;
+  /// Which of the values below were recorded
+  unsigned fields;
+  uint32_t level;
+  uint32_t discount;
+  uint32_t referrals;
+  uint32_t credit;
+} scanJournalRecord;
+
+typedef struct scanJournal scanJournal;
+
+/**
+ * \brief Create a journal file and write its header
+ *
+ * \param path File to create; replaced if it exists
+ * \return New journal, or NULL if the file couldn't be written
+ */
+scanJournal *scanJournalOpen(const char *path);
+
+/// Write the last block, fsync() and close the file
+void scanJournalClose(scanJournal *journal);
+
+/**
+ * \brief Add a record, stamped with the current time
+ *
+ * Scans collect in memory; a block is written once full, without
+ * fsync().  A SCAN_JOURNAL_CREDIT record is on disk, with everything
+ * before it, when this returns.  Thread safe.
+ *
+ * \param record Record to add; its timeUs is ignored
+ * \return 0 on success, -1 if writing or syncing failed
+ */
+int scanJournalAppend(scanJournal *journal, const scanJournalRecord *record);
+
+/**
+ * \brief Write the records collected so far as a block
+ *
+ * \param sync Nonzero to fsync() the file afterwards
+ * \return 0 on success, -1 if writing failed
+ */
+int scanJournalFlush(scanJournal *journal, int sync);
+
+/// Reads records out of a journal already in memory (or mapped)
+typedef struct {
+  const uint8_t *data;
+  size_t length;
+  uint16_t version;
+  uint64_t startUs;
+  /// Blocks read, and those skipped for a bad CRC or encoding
+  uint64_t blocks;
+  uint64_t badBlocks;
+  /// Nonzero if the file ends partway through a block
+  int truncated;
+  
+  size_t next;
+  const uint8_t *cursor;
+  const uint8_t *blockEnd;
+  uint32_t recordsLeft;
+  uint64_t timeUs;
+} scanJournalReader;
+
+/**
+ * \brief Start reading a journal
+ *
+ * \param data Whole journal file
+ * \param length Bytes of data
+ * \return 0, or -1 if it isn't a journal this version can read
+ */
+int scanJournalReaderInit(scanJournalReader *reader, 
+                          const void *data, size_t length);
+
+/**
+ * \brief Read the next record
+ *
+ * \return 1 with the record filled in, or 0 at the end
+ */
+int scanJournalNext(scanJournalReader *reader, scanJournalRecord *record);
+
+/// CRC-32 (IEEE) of a buffer
+uint32_t scanJournalCrc32(const void *data, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,461 @@
+//
+//  scanKernels.c
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "scanKernels.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SCAN_KERNELS_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SCAN_KERNELS_SSE2 1
+#endif
+
+/* BT.601 luma weights scaled by 256; they sum to 256 so white stays 255 */
+#define LUMA_B 29
+#define LUMA_G 150
+#define LUMA_R 77
+
+const char *scanKernelsImplementation(void) {
+#if defined(SCAN_KERNELS_NEON)
+  return "neon";
+#elif defined(SCAN_KERNELS_SSE2)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+#pragma mark -
+#pragma mark Scalar reference
+
+void scanBgraToY8Scalar(const uint8_t *src, size_t srcStride,
+                        uint8_t *dst, size_t dstStride,
+                        int width, int height) {
+  for (int y = 0; y < height; y++) {
+    const uint8_t *s = src + y*srcStride;
+    uint8_t *d = dst + y*dstStride;
+    for (int x = 0; x < width; x++, s += 4)
+      d[x] = (LUMA_B*s[0] + LUMA_G*s[1] + LUMA_R*s[2] + 128) >> 8;
+  }
+}
+
+void scanDownscale2xScalar(const uint8_t *src, size_t srcStride,
+                           uint8_t *dst, size_t dstStride,
+                           int width, int height) {
+  int w = width/2, h = height/2;
+  for (int y = 0; y < h; y++) {
+    const uint8_t *r0 = src + 2*y*srcStride;
+    const uint8_t *r1 = r0 + srcStride;
+    uint8_t *d = dst + y*dstStride;
+    for (int x = 0; x < w; x++)
+      d[x] = (r0[2*x] + r0[2*x+1] + r1[2*x] + r1[2*x+1] + 2) >> 2;
+  }
+}
+
+void scanDownscale4xScalar(const uint8_t *src, size_t srcStride,
+                           uint8_t *dst, size_t dstStride,
+                           int width, int height) {
+  int w = width/4, h = height/4;
+  for (int y = 0; y < h; y++) {
+    const uint8_t *r = src + 4*y*srcStride;
+    uint8_t *d = dst + y*dstStride;
+    for (int x = 0; x < w; x++) {
+      unsigned sum = 0;
+      for (int j = 0; j < 4; j++) {
+        const uint8_t *s = r + j*srcStride + 4*x;
+        sum += s[0] + s[1] + s[2] + s[3];
+      }
+      d[x] = (sum + 8) >> 4;
+    }
+  }
+}
+
+/* Rotates the source rectangle [x0,x1) x [y0,y1) of a width x height plane */
+static void rotate90Region(const uint8_t *src, size_t srcStride,
+                           uint8_t *dst, size_t dstStride, int height,
+                           int x0, int x1, int y0, int y1) {
+  for (int y = y0; y < y1; y++) {
+    const uint8_t *s = src + y*srcStride;
+    uint8_t *d = dst + (height - 1 - y);
+    for (int x = x0; x < x1; x++)
+      d[x*dstStride] = s[x];
+  }
+}
+
+void scanRotate90Scalar(const uint8_t *src, size_t srcStride,
+                        uint8_t *dst, size_t dstStride,
+                        int width, int height) {
+  rotate90Region(src, srcStride, dst, dstStride, height,
+                 0, width, 0, height);
+}
+
+uint64_t scanGradientEnergyScalar(const uint8_t *src, size_t srcStride,
+                                  int width, int height, int rowStep) {
+  uint64_t sum = 0;
+  if (rowStep < 1) rowStep = 1;
+  for (int y = 0; y + 1 < height; y += rowStep) {
+    const uint8_t *s = src + y*srcStride;
+    const uint8_t *below = s + srcStride;
+    for (int x = 0; x + 1 < width; x++)
+      sum += abs(s[x+1] - s[x]) + abs(below[x] - s[x]);
+  }
+  return sum;
+}
+
+uint64_t scanGradientSamples(int width, int height, int rowStep) {
+  if (width < 2 || height < 2) return 0;
+  if (rowStep < 1) rowStep = 1;
+  uint64_t rows = (height - 2) / rowStep + 1;
+  return rows * (width - 1) * 2;
+}
+
+void scanCrop(const uint8_t *src, size_t srcStride,
+              uint8_t *dst, size_t dstStride,
+              int x, int y, int width, int height, int bytesPerPixel) {
+  /* memcpy is already vectorized by libc; nothing to gain by hand */
+  const uint8_t *s = src + y*srcStride + x*bytesPerPixel;
+  size_t rowBytes = (size_t)width * bytesPerPixel;
+  for (int row = 0; row < height; row++)
+    memcpy(dst + row*dstStride, s + row*srcStride, rowBytes);
+}
+
+#pragma mark -
+#pragma mark SIMD
+
+/*
+ * Each architecture provides the same four static helpers.  The row
+ * helpers return how many output pixels they produced so the caller can
+ * finish the ragged edge with the scalar code, which keeps the output
+ * bit-identical for any size.
+ */
+
+#if defined(SCAN_KERNELS_NEON)
+
+static int bgraRowToY8(const uint8_t *s, uint8_t *d, int width) {
+  uint8x8_t wb = vdup_n_u8(LUMA_B), wg = vdup_n_u8(LUMA_G), wr = vdup_n_u8(LUMA_R);
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    uint8x16x4_t px = vld4q_u8(s + 4*x);
+    uint16x8_t lo = vmull_u8(vget_low_u8(px.val[0]), wb);
+    lo = vmlal_u8(lo, vget_low_u8(px.val[1]), wg);
+    lo = vmlal_u8(lo, vget_low_u8(px.val[2]), wr);
+    uint16x8_t hi = vmull_u8(vget_high_u8(px.val[0]), wb);
+    hi = vmlal_u8(hi, vget_high_u8(px.val[1]), wg);
+    hi = vmlal_u8(hi, vget_high_u8(px.val[2]), wr);
+    vst1q_u8(d + x, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+  }
+  return x;
+}
+
+static int downscale2xRow(const uint8_t *r0, const uint8_t *r1,
+                          uint8_t *d, int w) {
+  int x = 0;
+  for (; x + 8 <= w; x += 8) {
+    uint16x8_t sum = vpaddlq_u8(vld1q_u8(r0 + 2*x));
+    sum = vpadalq_u8(sum, vld1q_u8(r1 + 2*x));
+    vst1_u8(d + x, vrshrn_n_u16(sum, 2));
+  }
+  return x;
+}
+
+static int downscale4xRow(const uint8_t *r, size_t stride, uint8_t *d, int w) {
+  int x = 0;
+  for (; x + 8 <= w; x += 8) {
+    uint16x8_t lo = vdupq_n_u16(0), hi = vdupq_n_u16(0);
+    for (int j = 0; j < 4; j++) {
+      lo = vpadalq_u8(lo, vld1q_u8(r + j*stride + 4*x));
+      hi = vpadalq_u8(hi, vld1q_u8(r + j*stride + 4*x + 16));
+    }
+    uint16x4_t a = vrshrn_n_u32(vpaddlq_u16(lo), 4);
+    uint16x4_t b = vrshrn_n_u32(vpaddlq_u16(hi), 4);
+    vst1_u8(d + x, vmovn_u16(vcombine_u16(a, b)));
+  }
+  return x;
+}
+
+/* src is the top-left of an 8x8 source block, dst the top-left of its
+   rotated position.  Loading the rows bottom-up turns a transpose into a
+   clockwise rotation. */
+static void rotate90Block(const uint8_t *src, size_t srcStride,
+                          uint8_t *dst, size_t dstStride) {
+  uint8x8x2_t t01 = vtrn_u8(vld1_u8(src + 7*srcStride), vld1_u8(src + 6*srcStride));
+  uint8x8x2_t t23 = vtrn_u8(vld1_u8(src + 5*srcStride), vld1_u8(src + 4*srcStride));
+  uint8x8x2_t t45 = vtrn_u8(vld1_u8(src + 3*srcStride), vld1_u8(src + 2*srcStride));
+  uint8x8x2_t t67 = vtrn_u8(vld1_u8(src + 1*srcStride), vld1_u8(src));
+  uint16x4x2_t x02 = vtrn_u16(vreinterpret_u16_u8(t01.val[0]), vreinterpret_u16_u8(t23.val[0]));
+  uint16x4x2_t x13 = vtrn_u16(vreinterpret_u16_u8(t01.val[1]), vreinterpret_u16_u8(t23.val[1]));
+  uint16x4x2_t x46 = vtrn_u16(vreinterpret_u16_u8(t45.val[0]), vreinterpret_u16_u8(t67.val[0]));
+  uint16x4x2_t x57 = vtrn_u16(vreinterpret_u16_u8(t45.val[1]), vreinterpret_u16_u8(t67.val[1]));
+  uint32x2x2_t y04 = vtrn_u32(vreinterpret_u32_u16(x02.val[0]), vreinterpret_u32_u16(x46.val[0]));
+  uint32x2x2_t y26 = vtrn_u32(vreinterpret_u32_u16(x02.val[1]), vreinterpret_u32_u16(x46.val[1]));
+  uint32x2x2_t y15 = vtrn_u32(vreinterpret_u32_u16(x13.val[0]), vreinterpret_u32_u16(x57.val[0]));
+  uint32x2x2_t y37 = vtrn_u32(vreinterpret_u32_u16(x13.val[1]), vreinterpret_u32_u16(x57.val[1]));
+  vst1_u8(dst + 0*dstStride, vreinterpret_u8_u32(y04.val[0]));
+  vst1_u8(dst + 1*dstStride, vreinterpret_u8_u32(y15.val[0]));
+  vst1_u8(dst + 2*dstStride, vreinterpret_u8_u32(y26.val[0]));
+  vst1_u8(dst + 3*dstStride, vreinterpret_u8_u32(y37.val[0]));
+  vst1_u8(dst + 4*dstStride, vreinterpret_u8_u32(y04.val[1]));
+  vst1_u8(dst + 5*dstStride, vreinterpret_u8_u32(y15.val[1]));
+  vst1_u8(dst + 6*dstStride, vreinterpret_u8_u32(y26.val[1]));
+  vst1_u8(dst + 7*dstStride, vreinterpret_u8_u32(y37.val[1]));
+}
+
+/* Sum of |a-b| over n bytes.  Byte sums are flushed from 16-bit to 32-bit
+   lanes every 64 vectors, before they can overflow. */
+static int absDiffRow(const uint8_t *a, const uint8_t *b, int n,
+                      uint64_t *sum) {
+  uint32x4_t total = vdupq_n_u32(0);
+  int x = 0;
+  while (x + 16 <= n) {
+    uint16x8_t part = vdupq_n_u16(0);
+    for (int i = 0; i < 64 && x + 16 <= n; i++, x += 16)
+      part = vpadalq_u8(part, vabdq_u8(vld1q_u8(a + x), vld1q_u8(b + x)));
+    total = vpadalq_u16(total, part);
+  }
+  uint64x2_t wide = vpaddlq_u32(total);
+  *sum += vgetq_lane_u64(wide, 0) + vgetq_lane_u64(wide, 1);
+  return x;
+}
+
+#elif defined(SCAN_KERNELS_SSE2)
+
+/* 4 BGRA pixels to 4 luma values in 32-bit lanes */
+static inline __m128i bgra4ToY(__m128i px, __m128i weights) {
+  __m128i zero = _mm_setzero_si128();
+  __m128 a = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpacklo_epi8(px, zero), weights));
+  __m128 b = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpackhi_epi8(px, zero), weights));
+  __m128i bg = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0)));
+  __m128i ra = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1)));
+  __m128i sum = _mm_add_epi32(_mm_add_epi32(bg, ra), _mm_set1_epi32(128));
+  return _mm_srli_epi32(sum, 8);
+}
+
+static int bgraRowToY8(const uint8_t *s, uint8_t *d, int width) {
+  __m128i weights = _mm_setr_epi16(LUMA_B, LUMA_G, LUMA_R, 0,
+                                   LUMA_B, LUMA_G, LUMA_R, 0);
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    const __m128i *p = (const __m128i *)(s + 4*x);
+    __m128i y0 = bgra4ToY(_mm_loadu_si128(p + 0), weights);
+    __m128i y1 = bgra4ToY(_mm_loadu_si128(p + 1), weights);
+    __m128i y2 = bgra4ToY(_mm_loadu_si128(p + 2), weights);
+    __m128i y3 = bgra4ToY(_mm_loadu_si128(p + 3), weights);
+    __m128i packed = _mm_packus_epi16(_mm_packs_epi32(y0, y1),
+                                      _mm_packs_epi32(y2, y3));
+    _mm_storeu_si128((__m128i *)(d + x), packed);
+  }
+  return x;
+}
+
+/* Sums of horizontally adjacent byte pairs, in 16-bit lanes */
+static inline __m128i pairSums(__m128i v) {
+  return _mm_add_epi16(_mm_and_si128(v, _mm_set1_epi16(0x00ff)),
+                       _mm_srli_epi16(v, 8));
+}
+
+static int downscale2xRow(const uint8_t *r0, const uint8_t *r1,
+                          uint8_t *d, int w) {
+  __m128i round = _mm_set1_epi16(2);
+  int x = 0;
+  for (; x + 16 <= w; x += 16) {
+    const __m128i *a = (const __m128i *)(r0 + 2*x);
+    const __m128i *b = (const __m128i *)(r1 + 2*x);
+    __m128i lo = _mm_add_epi16(pairSums(_mm_loadu_si128(a)),
+                               pairSums(_mm_loadu_si128(b)));
+    __m128i hi = _mm_add_epi16(pairSums(_mm_loadu_si128(a + 1)),
+                               pairSums(_mm_loadu_si128(b + 1)));
+    lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 2);
+    hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 2);
+    _mm_storeu_si128((__m128i *)(d + x), _mm_packus_epi16(lo, hi));
+  }
+  return x;
+}
+
+/* 16 source bytes on each of 4 rows to 4 averaged pixels in 32-bit lanes */
+static inline __m128i quadAverage(const uint8_t *r, size_t stride) {
+  __m128i sum = pairSums(_mm_loadu_si128((const __m128i *)r));
+  for (int j = 1; j < 4; j++)
+    sum = _mm_add_epi16(sum, pairSums(_mm_loadu_si128((const __m128i *)(r + j*stride))));
+  sum = _mm_add_epi32(_mm_and_si128(sum, _mm_set1_epi32(0xffff)),
+                      _mm_srli_epi32(sum, 16));
+  return _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(8)), 4);
+}
+
+static int downscale4xRow(const uint8_t *r, size_t stride, uint8_t *d, int w) {
+  int x = 0;
+  for (; x + 16 <= w; x += 16) {
+    const uint8_t *s = r + 4*x;
+    __m128i packed = _mm_packus_epi16(
+      _mm_packs_epi32(quadAverage(s, stride), quadAverage(s + 16, stride)),
+      _mm_packs_epi32(quadAverage(s + 32, stride), quadAverage(s + 48, stride)));
+    _mm_storeu_si128((__m128i *)(d + x), packed);
+  }
+  return x;
+}
+
+/* src is the top-left of an 8x8 source block, dst the top-left of its
+   rotated position.  Loading the rows bottom-up turns a transpose into a
+   clockwise rotation. */
+static void rotate90Block(const uint8_t *src, size_t srcStride,
+                          uint8_t *dst, size_t dstStride) {
+  __m128i r[8];
+  for (int i = 0; i < 8; i++)
+    r[i] = _mm_loadl_epi64((const __m128i *)(src + (7-i)*srcStride));
+  __m128i t0 = _mm_unpacklo_epi8(r[0], r[1]);
+  __m128i t1 = _mm_unpacklo_epi8(r[2], r[3]);
+  __m128i t2 = _mm_unpacklo_epi8(r[4], r[5]);
+  __m128i t3 = _mm_unpacklo_epi8(r[6], r[7]);
+  __m128i u0 = _mm_unpacklo_epi16(t0, t1);
+  __m128i u1 = _mm_unpackhi_epi16(t0, t1);
+  __m128i u2 = _mm_unpacklo_epi16(t2, t3);
+  __m128i u3 = _mm_unpackhi_epi16(t2, t3);
+  __m128i cols[4] = {
+    _mm_unpacklo_epi32(u0, u2), _mm_unpackhi_epi32(u0, u2),
+    _mm_unpacklo_epi32(u1, u3), _mm_unpackhi_epi32(u1, u3),
+  };
+  for (int i = 0; i < 4; i++) {
+    _mm_storel_epi64((__m128i *)(dst + (2*i)*dstStride), cols[i]);
+    _mm_storel_epi64((__m128i *)(dst + (2*i+1)*dstStride),
+                     _mm_srli_si128(cols[i], 8));
+  }
+}
+
+/* Sum of |a-b| over n bytes */
+static int absDiffRow(const uint8_t *a, const uint8_t *b, int n,
+                      uint64_t *sum) {
+  __m128i total = _mm_setzero_si128();
+  int x = 0;
+  for (; x + 16 <= n; x += 16)
+    total = _mm_add_epi64(total, 
+      _mm_sad_epu8(_mm_loadu_si128((const __m128i *)(a + x)),
+                   _mm_loadu_si128((const __m128i *)(b + x))));
+  *sum += (uint64_t)_mm_cvtsi128_si32(total) + 
+    (uint64_t)_mm_cvtsi128_si32(_mm_srli_si128(total, 8));
+  return x;
+}
+
+#endif
+
+#if defined(SCAN_KERNELS_NEON) || defined(SCAN_KERNELS_SSE2)
+
+void scanBgraToY8(const uint8_t *src, size_t srcStride,
+                  uint8_t *dst, size_t dstStride,
+                  int width, int height) {
+  for (int y = 0; y < height; y++) {
+    const uint8_t *s = src + y*srcStride;
+    uint8_t *d = dst + y*dstStride;
+    int x = bgraRowToY8(s, d, width);
+    scanBgraToY8Scalar(s + 4*x, srcStride, d + x, dstStride, width - x, 1);
+  }
+}
+
+void scanDownscale2x(const uint8_t *src, size_t srcStride,
+                     uint8_t *dst, size_t dstStride,
+                     int width, int height) {
+  int w = width/2, h = height/2;
+  for (int y = 0; y < h; y++) {
+    const uint8_t *r0 = src + 2*y*srcStride;
+    uint8_t *d = dst + y*dstStride;
+    int x = downscale2xRow(r0, r0 + srcStride, d, w);
+    scanDownscale2xScalar(r0 + 2*x, srcStride, d + x, dstStride,
+                          2*(w - x), 2);
+  }
+}
+
+void scanDownscale4x(const uint8_t *src, size_t srcStride,
+                     uint8_t *dst, size_t dstStride,
+                     int width, int height) {
+  int w = width/4, h = height/4;
+  for (int y = 0; y < h; y++) {
+    const uint8_t *r = src + 4*y*srcStride;
+    uint8_t *d = dst + y*dstStride;
+    int x = downscale4xRow(r, srcStride, d, w);
+    scanDownscale4xScalar(r + 4*x, srcStride, d + x, dstStride,
+                          4*(w - x), 4);
+  }
+}
+
+void scanRotate90(const uint8_t *src, size_t srcStride,
+                  uint8_t *dst, size_t dstStride,
+                  int width, int height) {
+  int bw = width & ~7, bh = height & ~7;
+  for (int by = 0; by < bh; by += 8)
+    for (int bx = 0; bx < bw; bx += 8)
+      rotate90Block(src + by*srcStride + bx, srcStride,
+                    dst + bx*dstStride + (height - 8 - by), dstStride);
+  rotate90Region(src, srcStride, dst, dstStride, height,
+                 bw, width, 0, height);
+  rotate90Region(src, srcStride, dst, dstStride, height,
+                 0, bw, bh, height);
+}
+
+uint64_t scanGradientEnergy(const uint8_t *src, size_t srcStride,
+                            int width, int height, int rowStep) {
+  uint64_t sum = 0;
+  if (rowStep < 1) rowStep = 1;
+  for (int y = 0; y + 1 < height; y += rowStep) {
+    const uint8_t *s = src + y*srcStride;
+    // Horizontal neighbours, then vertical; both cover width-1 pixels
+    int x = absDiffRow(s, s + 1, width - 1, &sum);
+    absDiffRow(s, s + srcStride, x, &sum);
+    for (; x + 1 < width; x++)
+      sum += abs(s[x+1] - s[x]) + abs(s[x+srcStride] - s[x]);
+  }
+  return sum;
+}
+
+#else
+
+void scanBgraToY8(const uint8_t *src, size_t srcStride,
+                  uint8_t *dst, size_t dstStride,
+                  int width, int height) {
+  scanBgraToY8Scalar(src, srcStride, dst, dstStride, width, height);
+}
+
+void scanDownscale2x(const uint8_t *src, size_t srcStride,
+                     uint8_t *dst, size_t dstStride,
+                     int width, int height) {
+  scanDownscale2xScalar(src, srcStride, dst, dstStride, width, height);
+}
+
+void scanDownscale4x(const uint8_t *src, size_t srcStride,
+                     uint8_t *dst, size_t dstStride,
+                     int width, int height) {
+  scanDownscale4xScalar(src, srcStride, dst, dstStride, width, height);
+}
+
+void scanRotate90(const uint8_t *src, size_t srcStride,
+                  uint8_t *dst, size_t dstStride,
+                  int width, int height) {
+  scanRotate90Scalar(src, srcStride, dst, dstStride, width, height);
+}
+
+uint64_t scanGradientEnergy(const uint8_t *src, size_t srcStride,
+                            int width, int height, int rowStep) {
+  return scanGradientEnergyScalar(src, srcStride, width, height, rowStep);
+}
+
+#endif
@@ -0,0 +1,127 @@
+//
+//  scanKernels.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#ifndef SCAN_KERNELS_H
+#define SCAN_KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Image kernels on raw 8-bit planes.  Each kernel has a portable scalar
+ * reference version (the *Scalar functions), and the unsuffixed version
+ * dispatches to a NEON or SSE2 implementation when the target supports it.
+ * Both versions produce bit-identical output.
+ *
+ * Strides are in bytes.  Source and destination must not overlap.
+ */
+
+/// Name of the SIMD implementation compiled in: "neon", "sse2" or "scalar"
+const char *scanKernelsImplementation(void);
+
+/**
+ * \brief Convert 32-bit BGRA pixels to 8-bit luma
+ *
+ * Y = (29*B + 150*G + 77*R + 128) >> 8 (BT.601 weights, full range).
+ * Alpha is ignored.
+ */
+void scanBgraToY8(const uint8_t *src, size_t srcStride,
+                  uint8_t *dst, size_t dstStride,
+                  int width, int height);
+void scanBgraToY8Scalar(const uint8_t *src, size_t srcStride,
+                        uint8_t *dst, size_t dstStride,
+                        int width, int height);
+
+/**
+ * \brief Halve a plane in each direction by averaging 2x2 blocks
+ *
+ * Width and height are of the source; the destination is width/2 by
+ * height/2, and an odd last row or column is dropped.
+ */
+void scanDownscale2x(const uint8_t *src, size_t srcStride,
+                     uint8_t *dst, size_t dstStride,
+                     int width, int height);
+void scanDownscale2xScalar(const uint8_t *src, size_t srcStride,
+                           uint8_t *dst, size_t dstStride,
+                           int width, int height);
+
+/**
+ * \brief Quarter a plane in each direction by averaging 4x4 blocks
+ *
+ * Width and height are of the source; the destination is width/4 by
+ * height/4, and leftover rows or columns are dropped.
+ */
+void scanDownscale4x(const uint8_t *src, size_t srcStride,
+                     uint8_t *dst, size_t dstStride,
+                     int width, int height);
+void scanDownscale4xScalar(const uint8_t *src, size_t srcStride,
+                           uint8_t *dst, size_t dstStride,
+                           int width, int height);
+
+/**
+ * \brief Rotate a plane a quarter turn clockwise
+ *
+ * Width and height are of the source; the destination is height pixels
+ * wide and width pixels tall.  Source pixel (x,y) lands at
+ * (height-1-y, x), matching UIImageOrientationRight.
+ */
+void scanRotate90(const uint8_t *src, size_t srcStride,
+                  uint8_t *dst, size_t dstStride,
+                  int width, int height);
+void scanRotate90Scalar(const uint8_t *src, size_t srcStride,
+                        uint8_t *dst, size_t dstStride,
+                        int width, int height);
+
+/**
+ * \brief Gradient energy of a plane, as a measure of sharpness
+ *
+ * Sum of absolute differences between each pixel and its right and lower
+ * neighbours, over every rowStep-th row.  The last row and column only
+ * serve as neighbours.  Divide by scanGradientSamples() for a mean that
+ * doesn't depend on the region size.
+ */
+uint64_t scanGradientEnergy(const uint8_t *src, size_t srcStride,
+                            int width, int height, int rowStep);
+uint64_t scanGradientEnergyScalar(const uint8_t *src, size_t srcStride,
+                                  int width, int height, int rowStep);
+/// Number of differences summed by scanGradientEnergy
+uint64_t scanGradientSamples(int width, int height, int rowStep);
+
+/**
+ * \brief Copy a rectangle out of a plane into a packed buffer
+ *
+ * \param bytesPerPixel 1 for luma planes, 4 for BGRA
+ */
+void scanCrop(const uint8_t *src, size_t srcStride,
+              uint8_t *dst, size_t dstStride,
+              int x, int y, int width, int height, int bytesPerPixel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
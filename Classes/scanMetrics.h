@@ -0,0 +1,105 @@
+//
+//  scanMetrics.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#import <Foundation/Foundation.h>
+#import <libkern/OSAtomic.h>
+
+/// Seconds between histogram dumps to the device log
+#define SCAN_METRICS_DUMP_INTERVAL 60.0
+/// Frames whose stage timestamps are kept at once
+#define SCAN_METRICS_SLOTS 64
+/// Number of latency buckets in each histogram
+#define SCAN_METRICS_BUCKETS 12
+
+/// Points in the scan pipeline that a frame's timestamps are taken at
+typedef enum {
+  SCAN_STAGE_CAPTURED = 0,  ///< Camera delivered the frame
+  SCAN_STAGE_SUBMITTED,     ///< Frame handed to the scan worker
+  SCAN_STAGE_DEQUEUED,      ///< Scan worker picked the frame up
+  SCAN_STAGE_DECODED,       ///< ZBar finished with the frame
+  SCAN_STAGE_NOTIFIED,      ///< Scan notification reached customerInfoView
+  SCAN_STAGE_LOOKED_UP,     ///< Customer database lookups finished
+  SCAN_STAGE_LOGGED,        ///< Scan written to the log
+  SCAN_STAGE_DISPLAYED,     ///< Customer information drawn on screen
+  SCAN_STAGE_COUNT
+} scanStage;
+
+/**
+ * Latency histograms.  The histogram for each stage above holds the time
+ * since the previous stage; the first one holds the end-to-end time
+ * instead, since nothing comes before capture.
+ */
+typedef enum {
+  SCAN_HISTOGRAM_TOTAL = SCAN_STAGE_CAPTURED,  ///< Capture to display
+  SCAN_HISTOGRAM_CONVERT = SCAN_STAGE_COUNT,   ///< Conversion to Y800
+  SCAN_HISTOGRAM_PREVIEW,                      ///< Rendering the preview
+  SCAN_HISTOGRAM_FIRST_DECODE,                 ///< Card arrival to decode
+  SCAN_HISTOGRAM_SCAN,                         ///< Scan work on one frame
+  SCAN_HISTOGRAM_COUNT
+} scanHistogram;
+
+/// Fixed-bucket latency histogram
+typedef struct {
+  uint32_t buckets[SCAN_METRICS_BUCKETS];  ///< Counts per bucket
+  uint32_t count;                          ///< Samples recorded
+  double total;                            ///< Sum of samples in ms
+  double max;                              ///< Largest sample in ms
+} scanLatencyHistogram;
+
+/// Timestamps of one frame, indexed by scanStage
+typedef struct {
+  unsigned sequence;
+  uint64_t stamps[SCAN_STAGE_COUNT];
+} scanFrameStamps;
+
+/// Convert a mach_absolute_time() interval to milliseconds
+double machTimeToMs(uint64_t elapsed);
+
+
+@interface scanMetrics : NSObject {
+  @private
+    OSSpinLock lock;
+    scanFrameStamps frames[SCAN_METRICS_SLOTS];
+    scanLatencyHistogram histograms[SCAN_HISTOGRAM_COUNT];
+    volatile int32_t dropped;
+    volatile int32_t overBudget;
+    uint64_t lastDump;
+}
+
++(scanMetrics*)sharedMetrics;
+
+-(void)frame: (unsigned)sequence reachedStage: (scanStage)stage;
+-(void)frame: (unsigned)sequence reachedStage: (scanStage)stage 
+        atTime: (uint64_t)machTime;
+-(void)record: (double)ms inHistogram: (scanHistogram)histogram;
+-(void)recordSince: (uint64_t)machStart inHistogram: (scanHistogram)histogram;
+-(void)frameDropped;
+-(void)frameOverBudget;
+-(scanLatencyHistogram)histogram: (scanHistogram)histogram;
+-(int)droppedFrames;
+-(int)overBudgetFrames;
+-(NSString*)summary;
+-(void)dump;
+-(void)reset;
+
+@end
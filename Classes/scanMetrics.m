@@ -0,0 +1,269 @@
+//
+//  scanMetrics.m
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief Per-stage latency histograms for the scan pipeline
+ *
+ * A scan passes through the camera, the scan worker, ZBar, the scan
+ * notification, the customer lookups, the log and finally the screen.
+ * When a scan feels slow, these histograms say which of those the time
+ * went into.
+ *
+ * Each stage records a mach_absolute_time() timestamp for a frame, keyed
+ * by the frame's ZBar image sequence number.  The time since the frame's
+ * previous stage goes into that stage's histogram, and when a frame is
+ * displayed the time since capture goes into the end-to-end histogram.
+ * Frames that never decode a new card stop at SCAN_STAGE_DECODED.  Only
+ * the last SCAN_METRICS_SLOTS frames are tracked, so a slot is reused long
+ * after its frame could still be in flight.
+ *
+ * Durations that are not between two stages, like image conversion, are
+ * recorded directly with record:inHistogram:.
+ *
+ * Histograms have fixed buckets, so recording is constant time and never
+ * allocates.  Every SCAN_METRICS_DUMP_INTERVAL seconds they are written to
+ * the device log.
+ *
+ * Thread safe; stages are recorded from the camera queue, the scan worker
+ * and the main thread.
+ *
+ */
+
+#import "scanMetrics.h"
+#import <mach/mach_time.h>
+#import <math.h>
+
+/// Upper bounds of the histogram buckets in ms; the last is unbounded
+static const double bucketLimits[SCAN_METRICS_BUCKETS] = {
+  1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, INFINITY
+};
+
+/// Log names of the histograms, indexed by scanHistogram
+static NSString * const histogramNames[SCAN_HISTOGRAM_COUNT] = {
+  @"total", @"submit", @"queue", @"zbar", @"notify", @"lookup", @"log", 
+  @"draw", @"convert", @"preview", @"first_decode", @"scan"
+};
+
+/**
+ * \brief Convert a mach_absolute_time() interval to milliseconds
+ *
+ * Shared by every scan stage that times itself.
+ */
+double machTimeToMs(uint64_t elapsed) {
+  static mach_timebase_info_data_t timebase;
+  if (timebase.denom == 0) mach_timebase_info(&timebase);
+  return (double)elapsed * timebase.numer / timebase.denom / 1e6;
+}
+
+/**
+ * \brief Add a sample to a histogram
+ */
+static void addSample(scanLatencyHistogram *histogram, double ms) {
+  int bucket = 0;
+  while (ms > bucketLimits[bucket]) bucket++;
+  histogram->buckets[bucket]++;
+  histogram->count++;
+  histogram->total += ms;
+  if (ms > histogram->max) histogram->max = ms;
+}
+
+/**
+ * \brief Upper bound of the bucket holding the given fraction of samples
+ */
+static double bucketPercentile(const scanLatencyHistogram *histogram, 
+                               double fraction) {
+  uint32_t seen = 0;
+  for (int i = 0; i < SCAN_METRICS_BUCKETS; i++) {
+    seen += histogram->buckets[i];
+    if (seen >= fraction * histogram->count) return bucketLimits[i];
+  }
+  return INFINITY;
+}
+
+@implementation scanMetrics
+
+/**
+ * \brief Metrics shared by the whole scan pipeline
+ */
++(scanMetrics*)sharedMetrics {
+  static scanMetrics *shared = nil;
+  @synchronized(self) {
+    if (!shared) shared = [[scanMetrics alloc] init];
+  }
+  return shared;
+}
+
+-(id)init {
+  if (self = [super init]) {
+    lock = OS_SPINLOCK_INIT;
+    lastDump = mach_absolute_time();
+  }
+  return self;
+}
+
+/**
+ * \brief Record that a frame reached a stage now
+ *
+ * \param sequence ZBar image sequence number of the frame; 0 is ignored
+ * \param stage Stage the frame reached
+ */
+-(void)frame: (unsigned)sequence reachedStage: (scanStage)stage {
+  [self frame: sequence reachedStage: stage atTime: mach_absolute_time()];
+}
+
+/**
+ * \brief Record that a frame reached a stage at a given time
+ *
+ * \param sequence ZBar image sequence number of the frame; 0 is ignored
+ * \param stage Stage the frame reached
+ * \param machTime mach_absolute_time() when it reached the stage
+ */
+-(void)frame: (unsigned)sequence reachedStage: (scanStage)stage 
+        atTime: (uint64_t)machTime {
+  if (!sequence) return;
+  
+  OSSpinLockLock(&lock);
+  scanFrameStamps *slot = &frames[sequence % SCAN_METRICS_SLOTS];
+  if (slot->sequence != sequence) {
+    memset(slot, 0, sizeof(*slot));
+    slot->sequence = sequence;
+  }
+  slot->stamps[stage] = machTime;
+  
+  if (stage > SCAN_STAGE_CAPTURED && slot->stamps[stage - 1])
+    addSample(&histograms[stage], 
+              machTimeToMs(machTime - slot->stamps[stage - 1]));
+  if (stage == SCAN_STAGE_DISPLAYED && slot->stamps[SCAN_STAGE_CAPTURED])
+    addSample(&histograms[SCAN_HISTOGRAM_TOTAL], 
+              machTimeToMs(machTime - slot->stamps[SCAN_STAGE_CAPTURED]));
+  
+  BOOL dumpDue = machTimeToMs(machTime - lastDump) > 
+    SCAN_METRICS_DUMP_INTERVAL * 1000.0;
+  if (dumpDue) lastDump = machTime;
+  OSSpinLockUnlock(&lock);
+  
+  if (dumpDue) [self dump];
+}
+
+/**
+ * \brief Record a duration that isn't the gap between two stages
+ *
+ * \param ms Duration in milliseconds
+ * \param histogram Histogram to add it to
+ */
+-(void)record: (double)ms inHistogram: (scanHistogram)histogram {
+  OSSpinLockLock(&lock);
+  addSample(&histograms[histogram], ms);
+  OSSpinLockUnlock(&lock);
+}
+
+/**
+ * \brief Record the time from a start point until now
+ *
+ * \param machStart mach_absolute_time() at the start of the duration
+ * \param histogram Histogram to add it to
+ */
+-(void)recordSince: (uint64_t)machStart inHistogram: (scanHistogram)histogram {
+  [self record: machTimeToMs(mach_absolute_time() - machStart) 
+        inHistogram: histogram];
+}
+
+/**
+ * \brief Count a camera frame that was dropped without being scanned
+ */
+-(void)frameDropped {
+  OSAtomicIncrement32(&dropped);
+}
+
+/**
+ * \brief Count a frame whose scan ran past the scan worker's time budget
+ */
+-(void)frameOverBudget {
+  OSAtomicIncrement32(&overBudget);
+}
+
+/**
+ * \brief Copy of one histogram
+ */
+-(scanLatencyHistogram)histogram: (scanHistogram)histogram {
+  OSSpinLockLock(&lock);
+  scanLatencyHistogram copy = histograms[histogram];
+  OSSpinLockUnlock(&lock);
+  return copy;
+}
+
+-(int)droppedFrames {
+  return dropped;
+}
+
+-(int)overBudgetFrames {
+  return overBudget;
+}
+
+/**
+ * \brief One line per non-empty histogram, plus the frame counts
+ *
+ * Each line has the sample count, mean, max, the buckets holding the
+ * median and 99th percentile, and the count in every bucket by its upper
+ * bound in ms.
+ */
+-(NSString*)summary {
+  scanLatencyHistogram copy[SCAN_HISTOGRAM_COUNT];
+  OSSpinLockLock(&lock);
+  memcpy(copy, histograms, sizeof(copy));
+  OSSpinLockUnlock(&lock);
+  
+  NSMutableString *summary = [NSMutableString stringWithFormat: 
+    @"%d frames dropped, %d over budget", dropped, overBudget];
+  for (int i = 0; i < SCAN_HISTOGRAM_COUNT; i++) {
+    scanLatencyHistogram *h = &copy[i];
+    if (!h->count) continue;
+    [summary appendFormat: @"\n%@: n=%u mean=%.1fms max=%.1fms "
+                           "p50<=%gms p99<=%gms buckets", 
+      histogramNames[i], h->count, h->total / h->count, h->max,
+      bucketPercentile(h, 0.5), bucketPercentile(h, 0.99)];
+    for (int b = 0; b < SCAN_METRICS_BUCKETS; b++)
+      [summary appendFormat: @" <=%g:%u", bucketLimits[b], h->buckets[b]];
+  }
+  return summary;
+}
+
+/**
+ * \brief Write the histograms to the device log
+ */
+-(void)dump {
+  NSLog(@"Scan metrics: %@", [self summary]);
+}
+
+/**
+ * \brief Clear all histograms, timestamps and counts
+ */
+-(void)reset {
+  OSSpinLockLock(&lock);
+  memset(frames, 0, sizeof(frames));
+  memset(histograms, 0, sizeof(histograms));
+  dropped = 0;
+  overBudget = 0;
+  OSSpinLockUnlock(&lock);
+}
+
+@end
@@ -0,0 +1,69 @@
+//
+//  scanPyramid.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#import <Foundation/Foundation.h>
+#import "ZBarSDK.h"
+
+/// Smallest crop side, in pixels, that is scanned coarse first
+#define SCAN_PYRAMID_MIN_SIZE 64
+/// Symbol quality below which a coarse decode is confirmed at full size
+#define SCAN_PYRAMID_MIN_QUALITY 2
+/// Pixels of full-size margin scanned around a coarse symbol
+#define SCAN_PYRAMID_MARGIN 24
+/// Frames without any coarse symbol between full-size scans
+#define SCAN_PYRAMID_FULL_INTERVAL 4
+
+
+@interface scanPyramid : NSObject {
+  BOOL enabled;
+  int frames;
+  int coarseHits;
+  int refined;
+  int fullScans;
+  uint64_t pixelsScanned;
+  uint64_t fullPixels;
+  
+  @private
+    zbar_image_t *coarse;
+    uint8_t *coarseData;
+    size_t coarseCapacity;
+    int sinceFullScan;
+}
+
+/// Whether the coarse pass is used; if not, images are scanned as they are
+@property (nonatomic) BOOL enabled;
+/// Images scanned
+@property (nonatomic, readonly) int frames;
+/// Images decoded by the coarse pass alone
+@property (nonatomic, readonly) int coarseHits;
+/// Full-size scans restricted to the area around a coarse symbol
+@property (nonatomic, readonly) int refined;
+/// Full-size scans of the whole crop
+@property (nonatomic, readonly) int fullScans;
+
+-(zbar_image_t*)scanImage: (zbar_image_t*)image 
+                withScanner: (zbar_image_scanner_t*)scanner;
+-(double)pixelRatio;
+-(NSString*)summary;
+
+@end
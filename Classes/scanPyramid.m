@@ -0,0 +1,225 @@
+//
+//  scanPyramid.m
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief Scans an image at half size first, and at full size only if needed
+ *
+ * Most frames have no card in them, and most cards decode fine at half
+ * resolution, yet ZBar was scanning every frame at full capture size.  The
+ * pyramid scans a 2x-downscaled copy of the image's crop first, a quarter
+ * of the pixels.  It goes back to the full-size image only when:
+ *   - the coarse pass found a symbol it wasn't sure of: one the scanner's
+ *     cache hasn't confirmed, or decoded by fewer than
+ *     SCAN_PYRAMID_MIN_QUALITY scanlines.  Only the symbol's area, plus
+ *     SCAN_PYRAMID_MARGIN, is scanned at full size.
+ *   - the coarse pass found nothing for SCAN_PYRAMID_FULL_INTERVAL frames
+ *     in a row, so fine barcodes that don't survive the downscale still
+ *     decode within a few frames.
+ *
+ * Both passes use the same scanner, and so the same configuration and
+ * cache.  The caller's image keeps its data; only its crop is changed
+ * during a refined scan, and it is restored afterwards.
+ *
+ * Not thread safe; each scan thread needs its own pyramid.
+ *
+ */
+
+#import "scanPyramid.h"
+#import "scanKernels.h"
+
+@interface scanPyramid (PrivateMethods)
+-(zbar_image_t*)scanFine: (zbar_image_t*)image 
+                withScanner: (zbar_image_scanner_t*)scanner 
+                around: (const zbar_symbol_t*)symbols;
+@end
+
+@implementation scanPyramid
+
+@synthesize enabled;
+@synthesize frames;
+@synthesize coarseHits;
+@synthesize refined;
+@synthesize fullScans;
+
+-(id)init {
+  if (self = [super init]) {
+    coarse = zbar_image_create();
+    zbar_image_set_format(coarse, zbar_fourcc('Y','8','0','0'));
+    self.enabled = YES;
+  }
+  return self;
+}
+
+-(void)dealloc {
+  zbar_image_destroy(coarse);
+  free(coarseData);
+  [super dealloc];
+}
+
+/**
+ * \brief Scan a Y800 image, coarse first
+ *
+ * \param image Image with data attached and its crop set
+ * \param scanner Scanner to scan with
+ * \return The image holding the decoded symbols, which is either the
+ *         caller's image or the pyramid's coarse one, or NULL if nothing
+ *         decoded.  Coarse symbols stay valid until the next scan.
+ */
+-(zbar_image_t*)scanImage: (zbar_image_t*)image 
+                withScanner: (zbar_image_scanner_t*)scanner {
+  frames++;
+  unsigned x, y, width, height;
+  zbar_image_get_crop(image, &x, &y, &width, &height);
+  unsigned stride = zbar_image_get_width(image);
+  const uint8_t *data = zbar_image_get_data(image);
+  fullPixels += width * height;
+  
+  size_t length = (width / 2) * (height / 2);
+  if (!self.enabled || !data || width < SCAN_PYRAMID_MIN_SIZE || 
+      height < SCAN_PYRAMID_MIN_SIZE) {
+    pixelsScanned += width * height;
+    return zbar_scan_image(scanner, image) > 0 ? image : NULL;
+  }
+  if (coarseCapacity < length) {
+    uint8_t *grown = realloc(coarseData, length);
+    if (!grown) {
+      pixelsScanned += width * height;
+      return zbar_scan_image(scanner, image) > 0 ? image : NULL;
+    }
+    coarseData = grown;
+    coarseCapacity = length;
+  }
+  
+  // Coarse pass over the whole crop at half size
+  scanDownscale2x(data + (size_t)y * stride + x, stride, 
+                  coarseData, width / 2, width, height);
+  zbar_image_set_size(coarse, width / 2, height / 2);
+  zbar_image_set_crop(coarse, 0, 0, width / 2, height / 2);
+  zbar_image_set_data(coarse, coarseData, length, NULL);
+  zbar_image_set_sequence(coarse, zbar_image_get_sequence(image));
+  pixelsScanned += length;
+  int decoded = zbar_scan_image(scanner, coarse);
+  
+  const zbar_symbol_t *sym = zbar_symbol_set_first_symbol(
+    zbar_image_scanner_get_results(scanner));
+  if (!sym) {
+    if (++sinceFullScan < SCAN_PYRAMID_FULL_INTERVAL) return NULL;
+    sinceFullScan = 0;
+    fullScans++;
+    pixelsScanned += width * height;
+    return zbar_scan_image(scanner, image) > 0 ? image : NULL;
+  }
+  sinceFullScan = 0;
+  
+  BOOL certain = decoded > 0;
+  for (; sym; sym = zbar_symbol_next(sym)) {
+    if (zbar_symbol_get_count(sym) < 0 || 
+        zbar_symbol_get_quality(sym) < SCAN_PYRAMID_MIN_QUALITY)
+      certain = NO;
+  }
+  if (certain) {
+    coarseHits++;
+    return coarse;
+  }
+  
+  // Confirm what the coarse pass saw; keep its decode if that fails
+  zbar_image_t *fine = [self scanFine: image withScanner: scanner 
+                             around: zbar_symbol_set_first_symbol(
+                               zbar_image_scanner_get_results(scanner))];
+  if (fine) return fine;
+  if (decoded > 0) {
+    coarseHits++;
+    return coarse;
+  }
+  return NULL;
+}
+
+/**
+ * \brief Fraction of the full-size pixels actually scanned
+ */
+-(double)pixelRatio {
+  return fullPixels ? (double)pixelsScanned / fullPixels : 0.0;
+}
+
+/**
+ * \brief Pass counts, for the scan worker's log
+ */
+-(NSString*)summary {
+  return [NSString stringWithFormat: 
+    @"pyramid %@: %d coarse decodes, %d refined and %d full scans in "
+     "%d frames, %.0f%% of pixels scanned",
+    self.enabled ? @"on" : @"off", coarseHits, refined, fullScans, frames,
+    100.0 * [self pixelRatio]];
+}
+
+@end
+
+@implementation scanPyramid (PrivateMethods)
+
+/**
+ * \brief Scan the full-size image around the symbols a coarse pass found
+ *
+ * The coarse scan's results are consumed before the fine scan replaces
+ * them.
+ *
+ * \param image Full-size image
+ * \param scanner Scanner that just scanned the coarse image
+ * \param symbols First coarse symbol
+ * \return The image if anything decoded, otherwise NULL
+ */
+-(zbar_image_t*)scanFine: (zbar_image_t*)image 
+                withScanner: (zbar_image_scanner_t*)scanner 
+                around: (const zbar_symbol_t*)symbols {
+  unsigned x, y, width, height;
+  zbar_image_get_crop(image, &x, &y, &width, &height);
+  
+  // Bounding box of every coarse symbol, in full-size pixels
+  int minX = width, minY = height, maxX = 0, maxY = 0;
+  for (const zbar_symbol_t *sym = symbols; sym; sym = zbar_symbol_next(sym)) {
+    for (unsigned i = 0; i < zbar_symbol_get_loc_size(sym); i++) {
+      int px = zbar_symbol_get_loc_x(sym, i) * 2;
+      int py = zbar_symbol_get_loc_y(sym, i) * 2;
+      minX = MIN(minX, px);
+      minY = MIN(minY, py);
+      maxX = MAX(maxX, px + 1);
+      maxY = MAX(maxY, py + 1);
+    }
+  }
+  minX = MAX(minX - SCAN_PYRAMID_MARGIN, 0);
+  minY = MAX(minY - SCAN_PYRAMID_MARGIN, 0);
+  maxX = MIN(maxX + SCAN_PYRAMID_MARGIN, (int)width);
+  maxY = MIN(maxY + SCAN_PYRAMID_MARGIN, (int)height);
+  if (maxX <= minX || maxY <= minY) {
+    minX = minY = 0;
+    maxX = width;
+    maxY = height;
+  }
+  
+  refined++;
+  pixelsScanned += (maxX - minX) * (maxY - minY);
+  zbar_image_set_crop(image, x + minX, y + minY, maxX - minX, maxY - minY);
+  int decoded = zbar_scan_image(scanner, image);
+  zbar_image_set_crop(image, x, y, width, height);
+  return decoded > 0 ? image : NULL;
+}
+
+@end
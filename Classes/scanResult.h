@@ -0,0 +1,61 @@
+//
+//  scanResult.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+#import "ZBarSDK.h"
+
+
+@interface scanResult : NSObject {
+  @private
+    NSString *data;
+    zbar_symbol_type_t symbology;
+    int quality;
+    CGRect location;
+    unsigned sequence;
+}
+
+/// Decoded barcode contents
+@property (nonatomic, readonly) NSString *data;
+/// ZBar symbology the barcode was decoded as
+@property (nonatomic, readonly) zbar_symbol_type_t symbology;
+/// Name of the symbology, e.g. "EAN-13"
+@property (nonatomic, readonly) NSString *typeName;
+/// ZBar's quality score; for linear codes, scanlines that decoded it
+@property (nonatomic, readonly) int quality;
+/// Bounding box of the barcode, in pixels of the unrotated frame
+@property (nonatomic, readonly) CGRect location;
+/// Sequence number of the frame it was decoded from, or 0
+@property (nonatomic, readonly) unsigned sequence;
+
+-(id)initWithData: (NSString*)code 
+     symbology: (zbar_symbol_type_t)type 
+     quality: (int)score 
+     location: (CGRect)bounds 
+     sequence: (unsigned)frameSequence;
++(scanResult*)bestOfSymbols: (ZBarSymbolSet*)symbols 
+              scale: (CGFloat)scale 
+              offset: (CGPoint)offset 
+              sequence: (unsigned)frameSequence;
+
+@end
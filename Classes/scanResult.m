@@ -0,0 +1,113 @@
+//
+//  scanResult.m
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief One decoded barcode, as handed from the scanner to its consumers
+ *
+ * Results are immutable, so any thread can hold and read one without
+ * locking.  The scanner publishes at most one per frame, the best symbol
+ * decoded in it, through a scanResultRing.
+ *
+ */
+
+#import "scanResult.h"
+
+@implementation scanResult
+
+@synthesize data;
+@synthesize symbology;
+@synthesize quality;
+@synthesize location;
+@synthesize sequence;
+
+/**
+ * \brief Create a result
+ *
+ * \param code Decoded contents; copied
+ * \param type Symbology it was decoded as
+ * \param score ZBar's quality score
+ * \param bounds Bounding box in pixels of the unrotated frame
+ * \param frameSequence Sequence number of the frame, or 0
+ * \return Initialized instance
+ */
+-(id)initWithData: (NSString*)code 
+     symbology: (zbar_symbol_type_t)type 
+     quality: (int)score 
+     location: (CGRect)bounds 
+     sequence: (unsigned)frameSequence {
+  if (self = [super init]) {
+    data = [code copy];
+    symbology = type;
+    quality = score;
+    location = bounds;
+    sequence = frameSequence;
+  }
+  return self;
+}
+
+-(void)dealloc {
+  [data release];
+  [super dealloc];
+}
+
+-(NSString*)typeName {
+  return [ZBarSymbol nameForType: symbology];
+}
+
+-(NSString*)description {
+  return [NSString stringWithFormat: @"%@ %@ (quality %d, frame %u)", 
+    self.typeName, data, quality, sequence];
+}
+
+/**
+ * \brief Pick the symbol to report from everything decoded in a frame
+ *
+ * The highest quality symbol wins; on a tie, the first one ZBar reported.
+ *
+ * \param symbols Symbols decoded from the frame
+ * \param scale Pixels of the frame per pixel of the scanned image
+ * \param offset Position in the frame of the scanned image's origin
+ * \param frameSequence Sequence number of the frame, or 0
+ * \return Autoreleased result, or nil if nothing decoded
+ */
++(scanResult*)bestOfSymbols: (ZBarSymbolSet*)symbols 
+              scale: (CGFloat)scale 
+              offset: (CGPoint)offset 
+              sequence: (unsigned)frameSequence {
+  ZBarSymbol *best = nil;
+  for (ZBarSymbol *symbol in symbols) {
+    if (!best || symbol.quality > best.quality) best = symbol;
+  }
+  if (!best) return nil;
+  
+  CGRect bounds = best.bounds;
+  bounds = CGRectMake(offset.x + bounds.origin.x * scale, 
+                      offset.y + bounds.origin.y * scale,
+                      bounds.size.width * scale, bounds.size.height * scale);
+  return [[[scanResult alloc] initWithData: best.data 
+                              symbology: best.type 
+                              quality: best.quality 
+                              location: bounds 
+                              sequence: frameSequence] autorelease];
+}
+
+@end
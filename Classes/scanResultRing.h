@@ -0,0 +1,64 @@
+//
+//  scanResultRing.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+#import "scanResult.h"
+
+/// Results kept for readers to catch up on; must be a power of two
+#define SCAN_RESULT_RING_SIZE 16
+/// Longest barcode contents, in UTF-8 bytes, that can be published
+#define SCAN_RESULT_MAX_DATA 512
+
+/// A published result, copied in and out of the ring by value
+typedef struct {
+  volatile uint32_t version;        ///< Odd while being written
+  uint32_t length;                  ///< Bytes of data used
+  char data[SCAN_RESULT_MAX_DATA];  ///< UTF-8 contents, not terminated
+  zbar_symbol_type_t symbology;     ///< Symbology decoded as
+  int quality;                      ///< ZBar quality score
+  CGRect location;                  ///< Bounding box in the frame
+  unsigned sequence;                ///< Frame sequence number
+} scanResultSlot;
+
+
+@interface scanResultRing : NSObject {
+  @private
+    scanResultSlot slots[SCAN_RESULT_RING_SIZE];
+    volatile uint32_t published;
+    volatile int32_t overruns;
+    int32_t oversized;
+}
+
+/// Results published so far; a new reader starts its cursor here
+@property (nonatomic, readonly) uint32_t published;
+/// Results readers missed because the writer lapped them
+@property (nonatomic, readonly) int overruns;
+/// Results too long to publish
+@property (nonatomic, readonly) int oversized;
+
+-(BOOL)publish: (scanResult*)result;
+-(scanResult*)nextResult: (uint32_t*)cursor;
+-(scanResult*)latestResult;
+
+@end
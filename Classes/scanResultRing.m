@@ -0,0 +1,177 @@
+//
+//  scanResultRing.m
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief Hands scan results from the scan worker to any number of readers
+ *
+ * The scanner used to store each decode in a mutable lastCode property,
+ * which the notification handlers read from whatever thread they ran on
+ * while the next frame was overwriting it.  Now results are published into
+ * this ring, and each reader keeps its own cursor into it; a reader sees
+ * every result in order, and readers never block the writer or each other.
+ *
+ * There must only ever be one writer at a time.  Each slot is a seqlock:
+ * the writer makes the slot's version odd, copies the result in by value,
+ * then makes the version even again.  A reader copies the slot out and
+ * keeps the copy only if the version was the one it expected both before
+ * and after.  Results are stored by value, not as objects, so a reader
+ * can never touch an object the writer has already released.
+ *
+ * A reader that falls more than SCAN_RESULT_RING_SIZE results behind
+ * skips ahead to the oldest result still in the ring, and the results it
+ * missed are counted as overruns.
+ *
+ */
+
+#import "scanResultRing.h"
+#import <libkern/OSAtomic.h>
+
+@interface scanResultRing (PrivateMethods)
+-(BOOL)readSlot: (uint32_t)index into: (scanResultSlot*)copy;
+@end
+
+@implementation scanResultRing
+
+-(uint32_t)published {
+  return published;
+}
+
+-(int)overruns {
+  return overruns;
+}
+
+-(int)oversized {
+  return oversized;
+}
+
+/**
+ * \brief Publish a result to every reader
+ *
+ * Only one thread may publish at a time.
+ *
+ * \param result Result to publish; copied into the ring
+ * \return NO if its data is longer than SCAN_RESULT_MAX_DATA
+ */
+-(BOOL)publish: (scanResult*)result {
+  const char *utf8 = [result.data UTF8String];
+  size_t length = utf8 ? strlen(utf8) : 0;
+  if (length > SCAN_RESULT_MAX_DATA) {
+    oversized++;
+    return NO;
+  }
+  
+  uint32_t index = published;
+  scanResultSlot *slot = &slots[index & (SCAN_RESULT_RING_SIZE - 1)];
+  slot->version = 2 * index + 1;
+  OSMemoryBarrier();
+  slot->length = length;
+  memcpy(slot->data, utf8, length);
+  slot->symbology = result.symbology;
+  slot->quality = result.quality;
+  slot->location = result.location;
+  slot->sequence = result.sequence;
+  OSMemoryBarrier();
+  slot->version = 2 * index + 2;
+  OSMemoryBarrier();
+  published = index + 1;
+  return YES;
+}
+
+/**
+ * \brief Read the next result after a reader's cursor
+ *
+ * \param cursor Reader's position, advanced past the result returned;
+ *               start it at published to only see future results
+ * \return Autoreleased result, or nil if the reader is up to date
+ */
+-(scanResult*)nextResult: (uint32_t*)cursor {
+  scanResultSlot copy;
+  for (;;) {
+    uint32_t head = published;
+    OSMemoryBarrier();
+    uint32_t index = *cursor;
+    if (index == head) return nil;
+    if (head - index > SCAN_RESULT_RING_SIZE) {
+      OSAtomicAdd32(head - index - SCAN_RESULT_RING_SIZE, &overruns);
+      index = head - SCAN_RESULT_RING_SIZE;
+    }
+    
+    *cursor = index + 1;
+    if ([self readSlot: index into: &copy]) break;
+    // Overwritten while reading; the writer has moved on past it
+    OSAtomicIncrement32(&overruns);
+  }
+  
+  NSString *code = [[[NSString alloc] initWithBytes: copy.data 
+                                      length: copy.length 
+                                      encoding: NSUTF8StringEncoding] 
+    autorelease];
+  return [[[scanResult alloc] initWithData: code 
+                              symbology: copy.symbology 
+                              quality: copy.quality 
+                              location: copy.location 
+                              sequence: copy.sequence] autorelease];
+}
+
+/**
+ * \brief Read the most recently published result, without a cursor
+ *
+ * \return Autoreleased result, or nil if nothing has been published
+ */
+-(scanResult*)latestResult {
+  for (;;) {
+    uint32_t head = published;
+    if (!head) return nil;
+    uint32_t cursor = head - 1;
+    scanResult *result = [self nextResult: &cursor];
+    if (result) return result;
+  }
+}
+
+@end
+
+@implementation scanResultRing (PrivateMethods)
+
+/**
+ * \brief Copy a slot out of the ring if it still holds the given result
+ *
+ * \param index Result to read
+ * \param copy Filled in with the slot's contents
+ * \return NO if the slot has been, or is being, overwritten
+ */
+-(BOOL)readSlot: (uint32_t)index into: (scanResultSlot*)copy {
+  scanResultSlot *slot = &slots[index & (SCAN_RESULT_RING_SIZE - 1)];
+  uint32_t version = slot->version;
+  OSMemoryBarrier();
+  if (version != 2 * index + 2) return NO;
+  
+  copy->length = MIN(slot->length, (uint32_t)SCAN_RESULT_MAX_DATA);
+  memcpy(copy->data, slot->data, copy->length);
+  copy->symbology = slot->symbology;
+  copy->quality = slot->quality;
+  copy->location = slot->location;
+  copy->sequence = slot->sequence;
+  OSMemoryBarrier();
+  return slot->version == version;
+}
+
+@end
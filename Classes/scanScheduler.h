@@ -0,0 +1,69 @@
+//
+//  scanScheduler.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+#import "ZBarSDK.h"
+#import "scanPyramid.h"
+
+/// Scan time allowed per frame in ms, inside the camera's frame interval
+#define SCAN_SCHEDULER_BUDGET_MS 80.0
+/// Most bands a region is split into
+#define SCAN_SCHEDULER_MAX_BANDS 4
+/// Columns each band overlaps its neighbours by
+#define SCAN_SCHEDULER_OVERLAP 16
+/// Weight of the newest sample in the cost estimate
+#define SCAN_SCHEDULER_SMOOTHING 0.2
+
+
+@interface scanScheduler : NSObject {
+  double budget;
+  int frames;
+  int overBudget;
+  int carried;
+  
+  @private
+    int bands;
+    int nextBand;
+    double msPerPixel;
+}
+
+/// Scan time allowed per frame, in ms
+@property (nonatomic) double budget;
+/// Bands the region is currently split into; 1 when it fits the budget
+@property (nonatomic, readonly) int bands;
+/// Frames scanned
+@property (nonatomic, readonly) int frames;
+/// Frames whose scan ran past the budget
+@property (nonatomic, readonly) int overBudget;
+/// Frames that left bands for the next frame
+@property (nonatomic, readonly) int carried;
+
+-(zbar_image_t*)scanImage: (zbar_image_t*)image 
+                withPyramid: (scanPyramid*)pyramid 
+                scanner: (zbar_image_scanner_t*)scanner 
+                started: (uint64_t)machStart 
+                origin: (CGPoint*)origin;
+-(NSString*)summary;
+
+@end
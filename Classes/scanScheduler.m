@@ -0,0 +1,154 @@
+//
+//  scanScheduler.m
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief Keeps each frame's scan inside a time budget
+ *
+ * On older iPads one image scan of a cluttered frame can take longer than
+ * the camera's frame interval, and frames back up behind it.  The
+ * scheduler keeps a running estimate of scan cost per pixel.  When the
+ * whole region would not fit in what is left of the frame's budget, it
+ * splits the region into bands of frame columns, overlapping by
+ * SCAN_SCHEDULER_OVERLAP columns.  The capture is a quarter turn from the
+ * display (see cameraView targetRectInStrip), so a card held horizontally
+ * in the overlay has its bars along frame rows: each band runs the full
+ * length of the symbol and cuts across the bars, and any band the bars
+ * reach into holds the whole symbol, only shorter.
+ *
+ * Bands are scanned in turn until one decodes or the budget is spent.
+ * The bands left over are carried to the next frame, which starts where
+ * this one stopped, so the whole region is still covered every few
+ * frames.  After a decode the next frame starts at the band that decoded.
+ *
+ * A band in progress can't be interrupted, so a frame can still run over
+ * budget; those frames are counted, here and in scanMetrics.
+ *
+ * Not thread safe; call from the scan worker only.
+ *
+ */
+
+#import "scanScheduler.h"
+#import "scanMetrics.h"
+#import <mach/mach_time.h>
+
+@implementation scanScheduler
+
+@synthesize budget;
+@synthesize bands;
+@synthesize frames;
+@synthesize overBudget;
+@synthesize carried;
+
+-(id)init {
+  if (self = [super init]) {
+    self.budget = SCAN_SCHEDULER_BUDGET_MS;
+    bands = 1;
+  }
+  return self;
+}
+
+/**
+ * \brief Scan an image's crop, in bands if it won't fit the budget
+ *
+ * \param image Image with data attached and its crop set; the crop is
+ *              restored before returning
+ * \param pyramid Pyramid to scan each band through
+ * \param scanner Scanner to scan with
+ * \param machStart mach_absolute_time() when work on the frame began
+ * \param origin Set to the position in the image of the crop that
+ *               decoded, for mapping coarse symbol locations
+ * \return The image holding the decoded symbols, as from the pyramid, or
+ *         NULL if nothing decoded
+ */
+-(zbar_image_t*)scanImage: (zbar_image_t*)image 
+                withPyramid: (scanPyramid*)pyramid 
+                scanner: (zbar_image_scanner_t*)scanner 
+                started: (uint64_t)machStart 
+                origin: (CGPoint*)origin {
+  frames++;
+  unsigned x, y, width, height;
+  zbar_image_get_crop(image, &x, &y, &width, &height);
+  
+  // Split the region so each band fits what's left of the budget
+  double remaining = self.budget - machTimeToMs(mach_absolute_time() - 
+                                                machStart);
+  double estimate = msPerPixel * width * height;
+  int split = 1;
+  if (estimate > remaining)
+    split = ceil(estimate / MAX(remaining, self.budget / 
+                                           SCAN_SCHEDULER_MAX_BANDS));
+  split = MAX(1, MIN(split, SCAN_SCHEDULER_MAX_BANDS));
+  if (split != bands) {
+    bands = split;
+    nextBand = 0;
+  }
+  
+  unsigned bandWidth = (width + bands - 1) / bands;
+  zbar_image_t *decoded = NULL;
+  int scanned = 0, band = nextBand;
+  while (scanned < bands) {
+    band = (nextBand + scanned) % bands;
+    unsigned left = band * bandWidth;
+    unsigned right = MIN(left + bandWidth + SCAN_SCHEDULER_OVERLAP, width);
+    left = left > SCAN_SCHEDULER_OVERLAP ? left - SCAN_SCHEDULER_OVERLAP : 0;
+    zbar_image_set_crop(image, x + left, y, right - left, height);
+    *origin = CGPointMake(x + left, y);
+    
+    uint64_t bandStart = mach_absolute_time();
+    decoded = [pyramid scanImage: image withScanner: scanner];
+    double ms = machTimeToMs(mach_absolute_time() - bandStart);
+    double sample = ms / ((right - left) * height);
+    msPerPixel = msPerPixel > 0 ? 
+      msPerPixel + SCAN_SCHEDULER_SMOOTHING * (sample - msPerPixel) : 
+      sample;
+    
+    scanned++;
+    if (decoded) break;
+    if (machTimeToMs(mach_absolute_time() - machStart) >= self.budget) break;
+  }
+  zbar_image_set_crop(image, x, y, width, height);
+  
+  if (decoded)
+    nextBand = band;
+  else {
+    if (scanned < bands) carried++;
+    nextBand = (nextBand + scanned) % bands;
+  }
+  if (machTimeToMs(mach_absolute_time() - machStart) > self.budget) {
+    overBudget++;
+    [[scanMetrics sharedMetrics] frameOverBudget];
+  }
+  return decoded;
+}
+
+/**
+ * \brief Budget counts, for the scan worker's log
+ */
+-(NSString*)summary {
+  return [NSString stringWithFormat: 
+    @"%d of %d frames over %.0f ms budget, %d carried work over, "
+     "scanning in %d band%@",
+    overBudget, frames, self.budget, carried, bands, 
+    bands == 1 ? @"" : @"s"];
+}
+
+@end
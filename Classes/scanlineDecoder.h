@@ -0,0 +1,71 @@
+//
+//  scanlineDecoder.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+#import "ZBarSDK.h"
+#import "scanResult.h"
+
+/// Columns fed through the decoder across the middle of the region
+#define SCANLINE_COLUMNS 7
+/// Fraction of the region's width the columns are spread over
+#define SCANLINE_BAND 0.5
+/// Columns that must decode the same data for a result to count
+#define SCANLINE_CONFIRMATIONS 2
+/// Longest data the fast path can return, in bytes
+#define SCANLINE_MAX_DATA 128
+
+
+@interface scanlineDecoder : NSObject {
+  BOOL enabled;
+  int frames;
+  int hits;
+  NSString *candidate;
+  
+  @private
+    zbar_decoder_t *decoder;
+    zbar_scanner_t *scanner;
+    BOOL decoded;
+    zbar_symbol_type_t decodedType;
+    unsigned decodedLength;
+    char decodedData[SCANLINE_MAX_DATA];
+}
+
+/// Whether the fast path is tried at all
+@property (nonatomic) BOOL enabled;
+/// Regions scanned
+@property (nonatomic, readonly) int frames;
+/// Regions decoded by the fast path
+@property (nonatomic, readonly) int hits;
+/// Data the last unconfirmed scan decoded from a single column, or nil
+@property (nonatomic, readonly) NSString *candidate;
+
+-(id)initWithProfile: (NSDictionary*)profile;
+-(scanResult*)scanPlane: (const uint8_t*)plane 
+              bytesPerRow: (size_t)bytesPerRow 
+              region: (CGRect)region 
+              sequence: (unsigned)sequence;
+-(scanResult*)scanImage: (zbar_image_t*)image offset: (CGPoint)offset;
+-(NSString*)summary;
+
+@end
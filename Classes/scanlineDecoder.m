@@ -0,0 +1,266 @@
+//
+//  scanlineDecoder.m
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief Decodes linear barcodes from a few columns before a full image scan
+ *
+ * Cards are always presented horizontally inside the target window on
+ * screen.  The capture is a quarter turn from the display (see cameraView
+ * targetRectInStrip), so in the frame the bars run along rows, and a
+ * handful of frame columns through the window usually cross every bar.
+ * Feeding those columns straight through a ZBar scanner and decoder
+ * (zbar_scan_y) is much cheaper than a full image scan, which sweeps the
+ * whole window in both directions.
+ *
+ * SCANLINE_COLUMNS columns are spread over the middle SCANLINE_BAND of the
+ * region, starting from its centre and working outward.  The decoder's
+ * handler keeps the first decode; the fast path returns as soon as
+ * SCANLINE_CONFIRMATIONS columns agree on it, which stands in for the
+ * multi-scanline quality the image scanner would have required.  If the
+ * columns don't agree, the caller falls back to a full image scan.
+ *
+ * A decode only one column agrees on isn't trusted as a result, but it is
+ * kept as the candidate, which is enough to start looking the customer
+ * up before the image scan confirms it.
+ *
+ * The decoder is configured from the same scan profile as the image
+ * scanner, so it accepts the same symbologies and lengths.
+ *
+ * Not thread safe; each scan thread needs its own decoder.
+ *
+ */
+
+#import "scanlineDecoder.h"
+#import "codeScanner.h"
+
+@interface scanlineDecoder (PrivateMethods)
+-(void)decodedType: (zbar_symbol_type_t)type 
+       data: (const char*)data 
+       length: (unsigned)length;
+-(BOOL)scanColumn: (const uint8_t*)top 
+       bytesPerRow: (size_t)bytesPerRow 
+       height: (int)height;
+@end
+
+/**
+ * \brief ZBar decoder handler; keeps a copy of each symbol decoded
+ *
+ * The decoder's data buffer is only valid until the next sample, so the
+ * data is copied out here.
+ */
+static void scanlineDecoded(zbar_decoder_t *zdecoder) {
+  scanlineDecoder *fastPath = zbar_decoder_get_userdata(zdecoder);
+  zbar_symbol_type_t type = zbar_decoder_get_type(zdecoder);
+  unsigned length = zbar_decoder_get_data_length(zdecoder);
+  if (type <= ZBAR_PARTIAL || length > SCANLINE_MAX_DATA) return;
+  [fastPath decodedType: type data: zbar_decoder_get_data(zdecoder) 
+            length: length];
+}
+
+@implementation scanlineDecoder
+
+@synthesize enabled;
+@synthesize frames;
+@synthesize hits;
+@synthesize candidate;
+
+/**
+ * \brief Create a fast path decoder for a scan profile
+ *
+ * \param profile Profile dictionary from codeScanner's scanProfiles
+ * \return Initialized instance
+ */
+-(id)initWithProfile: (NSDictionary*)profile {
+  if (self = [super init]) {
+    decoder = zbar_decoder_create();
+    scanner = zbar_scanner_create(decoder);
+    zbar_decoder_set_userdata(decoder, self);
+    zbar_decoder_set_handler(decoder, scanlineDecoded);
+    
+    zbar_decoder_t *zdecoder = decoder;
+    [codeScanner applyProfile: profile 
+                 with: ^(zbar_symbol_type_t type, zbar_config_t config, 
+                         int value) {
+      // Image scanner settings such as density don't apply to a decoder
+      if (config < ZBAR_CFG_UNCERTAINTY)
+        zbar_decoder_set_config(zdecoder, type, config, value);
+    }];
+    self.enabled = YES;
+  }
+  return self;
+}
+
+-(void)dealloc {
+  zbar_scanner_destroy(scanner);
+  zbar_decoder_destroy(decoder);
+  [candidate release];
+  [super dealloc];
+}
+
+/**
+ * \brief Try to decode a region of a greyscale plane from a few columns
+ *
+ * \param plane First byte of the greyscale plane, in capture orientation
+ * \param bytesPerRow Row stride of the plane in bytes
+ * \param region Region of the plane to scan
+ * \param sequence Frame sequence number for the result
+ * \return Autoreleased result, with the columns that agreed as its
+ *         quality, or nil if the columns didn't agree on a decode
+ */
+-(scanResult*)scanPlane: (const uint8_t*)plane 
+              bytesPerRow: (size_t)bytesPerRow 
+              region: (CGRect)region 
+              sequence: (unsigned)sequence {
+  [candidate release];
+  candidate = nil;
+  if (!self.enabled || !plane) return nil;
+  frames++;
+  region = CGRectIntegral(region);
+  int x = region.origin.x, y = region.origin.y;
+  int width = region.size.width, height = region.size.height;
+  if (width < 1 || height < 2) return nil;
+  
+  // Columns alternate either side of the centre, moving outward
+  int centre = x + width / 2;
+  int spacing = MAX(1, (int)(width * SCANLINE_BAND) / SCANLINE_COLUMNS);
+  zbar_symbol_type_t agreedType = ZBAR_NONE;
+  char agreed[SCANLINE_MAX_DATA];
+  unsigned agreedLength = 0;
+  int matches = 0, first = centre, last = centre;
+  
+  for (int i = 0; i < SCANLINE_COLUMNS; i++) {
+    int offset = (i + 1) / 2 * spacing;
+    int column = (i & 1) ? centre - offset : centre + offset;
+    if (column < x || column >= x + width) continue;
+    if (![self scanColumn: plane + (size_t)y * bytesPerRow + column 
+               bytesPerRow: bytesPerRow height: height])
+      continue;
+    
+    if (!matches) {
+      agreedType = decodedType;
+      agreedLength = decodedLength;
+      memcpy(agreed, decodedData, decodedLength);
+    }
+    else if (decodedType != agreedType || decodedLength != agreedLength || 
+             memcmp(decodedData, agreed, agreedLength)) {
+      continue;
+    }
+    first = MIN(first, column);
+    last = MAX(last, column);
+    if (++matches < SCANLINE_CONFIRMATIONS) continue;
+    
+    NSString *data = [[[NSString alloc] initWithBytes: agreed 
+                                        length: agreedLength 
+                                        encoding: NSUTF8StringEncoding] 
+      autorelease];
+    if (!data) return nil;
+    hits++;
+    return [[[scanResult alloc] initWithData: data 
+                                symbology: agreedType 
+                                quality: matches 
+                                location: CGRectMake(first, y, 
+                                                     last - first + 1, 
+                                                     height)
+                                sequence: sequence] autorelease];
+  }
+  
+  if (matches)
+    candidate = [[NSString alloc] initWithBytes: agreed 
+                                  length: agreedLength 
+                                  encoding: NSUTF8StringEncoding];
+  return nil;
+}
+
+/**
+ * \brief Try to decode the crop of a Y800 image from a few columns
+ *
+ * \param image Image with data attached and its crop set
+ * \param offset Position in the frame of the image's origin
+ * \return Autoreleased result in frame pixels, or nil
+ */
+-(scanResult*)scanImage: (zbar_image_t*)image offset: (CGPoint)offset {
+  unsigned x, y, width, height;
+  zbar_image_get_crop(image, &x, &y, &width, &height);
+  scanResult *result = [self scanPlane: zbar_image_get_data(image) 
+                             bytesPerRow: zbar_image_get_width(image) 
+                             region: CGRectMake(x, y, width, height) 
+                             sequence: zbar_image_get_sequence(image)];
+  if (!result || CGPointEqualToPoint(offset, CGPointZero)) return result;
+  
+  CGRect location = CGRectOffset(result.location, offset.x, offset.y);
+  return [[[scanResult alloc] initWithData: result.data 
+                              symbology: result.symbology 
+                              quality: result.quality 
+                              location: location 
+                              sequence: result.sequence] autorelease];
+}
+
+/**
+ * \brief Hit counts, for the scan worker's log
+ */
+-(NSString*)summary {
+  return [NSString stringWithFormat: 
+    @"scanlines %@: %d of %d frames decoded without an image scan",
+    self.enabled ? @"on" : @"off", hits, frames];
+}
+
+@end
+
+@implementation scanlineDecoder (PrivateMethods)
+
+/**
+ * \brief Keep a decode reported by the decoder handler
+ */
+-(void)decodedType: (zbar_symbol_type_t)type 
+       data: (const char*)data 
+       length: (unsigned)length {
+  if (decoded) return;
+  decoded = YES;
+  decodedType = type;
+  decodedLength = length;
+  memcpy(decodedData, data, length);
+}
+
+/**
+ * \brief Feed one column through the scanner and decoder
+ *
+ * \param top Top pixel of the column
+ * \param bytesPerRow Row stride of the plane in bytes
+ * \param height Pixels in the column
+ * \return Whether the decoder handler reported a symbol
+ */
+-(BOOL)scanColumn: (const uint8_t*)top 
+       bytesPerRow: (size_t)bytesPerRow 
+       height: (int)height {
+  decoded = NO;
+  zbar_scanner_reset(scanner);
+  zbar_scanner_new_scan(scanner);
+  for (int i = 0; i < height && !decoded; i++)
+    zbar_scan_y(scanner, top[(size_t)i * bytesPerRow]);
+  
+  // Flush the pipeline so a symbol ending at the edge of the column decodes
+  for (int i = 0; i < 3 && !decoded; i++)
+    zbar_scanner_flush(scanner);
+  return decoded;
+}
+
+@end
@@ -0,0 +1,59 @@
+//
+//  sqliteConnection.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#import <Foundation/Foundation.h>
+#import <sqlite3.h>
+
+/// Milliseconds a statement waits for another connection's write lock
+#define SQLITE_CONNECTION_BUSY_TIMEOUT_MS 2000
+
+
+@interface sqliteConnection : NSObject {
+  NSString *path;
+  int prepared;
+  int reused;
+  
+  @private
+    sqlite3 *db;
+    NSMutableDictionary *statements;
+}
+
+/// Full path of the database file
+@property (nonatomic, readonly) NSString *path;
+/// Open database handle, or NULL once closed
+@property (nonatomic, readonly) sqlite3 *db;
+/// Statements compiled
+@property (nonatomic, readonly) int prepared;
+/// Statements served from the cache
+@property (nonatomic, readonly) int reused;
+
++(sqliteConnection*)connectionToFile: (NSString*)file;
++(void)closeConnectionToFile: (NSString*)file;
++(void)beginReplacingFile: (NSString*)file;
++(void)endReplacingFile: (NSString*)file;
+-(sqlite3_stmt*)statement: (NSString*)sql;
+-(BOOL)bindArguments: (NSArray*)args toStatement: (sqlite3_stmt*)stmt;
+-(void)close;
+-(NSString*)summary;
+
+@end
@@ -0,0 +1,243 @@
+//
+//  sqliteConnection.m
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief Long-lived sqlite connection with a prepared statement cache
+ *
+ * Opening a database and compiling a query cost far more than the indexed
+ * lookups the customer screens make, and used to be paid on every query.
+ * There is now one connection per database file, kept in a registry for
+ * the life of the app, and each distinct SQL string is compiled once and
+ * kept.  Arguments are always bound, never formatted into the SQL, so the
+ * cache key is the SQL text itself.
+ *
+ * A connection is shared between threads: the scan handler, the customer
+ * prefetch queue and the UI all use it.  Callers hold @synchronized on the
+ * connection from taking a statement until they are done reading it.
+ * statement: resets the statement and clears its bindings first, so a
+ * statement is always handed out ready to bind.
+ *
+ * A file being replaced is bracketed by beginReplacingFile: and
+ * endReplacingFile: (see databaseManager's reloadWithNewDatabaseFile:).
+ * The first closes its connection, and until the second no connection to
+ * the file is opened, so a lookup racing the copy can't open the old file
+ * and leave its handle in the registry.  Requests in between get nil.
+ *
+ */
+
+#import "sqliteConnection.h"
+
+/// Open connections, keyed by file path
+static NSMutableDictionary *connections = nil;
+/// Paths of files being replaced, which mustn't be opened
+static NSMutableSet *replacing = nil;
+
+@interface sqliteConnection (PrivateMethods)
+-(id)initWithFile: (NSString*)file;
+@end
+
+@implementation sqliteConnection
+
+@synthesize path;
+@synthesize db;
+@synthesize prepared;
+@synthesize reused;
+
+/**
+ * \brief Shared connection to a database file, opened on first use
+ *
+ * \param file Full path to database file
+ * \return Connection, or nil if the database couldn't be opened or is
+ *         being replaced
+ */
++(sqliteConnection*)connectionToFile: (NSString*)file {
+  if (!file) return nil;
+  @synchronized([sqliteConnection class]) {
+    if (!connections) connections = [[NSMutableDictionary alloc] init];
+    sqliteConnection *connection = [connections objectForKey: file];
+    if (connection) return [[connection retain] autorelease];
+    if ([replacing containsObject: file]) return nil;
+    
+    connection = [[[sqliteConnection alloc] initWithFile: file] autorelease];
+    if (!connection) return nil;
+    [connections setObject: connection forKey: file];
+    return connection;
+  }
+}
+
+/**
+ * \brief Close the shared connection to a database file, if open
+ *
+ * \param file Full path to database file
+ */
++(void)closeConnectionToFile: (NSString*)file {
+  if (!file) return;
+  sqliteConnection *connection = nil;
+  @synchronized([sqliteConnection class]) {
+    connection = [[[connections objectForKey: file] retain] autorelease];
+    [connections removeObjectForKey: file];
+  }
+  if (connection) NSLog(@"%@", [connection summary]);
+  [connection close];
+}
+
+/**
+ * \brief Close a database file's connection and keep it closed
+ *
+ * Until endReplacingFile:, connectionToFile: returns nil for the file
+ * rather than opening it.
+ *
+ * \param file Full path to database file
+ */
++(void)beginReplacingFile: (NSString*)file {
+  if (!file) return;
+  @synchronized([sqliteConnection class]) {
+    if (!replacing) replacing = [[NSMutableSet alloc] init];
+    [replacing addObject: file];
+  }
+  [self closeConnectionToFile: file];
+}
+
+/**
+ * \brief Allow a replaced database file to be opened again
+ *
+ * \param file Full path to database file
+ */
++(void)endReplacingFile: (NSString*)file {
+  if (!file) return;
+  @synchronized([sqliteConnection class]) {
+    [replacing removeObject: file];
+  }
+}
+
+-(void)dealloc {
+  [self close];
+  [statements release];
+  [path release];
+  [super dealloc];
+}
+
+/**
+ * \brief Cached statement for some SQL, compiled on first use
+ *
+ * Caller must hold @synchronized on the connection until it has finished
+ * with the statement.
+ *
+ * \param sql SQL text, with ? placeholders for arguments
+ * \return Statement reset and ready to bind, or NULL if the SQL doesn't
+ *         compile or the connection is closed
+ */
+-(sqlite3_stmt*)statement: (NSString*)sql {
+  if (!db) return NULL;
+  sqlite3_stmt *stmt = [[statements objectForKey: sql] pointerValue];
+  if (stmt) {
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    reused++;
+    return stmt;
+  }
+  
+  if (sqlite3_prepare_v2(db, [sql UTF8String], -1, &stmt, NULL) != SQLITE_OK) {
+    NSLog(@"SQL error: %s in %@", sqlite3_errmsg(db), sql);
+    return NULL;
+  }
+  [statements setObject: [NSValue valueWithPointer: stmt] forKey: sql];
+  prepared++;
+  return stmt;
+}
+
+/**
+ * \brief Bind arguments to a statement's placeholders in order
+ *
+ * NSNumbers are bound as integers, NSNull as NULL, and anything else as
+ * its description, as text.
+ *
+ * \param args Arguments, one per placeholder
+ * \param stmt Statement from statement:
+ * \return Whether every argument was bound
+ */
+-(BOOL)bindArguments: (NSArray*)args toStatement: (sqlite3_stmt*)stmt {
+  int index = 1;
+  for (id arg in args) {
+    int result;
+    if ([arg isKindOfClass: [NSNumber class]])
+      result = sqlite3_bind_int64(stmt, index, [arg longLongValue]);
+    else if ([arg isKindOfClass: [NSNull class]])
+      result = sqlite3_bind_null(stmt, index);
+    else
+      result = sqlite3_bind_text(stmt, index, [[arg description] UTF8String], 
+                                 -1, SQLITE_TRANSIENT);
+    if (result != SQLITE_OK) return NO;
+    index++;
+  }
+  return YES;
+}
+
+/**
+ * \brief Finalize every cached statement and close the database
+ */
+-(void)close {
+  @synchronized(self) {
+    for (NSValue *stmt in [statements allValues])
+      sqlite3_finalize([stmt pointerValue]);
+    [statements removeAllObjects];
+    if (db) sqlite3_close(db);
+    db = NULL;
+  }
+}
+
+/**
+ * \brief Statement cache counters, for the log
+ */
+-(NSString*)summary {
+  @synchronized(self) {
+    return [NSString stringWithFormat: 
+      @"sqlite %@: %d statements compiled, %d reused",
+      [path lastPathComponent], prepared, reused];
+  }
+}
+
+@end
+
+@implementation sqliteConnection (PrivateMethods)
+
+/**
+ * \brief Open a database file
+ *
+ * \param file Full path to database file
+ * \return Initialized instance, or nil if it couldn't be opened
+ */
+-(id)initWithFile: (NSString*)file {
+  if (self = [super init]) {
+    path = [file copy];
+    statements = [[NSMutableDictionary alloc] init];
+    if (sqlite3_open([file UTF8String], &db) != SQLITE_OK) {
+      NSLog(@"Couldn't open %@: %s", file, db ? sqlite3_errmsg(db) : "");
+      [self release];
+      return nil;
+    }
+    sqlite3_busy_timeout(db, SQLITE_CONNECTION_BUSY_TIMEOUT_MS);
+  }
+  return self;
+}
+
+@end
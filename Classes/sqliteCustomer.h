@@ -0,0 +1,48 @@
+//
+//  sqliteCustomer.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+#import <Foundation/Foundation.h>
+#import "customerProtocol.h"
+#import "sqliteConnection.h"
+#import "customerCache.h"
+#import <libkern/OSAtomic.h>
+
+/// Most customer snapshots cached
+#define SQLITE_CUSTOMER_CACHE_CAPACITY 4096
+/// Most memory the cached snapshots may use, in bytes
+#define SQLITE_CUSTOMER_CACHE_BYTES (512 * 1024)
+
+
+@interface sqliteCustomer : NSObject <customerProtocol> {
+  @private
+    NSArray *definition;
+    sqliteConnection *current;
+    sqliteConnection *indexed;
+    customerCache *cache;
+    OSSpinLock cacheLock;
+    uint32_t cacheGeneration;
+}
+
+-(NSString*)cacheSummary;
+
+@end
@@ -0,0 +1,683 @@
+//
+//  sqliteCustomer.m
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/**
+ * \brief customerProtocol implementation over the sqlite customer database
+ *
+ * Implements the schema in "Database Schema.txt": customers, their rewards
+ * level and credit, and who referred whom.  The schema holds no discount
+ * or rule for raising levels, and those are the venue's business rules,
+ * so every discount is 0 and levels only change when set; like
+ * stubCustomer, updateLevelOfReferrerWithBarcode:withDb: does nothing.
+ *
+ * A scan reads the customer with one query, into a customerSnapshot; the
+ * scalar lookups (name, level, discount, credit and referral count) are
+ * views over a snapshot, so each costs the same single query.
+ *
+ * Snapshots are cached by barcode in a customerCache, so a regular
+ * scanned again doesn't go to the database.  Each write drops the
+ * snapshots it changes: the customer written, and the referrer whose
+ * referral count moved.  Everything is dropped when the database
+ * file is replaced, which shows up here as a new connection.  A snapshot
+ * read while a write was dropping entries isn't cached, since it may be
+ * from before the write.
+ *
+ * Every query goes through the file's shared sqliteConnection, so the
+ * database is opened once and each query compiled once, however many
+ * lookups a scan makes.  Values are always bound.  The generic field
+ * accessors have to name a table and column in their SQL, which can't be
+ * bound, so they only accept pairs listed in customerDefinition.
+ *
+ * Referral counts search referrals by referrer, through referrer_idx.
+ * The bundled database ships with it.  A database loaded from elsewhere
+ * may not have it, so it is created the first time this device writes to
+ * the database; schema is never written by a device that only reads.
+ *
+ * Bonus rewards aren't in the schema, so every customer has none.
+ *
+ * Thread safe: each query holds its connection's lock.
+ *
+ */
+
+#import "sqliteCustomer.h"
+#import <objc/runtime.h>
+
+/// Customer id for the barcode bound as the first argument
+#define CUSTOMER_ID_BY_BARCODE \
+  @"(SELECT customer_id FROM customers WHERE barcode = ?)"
+
+/**
+ * \brief customerCache release callback for snapshots
+ */
+static void releaseSnapshot(void *snapshot) {
+  [(customerSnapshot*)snapshot release];
+}
+
+@interface sqliteCustomer (PrivateMethods)
+-(customerSnapshot*)cachedSnapshot: (NSString*)barcode 
+                    generation: (uint32_t*)generation;
+-(void)cacheSnapshot: (customerSnapshot*)snapshot 
+       generation: (uint32_t)generation;
+-(void)invalidateBarcode: (NSString*)barcode;
+-(void)invalidateAll;
+-(NSString*)referrerOf: (NSString*)barcode on: (sqliteConnection*)connection;
+-(sqliteConnection*)connectionTo: (NSString*)dbFile;
+-(sqliteConnection*)writableConnectionTo: (NSString*)dbFile;
+-(BOOL)execute: (NSString*)sql 
+       args: (NSArray*)args 
+       on: (sqliteConnection*)connection;
+-(int)intFrom: (NSString*)sql 
+      args: (NSArray*)args 
+      on: (sqliteConnection*)connection;
+-(NSString*)stringFrom: (NSString*)sql 
+            args: (NSArray*)args 
+            on: (sqliteConnection*)connection;
+-(BOOL)inTransactionOn: (sqliteConnection*)connection 
+       do: (BOOL (^)(void))block;
+-(NSArray*)buildDefinition;
+-(BOOL)isDefinedTable: (NSString*)table field: (NSString*)field;
+@end
+
+@implementation sqliteCustomer
+
+-(id)init {
+  if (self = [super init]) {
+    cache = customerCacheCreate(SQLITE_CUSTOMER_CACHE_CAPACITY, 
+                                SQLITE_CUSTOMER_CACHE_BYTES, releaseSnapshot);
+    cacheLock = OS_SPINLOCK_INIT;
+  }
+  return self;
+}
+
+-(void)dealloc {
+  customerCacheDestroy(cache);
+  [definition release];
+  [indexed release];
+  [current release];
+  [super dealloc];
+}
+
+-(NSArray *)customerDefinition {
+  @synchronized(self) {
+    if (!definition) definition = [[self buildDefinition] retain];
+    return definition;
+  }
+}
+
+-(NSString*)getStringValueFromDb: (NSString*)dbFile
+            withBarcode: (NSString*)barcode
+            withFieldType: (NSString*)type
+            withTable: (NSString*)table
+            withField: (NSString*)field {
+  if (!barcode || ![self isDefinedTable: table field: field]) return nil;
+  sqliteConnection *connection = [self connectionTo: dbFile];
+  NSArray *args = [NSArray arrayWithObject: barcode];
+  
+  // A referrer is stored by id, but shown and entered as a barcode
+  if ([table isEqualToString: @"referrals"]) 
+    return [self referrerOf: barcode on: connection];
+  if ([table isEqualToString: @"customer_reward_levels"]) {
+    return [self stringFrom: [NSString stringWithFormat: 
+                               @"SELECT %@ FROM customer_reward_levels "
+                                "WHERE customer_id = " CUSTOMER_ID_BY_BARCODE,
+                               field]
+                 args: args on: connection];
+  }
+  return [self stringFrom: [NSString stringWithFormat: 
+                             @"SELECT %@ FROM customers WHERE barcode = ?", 
+                             field]
+               args: args on: connection];
+}
+
+-(BOOL)setStringValue: (NSString*)text
+       toDb: (NSString*)dbFile
+       withBarcode: (NSString*)barcode
+       withFieldType: (NSString*)type
+       withTable: (NSString*)table
+       withField: (NSString*)field {
+  if (!barcode || ![self isDefinedTable: table field: field]) return NO;
+  sqliteConnection *connection = [self writableConnectionTo: dbFile];
+  
+  id value = text;
+  if ([type isEqualToString: @"number"])
+    value = [text length] ? 
+      (id)[NSNumber numberWithInt: [text intValue]] : (id)[NSNull null];
+  else if (![text length])
+    value = [NSNull null];
+  
+  if ([table isEqualToString: @"referrals"]) {
+    NSString *oldReferrer = [self referrerOf: barcode on: connection];
+    BOOL written = [self inTransactionOn: connection do: ^BOOL {
+      if (![self execute: @"DELETE FROM referrals "
+                           "WHERE customer_id = " CUSTOMER_ID_BY_BARCODE
+                 args: [NSArray arrayWithObject: barcode] on: connection])
+        return NO;
+      if (![text length]) return YES;
+      return [self execute: @"INSERT INTO referrals (referrer, customer_id) "
+                             "SELECT r.customer_id, c.customer_id "
+                             "FROM customers r, customers c "
+                             "WHERE r.barcode = ? AND c.barcode = ?"
+                   args: [NSArray arrayWithObjects: text, barcode, nil] 
+                   on: connection];
+    }];
+    // Both referrers' counts may have changed
+    [self invalidateBarcode: oldReferrer];
+    [self invalidateBarcode: text];
+    return written;
+  }
+  if ([table isEqualToString: @"customer_reward_levels"]) {
+    if (value == [NSNull null]) value = [NSNumber numberWithInt: 0];
+    BOOL written = [self inTransactionOn: connection do: ^BOOL {
+      if (![self execute: @"INSERT OR IGNORE INTO customer_reward_levels "
+                           "(customer_id, level, credit) "
+                           "SELECT customer_id, 0, 0 FROM customers "
+                           "WHERE barcode = ?"
+                 args: [NSArray arrayWithObject: barcode] on: connection])
+        return NO;
+      return [self execute: [NSString stringWithFormat: 
+                              @"UPDATE customer_reward_levels SET %@ = ? "
+                               "WHERE customer_id = " CUSTOMER_ID_BY_BARCODE,
+                              field]
+                   args: [NSArray arrayWithObjects: value, barcode, nil] 
+                   on: connection];
+    }];
+    [self invalidateBarcode: barcode];
+    return written;
+  }
+  if (value == [NSNull null] && 
+      ([field isEqualToString: @"name"] || [field isEqualToString: @"barcode"]))
+    return NO;
+  BOOL written = [self execute: [NSString stringWithFormat: 
+                                  @"UPDATE customers SET %@ = ? "
+                                   "WHERE barcode = ?", 
+                                  field]
+                       args: [NSArray arrayWithObjects: value, barcode, nil] 
+                       on: connection];
+  [self invalidateBarcode: barcode];
+  if ([field isEqualToString: @"barcode"]) [self invalidateBarcode: text];
+  return written;
+}
+
+-(BOOL)addCustomertoDb: (NSString*)dbFile 
+       withName: (NSString*)name
+       withBarcode: (NSString*)barcode
+       withReferrer: (NSString*)referrer {
+  if (![name length] || ![barcode length]) return NO;
+  sqliteConnection *connection = [self writableConnectionTo: dbFile];
+  NSArray *args = [NSArray arrayWithObject: barcode];
+  
+  BOOL added = [self inTransactionOn: connection do: ^BOOL {
+    if ([self intFrom: @"SELECT COUNT(*) FROM customers WHERE barcode = ?" 
+              args: args on: connection])
+      return NO;
+    if (![self execute: @"INSERT INTO customers (name, barcode, account_date) "
+                         "VALUES (?, ?, date('now'))"
+               args: [NSArray arrayWithObjects: name, barcode, nil] 
+               on: connection])
+      return NO;
+    if (![self execute: @"INSERT INTO customer_reward_levels "
+                         "(customer_id, level, credit) "
+                         "SELECT customer_id, 0, 0 FROM customers "
+                         "WHERE barcode = ?"
+               args: args on: connection])
+      return NO;
+    if (![referrer length]) return YES;
+    return [self execute: @"INSERT INTO referrals (referrer, customer_id) "
+                           "SELECT r.customer_id, c.customer_id "
+                           "FROM customers r, customers c "
+                           "WHERE r.barcode = ? AND c.barcode = ?"
+                 args: [NSArray arrayWithObjects: referrer, barcode, nil] 
+                 on: connection];
+  }];
+  // The referrer's referral count went up
+  if (added && [referrer length]) [self invalidateBarcode: referrer];
+  return added;
+}
+
+-(BOOL)updateLevelOfReferrerWithBarcode:(NSString*)barcode
+   withDb: (NSString*)dbFile {
+  // Level rules are the venue's; none are defined for this database
+  return YES;
+}
+
+-(int)countOfCustomersInDb: (NSString*)dbFile {
+  return [self intFrom: @"SELECT COUNT(*) FROM customers" 
+               args: nil 
+               on: [self connectionTo: dbFile]];
+}
+
+-(NSArray*)allCustomersInDb: (NSString*)dbFile {
+  sqliteConnection *connection = [self connectionTo: dbFile];
+  NSMutableArray *rows = [NSMutableArray array];
+  @synchronized(connection) {
+    sqlite3_stmt *stmt = [connection statement: 
+      @"SELECT name, barcode FROM customers"];
+    if (!stmt) return rows;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      const char *name = (const char*)sqlite3_column_text(stmt, 0);
+      const char *barcode = (const char*)sqlite3_column_text(stmt, 1);
+      if (!name || !barcode) continue;
+      [rows addObject: [NSDictionary dictionaryWithObjectsAndKeys:
+        [NSString stringWithUTF8String: name], @"name",
+        [NSString stringWithUTF8String: barcode], @"barcode", nil]];
+    }
+    sqlite3_reset(stmt);
+  }
+  return rows;
+}
+
+-(customerSnapshot*)snapshotFromDb: (NSString*)dbFile 
+                    withBarcode: (NSString*)barcode {
+  if (!barcode) return nil;
+  sqliteConnection *connection = [self connectionTo: dbFile];
+  if (!connection) return nil;
+  uint32_t generation;
+  customerSnapshot *cached = [self cachedSnapshot: barcode 
+                                   generation: &generation];
+  if (cached) return cached;
+  
+  // One probe of customer_idx; the rest are by customer_id
+  @synchronized(connection) {
+    sqlite3_stmt *stmt = [connection statement: 
+      @"SELECT c.name, IFNULL(l.level, 0), IFNULL(l.credit, 0), "
+       "(SELECT COUNT(*) FROM referrals r WHERE r.referrer = c.customer_id) "
+       "FROM customers c "
+       "LEFT JOIN customer_reward_levels l ON l.customer_id = c.customer_id "
+       "WHERE c.barcode = ?"];
+    if (!stmt || ![connection bindArguments: [NSArray arrayWithObject: barcode]
+                              toStatement: stmt]) 
+      return nil;
+    
+    customerSnapshot *snapshot = nil;
+    const char *name = NULL;
+    if (sqlite3_step(stmt) == SQLITE_ROW && 
+        (name = (const char*)sqlite3_column_text(stmt, 0))) {
+      snapshot = [[[customerSnapshot alloc] 
+        initWithBarcode: barcode 
+        name: [NSString stringWithUTF8String: name] 
+        level: sqlite3_column_int(stmt, 1) 
+        discount: 0
+        credit: sqlite3_column_int(stmt, 2) 
+        referrals: sqlite3_column_int(stmt, 3)] autorelease];
+    }
+    sqlite3_reset(stmt);
+    if (snapshot) [self cacheSnapshot: snapshot generation: generation];
+    return snapshot;
+  }
+}
+
+-(NSString*)customerFromDb: (NSString*)dbFile withBarcode: (NSString*)barcode {
+  return [self snapshotFromDb: dbFile withBarcode: barcode].name;
+}
+
+-(int)levelFromDb: (NSString*)dbFile withBarcode: (NSString*)barcode {
+  return [self snapshotFromDb: dbFile withBarcode: barcode].level;
+}
+
+-(int)discountFromDb: (NSString*)dbFile withBarcode: (NSString*)barcode {
+  return [self snapshotFromDb: dbFile withBarcode: barcode].discount;
+}
+
+-(int)creditFromDb: (NSString*)dbFile withBarcode: (NSString*)barcode {
+  return [self snapshotFromDb: dbFile withBarcode: barcode].credit;
+}
+
+-(BOOL)clearCreditFromDb: (NSString*)dbFile withBarcode: (NSString*)barcode {
+  if (!barcode) return NO;
+  BOOL cleared = [self execute: @"UPDATE customer_reward_levels SET credit = 0 "
+                                 "WHERE customer_id = " CUSTOMER_ID_BY_BARCODE
+                       args: [NSArray arrayWithObject: barcode] 
+                       on: [self writableConnectionTo: dbFile]];
+  [self invalidateBarcode: barcode];
+  return cleared;
+}
+
+-(int)referralCountFromDb: (NSString*)dbFile withBarcode: (NSString*)barcode {
+  return [self snapshotFromDb: dbFile withBarcode: barcode].referrals;
+}
+
+-(int)countOfOtherBonusesFromDb: (NSString*)dbFile 
+      withBarcode: (NSString*)barcode {
+  return 0;
+}
+
+-(NSString*)otherBonusFromDb:  (NSString*)dbFile 
+            withBarcode: (NSString*)barcode 
+            bonusIndex: (int)idx {
+  return nil;
+}
+
+-(BOOL)removeCustomerWithBarcode:(NSString*)barcode fromDb: (NSString*)dbFile {
+  if (!barcode) return NO;
+  sqliteConnection *connection = [self writableConnectionTo: dbFile];
+  NSArray *args = [NSArray arrayWithObject: barcode];
+  NSString *referrer = [self referrerOf: barcode on: connection];
+  
+  BOOL removed = [self inTransactionOn: connection do: ^BOOL {
+    return [self execute: @"DELETE FROM referrals "
+                           "WHERE customer_id = " CUSTOMER_ID_BY_BARCODE
+                           " OR referrer = " CUSTOMER_ID_BY_BARCODE
+                 args: [NSArray arrayWithObjects: barcode, barcode, nil] 
+                 on: connection] &&
+           [self execute: @"DELETE FROM customer_reward_levels "
+                           "WHERE customer_id = " CUSTOMER_ID_BY_BARCODE
+                 args: args on: connection] &&
+           [self execute: @"DELETE FROM customers WHERE barcode = ?" 
+                 args: args on: connection];
+  }];
+  [self invalidateBarcode: barcode];
+  [self invalidateBarcode: referrer];
+  return removed;
+}
+
+/**
+ * \brief Snapshot cache counters, for the log
+ */
+-(NSString*)cacheSummary {
+  customerCacheStats stats;
+  OSSpinLockLock(&cacheLock);
+  customerCacheGetStats(cache, &stats);
+  OSSpinLockUnlock(&cacheLock);
+  uint64_t lookups = stats.hits + stats.misses;
+  return [NSString stringWithFormat: 
+    @"customer cache: %llu lookups, %.0f%% hits, %zu/%zu customers, "
+     "%zu of %zu KB, %llu evicted, %llu invalidated",
+    lookups, lookups ? 100.0 * stats.hits / lookups : 0.0, 
+    stats.entries, stats.capacity, 
+    (stats.valueBytes + stats.tableBytes) / 1024, 
+    (stats.maxValueBytes + stats.tableBytes) / 1024, 
+    stats.evictions, stats.invalidations];
+}
+
+@end
+
+@implementation sqliteCustomer (PrivateMethods)
+
+/**
+ * \brief Shared connection to a database
+ *
+ * A different connection than last time means the database file has been
+ * replaced (or another one opened), so every cached snapshot is dropped.
+ *
+ * \param dbFile Full path to database file
+ * \return Connection, or nil if the database couldn't be opened
+ */
+-(sqliteConnection*)connectionTo: (NSString*)dbFile {
+  sqliteConnection *connection = [sqliteConnection connectionToFile: dbFile];
+  @synchronized(self) {
+    if (!connection || connection == current) return connection;
+    [current release];
+    current = [connection retain];
+  }
+  [self invalidateAll];
+  return connection;
+}
+
+/**
+ * \brief Shared connection to a database this device is writing to
+ *
+ * Adds referrer_idx, if a database loaded from elsewhere lacks it, the
+ * first time each connection is written through.  Only write paths use
+ * this, so a device that only reads never changes the schema.
+ *
+ * \param dbFile Full path to database file
+ * \return Connection, or nil if the database couldn't be opened
+ */
+-(sqliteConnection*)writableConnectionTo: (NSString*)dbFile {
+  sqliteConnection *connection = [self connectionTo: dbFile];
+  @synchronized(self) {
+    if (!connection || connection == indexed) return connection;
+    [self execute: @"CREATE INDEX IF NOT EXISTS referrer_idx "
+                    "ON referrals (referrer)"
+          args: nil on: connection];
+    [indexed release];
+    indexed = [connection retain];
+  }
+  return connection;
+}
+
+/**
+ * \brief Cached snapshot for a barcode
+ *
+ * \param barcode Barcode to look up
+ * \param generation Set to the cache generation, to pass to
+ *        cacheSnapshot:generation: after a miss
+ * \return Autoreleased snapshot, or nil on a miss
+ */
+-(customerSnapshot*)cachedSnapshot: (NSString*)barcode 
+                    generation: (uint32_t*)generation {
+  const char *key = [barcode UTF8String];
+  OSSpinLockLock(&cacheLock);
+  customerSnapshot *snapshot = customerCacheGet(cache, key, strlen(key));
+  [snapshot retain];
+  *generation = cacheGeneration;
+  OSSpinLockUnlock(&cacheLock);
+  return [snapshot autorelease];
+}
+
+/**
+ * \brief Cache a snapshot read from the database
+ *
+ * Dropped if anything was invalidated since the miss, since the snapshot
+ * may have been read before that write.
+ *
+ * \param snapshot Snapshot read after a miss
+ * \param generation Generation returned with the miss
+ */
+-(void)cacheSnapshot: (customerSnapshot*)snapshot 
+       generation: (uint32_t)generation {
+  const char *key = [snapshot.barcode UTF8String];
+  size_t bytes = class_getInstanceSize([customerSnapshot class]) + 
+    2 * class_getInstanceSize([NSString class]) + strlen(key) + 
+    [snapshot.name lengthOfBytesUsingEncoding: NSUTF8StringEncoding];
+  
+  OSSpinLockLock(&cacheLock);
+  if (generation == cacheGeneration)
+    customerCachePut(cache, key, strlen(key), [snapshot retain], bytes);
+  OSSpinLockUnlock(&cacheLock);
+}
+
+/**
+ * \brief Drop a customer's cached snapshot after a write
+ *
+ * \param barcode Customer written, or nil
+ */
+-(void)invalidateBarcode: (NSString*)barcode {
+  if (!barcode) return;
+  const char *key = [barcode UTF8String];
+  OSSpinLockLock(&cacheLock);
+  cacheGeneration++;
+  customerCacheRemove(cache, key, strlen(key));
+  OSSpinLockUnlock(&cacheLock);
+}
+
+/**
+ * \brief Drop every cached snapshot
+ */
+-(void)invalidateAll {
+  OSSpinLockLock(&cacheLock);
+  cacheGeneration++;
+  customerCacheClear(cache);
+  OSSpinLockUnlock(&cacheLock);
+}
+
+/**
+ * \brief Barcode of the customer who referred a customer
+ *
+ * \return Referrer's barcode, or nil if nobody referred them
+ */
+-(NSString*)referrerOf: (NSString*)barcode on: (sqliteConnection*)connection {
+  return [self stringFrom: @"SELECT r.barcode FROM referrals f "
+                            "JOIN customers c ON c.customer_id = f.customer_id "
+                            "JOIN customers r ON r.customer_id = f.referrer "
+                            "WHERE c.barcode = ?"
+               args: [NSArray arrayWithObject: barcode] on: connection];
+}
+
+/**
+ * \brief Run a statement that returns no rows
+ *
+ * \param sql SQL with ? placeholders
+ * \param args Arguments for the placeholders
+ * \param connection Connection to run it on
+ * \return Whether it ran to completion
+ */
+-(BOOL)execute: (NSString*)sql 
+       args: (NSArray*)args 
+       on: (sqliteConnection*)connection {
+  if (!connection) return NO;
+  @synchronized(connection) {
+    sqlite3_stmt *stmt = [connection statement: sql];
+    if (!stmt || ![connection bindArguments: args toStatement: stmt]) 
+      return NO;
+    int result = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    if (result != SQLITE_DONE) {
+      NSLog(@"SQL error: %s in %@", sqlite3_errmsg(connection.db), sql);
+      return NO;
+    }
+    return YES;
+  }
+}
+
+/**
+ * \brief First column of the first row of a query, as an integer
+ *
+ * \return Value, or 0 if there are no rows
+ */
+-(int)intFrom: (NSString*)sql 
+      args: (NSArray*)args 
+      on: (sqliteConnection*)connection {
+  if (!connection) return 0;
+  @synchronized(connection) {
+    sqlite3_stmt *stmt = [connection statement: sql];
+    if (!stmt || ![connection bindArguments: args toStatement: stmt]) 
+      return 0;
+    int value = sqlite3_step(stmt) == SQLITE_ROW ? 
+      sqlite3_column_int(stmt, 0) : 0;
+    sqlite3_reset(stmt);
+    return value;
+  }
+}
+
+/**
+ * \brief First column of the first row of a query, as a string
+ *
+ * \return Value, or nil if there are no rows or it is NULL
+ */
+-(NSString*)stringFrom: (NSString*)sql 
+            args: (NSArray*)args 
+            on: (sqliteConnection*)connection {
+  if (!connection) return nil;
+  @synchronized(connection) {
+    sqlite3_stmt *stmt = [connection statement: sql];
+    if (!stmt || ![connection bindArguments: args toStatement: stmt]) 
+      return nil;
+    NSString *value = nil;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+      const char *text = (const char*)sqlite3_column_text(stmt, 0);
+      if (text) value = [NSString stringWithUTF8String: text];
+    }
+    sqlite3_reset(stmt);
+    return value;
+  }
+}
+
+/**
+ * \brief Run a block of statements as one transaction
+ *
+ * Holds the connection's lock throughout, so no other thread's statements
+ * land inside the transaction.  Rolled back if the block returns NO.
+ *
+ * \param connection Connection to run on
+ * \param block Statements to run
+ * \return What the block returned
+ */
+-(BOOL)inTransactionOn: (sqliteConnection*)connection 
+       do: (BOOL (^)(void))block {
+  if (!connection) return NO;
+  @synchronized(connection) {
+    if (![self execute: @"BEGIN" args: nil on: connection]) return NO;
+    BOOL ok = block();
+    [self execute: ok ? @"COMMIT" : @"ROLLBACK" args: nil on: connection];
+    return ok;
+  }
+}
+
+/**
+ * \brief Sections and rows of the customer editor, per customerProtocol
+ */
+-(NSArray*)buildDefinition {
+  NSDictionary *(^row)(NSString*, NSString*, NSString*, NSString*, BOOL) = 
+    ^(NSString *name, NSString *type, NSString *table, NSString *field, 
+      BOOL required) {
+      return [NSDictionary dictionaryWithObjectsAndKeys:
+        name, @"cellName", 
+        type, @"cellType", 
+        table, @"dbTable", 
+        field, @"dbField", 
+        [NSNumber numberWithBool: required], @"required", nil];
+    };
+  
+  return [NSArray arrayWithObjects:
+    @"Customer", [NSArray arrayWithObjects:
+      row(@"name", @"text", @"customers", @"name", YES),
+      row(@"barcode", @"text", @"customers", @"barcode", YES),
+      row(@"referrer", @"text", @"referrals", @"referrer", NO),
+      nil],
+    @"Rewards", [NSArray arrayWithObjects:
+      row(@"level", @"number", @"customer_reward_levels", @"level", NO),
+      row(@"credit", @"number", @"customer_reward_levels", @"credit", NO),
+      nil],
+    @"Contact", [NSArray arrayWithObjects:
+      row(@"phone", @"phone", @"customers", @"phone", NO),
+      row(@"birthday", @"date", @"customers", @"birthday", NO),
+      row(@"street", @"text", @"customers", @"street_1", NO),
+      row(@"street 2", @"text", @"customers", @"street_2", NO),
+      row(@"city", @"text", @"customers", @"city", NO),
+      row(@"state", @"text", @"customers", @"state", NO),
+      row(@"zipcode", @"number", @"customers", @"zipcode", NO),
+      nil],
+    @"Other", [NSArray arrayWithObjects:
+      row(@"heard from", @"text", @"customers", @"referral_site", NO),
+      row(@"notes", @"text", @"customers", @"notes", NO),
+      row(@"joined", @"date", @"customers", @"account_date", NO),
+      nil],
+    nil];
+}
+
+/**
+ * \brief Whether a table and field are listed in customerDefinition
+ */
+-(BOOL)isDefinedTable: (NSString*)table field: (NSString*)field {
+  for (id section in [self customerDefinition]) {
+    if (![section isKindOfClass: [NSArray class]]) continue;
+    for (NSDictionary *row in section) {
+      if ([[row objectForKey: @"dbTable"] isEqualToString: table] &&
+          [[row objectForKey: @"dbField"] isEqualToString: field])
+        return YES;
+    }
+  }
+  return NO;
+}
+
+@end
@@ -70,6 +70,11 @@
   return nil;
 }
 
+-(customerSnapshot*)snapshotFromDb: (NSString*)dbFile 
+                    withBarcode: (NSString*)barcode {
+  return nil;
+}
+
 -(NSString*)customerFromDb: (NSString*)dbFile withBarcode: (NSString*)barcode {
   return nil;
 }
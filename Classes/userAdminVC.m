@@ -480,6 +480,7 @@ NSInteger rowSort(id dict1, id dict2, void *context)
   mainAppDelegate *delegate = 
     (mainAppDelegate*)[[UIApplication sharedApplication] delegate];
 	[delegate.customer removeCustomerWithBarcode: barcode fromDb: self.dbFile];
+  [delegate.prefetch invalidate];
   
   // Reread database
   if (!self.searchResultsActive) {
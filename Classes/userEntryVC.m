@@ -148,6 +148,7 @@
            withName: name
            withBarcode: code
            withReferrer: referrer]) {
+    [delegate.prefetch invalidate];
   	self.barcode = [NSString stringWithString: code];
     return YES;         
 	}
@@ -183,6 +184,7 @@
            withField: [dict objectForKey: @"dbField"]];
     }  
   }
+  [delegate.prefetch invalidate];
   [self.navigationController popViewControllerAnimated: YES];
 } 
 
@@ -0,0 +1,340 @@
+//
+//  batchScan.c
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/*
+ * Re-scans archived card images on every CPU core
+ *
+ * Redemptions are audited by re-scanning stored frame dumps.  This spreads
+ * a list of images across a pool of worker threads, each with its own ZBar
+ * image scanner, since a ZBar scanner must never be shared between
+ * threads.
+ *
+ * Workers claim images in chunks of CHUNK from a shared atomic cursor, so
+ * a worker that finishes early simply takes the next chunk and none sits
+ * idle while another still has a backlog.  For a flat list of files this
+ * balances load the way work stealing would, without per-worker deques.
+ *
+ * Results are written strictly in input order, as soon as each one is
+ * ready: a result that finishes early waits in a reorder window of WINDOW
+ * slots until everything before it has been written.  A worker that gets
+ * WINDOW images ahead of the output waits before loading the next one, so
+ * memory stays bounded however long the list is.  Whichever worker
+ * completes the oldest outstanding image writes out the ready run, with
+ * the lock released, so the output file never stalls the other workers.
+ *
+ * Images are PGM or Y800 frame dumps (see tools/scanCorpus.h), given as a
+ * directory or as a file listing one path per line.  Results go to stdout,
+ * or -o, as CSV: index, file, symbology, data, one row per symbol and an
+ * empty row for an image with none.  With -s, the list is instead scanned
+ * with 1, 2, 4... up to -j threads and throughput for each is reported.
+ * Runs on Linux or macOS against the system libzbar:
+ *
+ *   cc -O2 -pthread -I tools -o batchScan \
+ *      tools/batchScan.c tools/scanCorpus.c -lzbar
+ *   ./batchScan [-j threads] [-c config;config] [-o results.csv] [-s] \
+ *      archive_dir_or_list
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <zbar.h>
+#include "scanCorpus.h"
+
+/* Images claimed from the shared cursor at a time */
+#define CHUNK 8
+/* Results that may be waiting for an earlier one to finish */
+#define WINDOW 1024
+
+typedef struct {
+  char *text;              /* CSV rows for the image, NULL until scanned */
+} batchResult;
+
+typedef struct {
+  char **paths;
+  size_t count;
+  const char *config;
+  FILE *out;               /* NULL discards results */
+
+  size_t cursor;           /* next unclaimed index, advanced atomically */
+  pthread_mutex_t lock;
+  pthread_cond_t moved;    /* written advanced */
+  size_t written;          /* results before this have been written */
+  int writing;             /* a worker is writing out a run */
+  batchResult window[WINDOW];
+  size_t unreadable;
+} batchRun;
+
+static double nowSec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Append to a growing string, returns the new string */
+static char *appendf(char *text, size_t *length, const char *fmt, ...) {
+  va_list ap;
+  int n;
+  va_start(ap, fmt);
+  n = vsnprintf(NULL, 0, fmt, ap);
+  va_end(ap);
+  text = realloc(text, *length + n + 1);
+  va_start(ap, fmt);
+  vsnprintf(text + *length, n + 1, fmt, ap);
+  va_end(ap);
+  *length += n;
+  return text;
+}
+
+/* CSV rows for one image, quotes in the data are doubled */
+static char *formatResult(size_t index, const char *path,
+                          const zbar_image_t *image) {
+  const char *file = strrchr(path, '/');
+  const zbar_symbol_t *sym = image ? zbar_image_first_symbol(image) : NULL;
+  char *text = NULL;
+  size_t length = 0;
+
+  file = file ? file + 1 : path;
+  if (!sym)
+    return appendf(text, &length, "%lu,\"%s\",,\n",
+                   (unsigned long)index, file);
+  for (; sym; sym = zbar_symbol_next(sym)) {
+    const char *data = zbar_symbol_get_data(sym);
+    text = appendf(text, &length, "%lu,\"%s\",%s,\"",
+                   (unsigned long)index, file,
+                   zbar_get_symbol_name(zbar_symbol_get_type(sym)));
+    for (const char *c = data; *c; c++)
+      text = appendf(text, &length, *c == '"' ? "\"\"" : "%c", *c);
+    text = appendf(text, &length, "\"\n");
+  }
+  return text;
+}
+
+/* Called with the lock held by the worker that finished the oldest result */
+static void writeReady(batchRun *run) {
+  run->writing = 1;
+  while (run->written < run->count &&
+         run->window[run->written % WINDOW].text) {
+    char *ready[WINDOW];
+    size_t first = run->written, n = 0;
+
+    while (first + n < run->count && n < WINDOW &&
+           run->window[(first + n) % WINDOW].text) {
+      ready[n] = run->window[(first + n) % WINDOW].text;
+      run->window[(first + n) % WINDOW].text = NULL;
+      n++;
+    }
+
+    pthread_mutex_unlock(&run->lock);
+    for (size_t i = 0; i < n; i++) {
+      if (run->out) fputs(ready[i], run->out);
+      free(ready[i]);
+    }
+    pthread_mutex_lock(&run->lock);
+
+    run->written += n;
+    pthread_cond_broadcast(&run->moved);
+  }
+  run->writing = 0;
+}
+
+static void *worker(void *arg) {
+  batchRun *run = arg;
+  zbar_image_scanner_t *scanner = zbar_image_scanner_create();
+  zbar_image_t *image = zbar_image_create();
+  char *copy = strdup(run->config), *save = NULL, *setting;
+
+  for (setting = strtok_r(copy, ";", &save); setting;
+       setting = strtok_r(NULL, ";", &save))
+    zbar_image_scanner_parse_config(scanner, setting);
+  free(copy);
+  zbar_image_set_format(image, zbar_fourcc('Y','8','0','0'));
+
+  for (;;) {
+    size_t first = __atomic_fetch_add(&run->cursor, CHUNK, __ATOMIC_RELAXED);
+    if (first >= run->count) break;
+    size_t last = first + CHUNK < run->count ? first + CHUNK : run->count;
+
+    for (size_t i = first; i < last; i++) {
+      scanCorpusFrame frame;
+      char *text;
+
+      /* Don't get more than WINDOW results ahead of the output */
+      pthread_mutex_lock(&run->lock);
+      while (i >= run->written + WINDOW)
+        pthread_cond_wait(&run->moved, &run->lock);
+      pthread_mutex_unlock(&run->lock);
+
+      if (scanCorpusLoadFile(run->paths[i], &frame) == 0) {
+        zbar_image_set_size(image, frame.width, frame.height);
+        zbar_image_set_data(image, frame.data,
+                            (unsigned long)frame.width * frame.height, NULL);
+        zbar_scan_image(scanner, image);
+        text = formatResult(i, run->paths[i], image);
+        zbar_image_set_data(image, NULL, 0, NULL);
+        free(frame.data);
+        free(frame.name);
+      }
+      else {
+        __atomic_fetch_add(&run->unreadable, 1, __ATOMIC_RELAXED);
+        text = formatResult(i, run->paths[i], NULL);
+      }
+
+      pthread_mutex_lock(&run->lock);
+      run->window[i % WINDOW].text = text;
+      if (i == run->written && !run->writing)
+        writeReady(run);
+      pthread_mutex_unlock(&run->lock);
+    }
+  }
+
+  zbar_image_destroy(image);
+  zbar_image_scanner_destroy(scanner);
+  return NULL;
+}
+
+/* Scan every image with the given number of threads, returns images/sec */
+static double scanAll(char **paths, size_t count, const char *config,
+                      FILE *out, int threads, size_t *unreadable) {
+  batchRun *run = calloc(1, sizeof(batchRun));
+  pthread_t *tids = malloc(threads * sizeof(pthread_t));
+  double start, elapsed;
+
+  run->paths = paths;
+  run->count = count;
+  run->config = config;
+  run->out = out;
+  pthread_mutex_init(&run->lock, NULL);
+  pthread_cond_init(&run->moved, NULL);
+
+  start = nowSec();
+  for (int t = 0; t < threads; t++)
+    pthread_create(&tids[t], NULL, worker, run);
+  for (int t = 0; t < threads; t++)
+    pthread_join(tids[t], NULL);
+  elapsed = nowSec() - start;
+
+  if (unreadable) *unreadable = run->unreadable;
+  pthread_cond_destroy(&run->moved);
+  pthread_mutex_destroy(&run->lock);
+  free(tids);
+  free(run);
+  return elapsed > 0 ? count / elapsed : 0.0;
+}
+
+/* One path per line, blank lines skipped */
+static int readList(const char *file, char ***paths, size_t *count) {
+  FILE *f = fopen(file, "r");
+  char line[4096];
+  size_t n = 0, capacity = 0;
+  char **list = NULL;
+
+  if (!f) return -1;
+  while (fgets(line, sizeof(line), f)) {
+    line[strcspn(line, "\r\n")] = '\0';
+    if (!line[0]) continue;
+    if (n == capacity) {
+      capacity = capacity ? capacity * 2 : 1024;
+      list = realloc(list, capacity * sizeof(*list));
+    }
+    list[n++] = strdup(line);
+  }
+  fclose(f);
+  *paths = list;
+  *count = n;
+  return 0;
+}
+
+static void usage(const char *argv0) {
+  fprintf(stderr, "usage: %s [-j threads] [-c config;config] "
+          "[-o results.csv] [-s] archive_dir_or_list\n", argv0);
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  const char *config = "", *output = NULL, *input = NULL;
+  int scaling = 0, opt;
+  char **paths;
+  size_t count, unreadable = 0;
+  struct stat st;
+
+  while ((opt = getopt(argc, argv, "j:c:o:s")) != -1) {
+    switch (opt) {
+      case 'j': threads = atoi(optarg); break;
+      case 'c': config = optarg; break;
+      case 'o': output = optarg; break;
+      case 's': scaling = 1; break;
+      default: usage(argv[0]);
+    }
+  }
+  if (optind != argc - 1 || threads < 1) usage(argv[0]);
+  input = argv[optind];
+
+  if (stat(input, &st) == 0 && S_ISDIR(st.st_mode) ?
+      scanCorpusList(input, &paths, &count) :
+      readList(input, &paths, &count)) {
+    fprintf(stderr, "can't read %s: %s\n", input, strerror(errno));
+    return 1;
+  }
+  if (!count) {
+    fprintf(stderr, "no images in %s\n", input);
+    return 1;
+  }
+
+  if (scaling) {
+    double base = 0.0;
+    printf("threads,images_per_sec,speedup\n");
+    for (int t = 1; ; t = t * 2 < threads ? t * 2 : threads) {
+      double rate = scanAll(paths, count, config, NULL, t, &unreadable);
+      if (t == 1) base = rate;
+      printf("%d,%.1f,%.2f\n", t, rate, base > 0 ? rate / base : 0.0);
+      fflush(stdout);
+      if (t == threads) break;
+    }
+  }
+  else {
+    FILE *out = output ? fopen(output, "w") : stdout;
+    double rate;
+    if (!out) {
+      fprintf(stderr, "can't write %s: %s\n", output, strerror(errno));
+      return 1;
+    }
+    fprintf(out, "index,file,type,data\n");
+    rate = scanAll(paths, count, config, out, threads, &unreadable);
+    if (out != stdout) fclose(out);
+    fprintf(stderr, "%lu images with %d threads, %.1f images/sec\n",
+            (unsigned long)count, threads, rate);
+  }
+
+  if (unreadable)
+    fprintf(stderr, "%lu images could not be read\n",
+            (unsigned long)unreadable);
+  scanCorpusFreeList(paths, count);
+  return 0;
+}
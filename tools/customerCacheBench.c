@@ -0,0 +1,165 @@
+//
+//  customerCacheBench.c
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/*
+ * Customer hot cache lookup latency with a million customers
+ *
+ * Drives Classes/customerCache.c, the cache sqliteCustomer keeps its
+ * customer snapshots in, with a synthetic night of scans: barcodes are
+ * drawn from a Zipf distribution over the customers, so a few regulars
+ * are scanned again and again among a long tail of one-off visits.
+ * Every miss is filled, as a snapshot read from the database would be,
+ * and every hit is checked against the barcode it was looked up with.
+ *
+ * Reports hit rate, memory and the latency of each lookup (hit or miss,
+ * not counting the fill) for a range of cache sizes, including the one
+ * the app uses.  Runs on Linux or macOS:
+ *
+ *   cc -O2 -I Classes -o customerCacheBench \
+ *      tools/customerCacheBench.c Classes/customerCache.c -lm
+ *   ./customerCacheBench [customers] [scans] [zipf exponent]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "customerCache.h"
+
+#define DEFAULT_CUSTOMERS 1000000
+#define DEFAULT_SCANS 4000000
+#define DEFAULT_EXPONENT 1.0
+/* Value bytes each snapshot is charged, about what sqliteCustomer charges */
+#define SNAPSHOT_BYTES 96
+/* Same as SQLITE_CUSTOMER_CACHE_CAPACITY */
+#define APP_CAPACITY 4096
+
+static const size_t capacities[] = { 1024, APP_CAPACITY, 16384, 65536 };
+
+static double nowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+  double x = *(const double*)a, y = *(const double*)b;
+  return x < y ? -1 : x > y;
+}
+
+static void releaseValue(void *value) {
+  free(value);
+}
+
+static int barcodeFor(unsigned customer, char *out) {
+  return sprintf(out, "%07u", 1000000 + customer);
+}
+
+int main(int argc, char **argv) {
+  unsigned customers = argc > 1 ? (unsigned)atoi(argv[1]) : DEFAULT_CUSTOMERS;
+  int scans = argc > 2 ? atoi(argv[2]) : DEFAULT_SCANS;
+  double exponent = argc > 3 ? atof(argv[3]) : DEFAULT_EXPONENT;
+  if (customers < 1 || scans < 1 || exponent <= 0.0) {
+    fprintf(stderr, "usage: %s [customers] [scans] [zipf exponent]\n", 
+            argv[0]);
+    return 1;
+  }
+  
+  // Zipf CDF over popularity ranks, and a shuffle from rank to customer
+  double *cdf = malloc(customers * sizeof(double));
+  unsigned *customerAtRank = malloc(customers * sizeof(unsigned));
+  double total = 0.0;
+  for (unsigned r = 0; r < customers; r++) {
+    total += 1.0 / pow(r + 1, exponent);
+    cdf[r] = total;
+    customerAtRank[r] = r;
+  }
+  srand48(1);
+  for (unsigned r = customers - 1; r > 0; r--) {
+    unsigned j = (unsigned)(drand48() * (r + 1));
+    unsigned t = customerAtRank[r];
+    customerAtRank[r] = customerAtRank[j];
+    customerAtRank[j] = t;
+  }
+  
+  unsigned *scanned = malloc(scans * sizeof(unsigned));
+  for (int s = 0; s < scans; s++) {
+    double u = drand48() * total;
+    unsigned lo = 0, hi = customers - 1;
+    while (lo < hi) {
+      unsigned mid = (lo + hi) / 2;
+      if (cdf[mid] < u) lo = mid + 1; else hi = mid;
+    }
+    scanned[s] = customerAtRank[lo];
+  }
+  free(cdf);
+  free(customerAtRank);
+  
+  printf("%u customers, %d scans, zipf exponent %.2f\n", 
+         customers, scans, exponent);
+  printf("%8s %8s %10s %10s %8s %8s %8s %8s\n", "capacity", "hit %", 
+         "table KB", "value KB", "p50 ns", "p99 ns", "p99.9 ns", "max ns");
+  
+  double *latency = malloc(scans * sizeof(double));
+  for (size_t c = 0; c < sizeof(capacities) / sizeof(capacities[0]); c++) {
+    customerCache *cache = customerCacheCreate(
+      capacities[c], capacities[c] * SNAPSHOT_BYTES, releaseValue);
+    if (!cache) {
+      fprintf(stderr, "out of memory\n");
+      return 1;
+    }
+    
+    for (int s = 0; s < scans; s++) {
+      char barcode[16];
+      int length = barcodeFor(scanned[s], barcode);
+      double start = nowNs();
+      unsigned *value = customerCacheGet(cache, barcode, length);
+      latency[s] = nowNs() - start;
+      
+      if (value && *value != scanned[s]) {
+        fprintf(stderr, "%s: cached customer %u\n", barcode, *value);
+        return 1;
+      }
+      if (!value) {
+        value = malloc(sizeof(unsigned));
+        *value = scanned[s];
+        customerCachePut(cache, barcode, length, value, SNAPSHOT_BYTES);
+      }
+    }
+    
+    customerCacheStats stats;
+    customerCacheGetStats(cache, &stats);
+    qsort(latency, scans, sizeof(double), compareDoubles);
+    printf("%8zu %8.1f %10.1f %10.1f %8.0f %8.0f %8.0f %8.0f%s\n", 
+           capacities[c], 100.0 * stats.hits / (stats.hits + stats.misses),
+           stats.tableBytes / 1024.0, stats.valueBytes / 1024.0,
+           latency[scans / 2], latency[(size_t)scans * 99 / 100], 
+           latency[(size_t)scans * 999 / 1000], latency[scans - 1],
+           capacities[c] == APP_CAPACITY ? "  (app)" : "");
+    customerCacheDestroy(cache);
+  }
+  
+  free(latency);
+  free(scanned);
+  return 0;
+}
@@ -0,0 +1,293 @@
+//
+//  customerLookupBench.c
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/*
+ * Customer lookup latency per scan: open-per-call, shared and snapshot
+ *
+ * Builds a customer database with the schema in "Database Schema.txt",
+ * then times what a scan reads (name, level, credit and referral count)
+ * three ways:
+ *
+ *   open-per-call  one query per value; opens the database, compiles the
+ *                  query with the barcode formatted into it, steps it and
+ *                  closes, for every value
+ *   shared         one query per value, each compiled once on a shared
+ *                  connection and re-bound for every scan, as
+ *                  sqliteConnection does
+ *   snapshot       one joined query for every value, compiled once, as
+ *                  sqliteCustomer's snapshotFromDb:withBarcode: does
+ *
+ * The queries are the ones sqliteCustomer runs, against the referrer index
+ * it adds; -n leaves the index out, as in databases from before it.  Runs
+ * on Linux or macOS:
+ *
+ *   cc -O2 -o customerLookupBench tools/customerLookupBench.c -lsqlite3
+ *   ./customerLookupBench [-n] [customers] [scans] [database path]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sqlite3.h>
+
+#define DEFAULT_CUSTOMERS 5000
+#define DEFAULT_SCANS 2000
+#define LOOKUPS_PER_SCAN 4
+
+static const char *schema =
+  "CREATE TABLE customers (customer_id INTEGER PRIMARY KEY ASC, "
+  "  name TEXT NOT NULL, barcode TEXT NOT NULL, birthday TEXT, phone TEXT, "
+  "  street_1 TEXT, street_2 TEXT, city TEXT, state TEXT, zipcode INTEGER, "
+  "  referral_site TEXT, notes TEXT, account_date TEXT);"
+  "CREATE UNIQUE INDEX customer_idx ON customers (barcode);"
+  "CREATE TABLE customer_reward_levels (customer_id INTEGER NOT NULL, "
+  "  level INTEGER NOT NULL, credit INTEGER NOT NULL);"
+  "CREATE UNIQUE INDEX reward_level_idx ON customer_reward_levels "
+  "  (customer_id);"
+  "CREATE TABLE referrals (referrer INTEGER NOT NULL, "
+  "  customer_id INTEGER NOT NULL);"
+  "CREATE UNIQUE INDEX referrals_idx ON referrals (customer_id);";
+
+/* Added by sqliteCustomer on first use; -n leaves it out */
+static const char *referrerIndex = 
+  "CREATE INDEX referrer_idx ON referrals (referrer);";
+
+/* The lookups a scan makes, with ? where the barcode goes */
+static const char *queries[LOOKUPS_PER_SCAN] = {
+  "SELECT name FROM customers WHERE barcode = ?",
+  "SELECT level FROM customer_reward_levels WHERE customer_id = "
+    "(SELECT customer_id FROM customers WHERE barcode = ?)",
+  "SELECT credit FROM customer_reward_levels WHERE customer_id = "
+    "(SELECT customer_id FROM customers WHERE barcode = ?)",
+  "SELECT COUNT(*) FROM referrals WHERE referrer = "
+    "(SELECT customer_id FROM customers WHERE barcode = ?)",
+};
+
+/* Every value a scan reads, in the same order, from one probe */
+static const char *snapshotQuery = 
+  "SELECT c.name, IFNULL(l.level, 0), IFNULL(l.credit, 0), "
+  "(SELECT COUNT(*) FROM referrals r WHERE r.referrer = c.customer_id) "
+  "FROM customers c "
+  "LEFT JOIN customer_reward_levels l ON l.customer_id = c.customer_id "
+  "WHERE c.barcode = ?";
+
+static double nowUs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void check(int result, sqlite3 *db, const char *what) {
+  if (result == SQLITE_OK || result == SQLITE_DONE || result == SQLITE_ROW)
+    return;
+  fprintf(stderr, "%s: %s\n", what, db ? sqlite3_errmsg(db) : "");
+  exit(1);
+}
+
+static void barcodeFor(int customer, char *out, size_t size) {
+  snprintf(out, size, "%07d", 1000000 + customer);
+}
+
+static void buildDatabase(const char *path, int customers, int indexed) {
+  sqlite3 *db;
+  unlink(path);
+  check(sqlite3_open(path, &db), db, "open");
+  check(sqlite3_exec(db, schema, NULL, NULL, NULL), db, "schema");
+  if (indexed)
+    check(sqlite3_exec(db, referrerIndex, NULL, NULL, NULL), db, "index");
+  check(sqlite3_exec(db, "BEGIN", NULL, NULL, NULL), db, "begin");
+  
+  sqlite3_stmt *customer, *level, *referral;
+  check(sqlite3_prepare_v2(db, "INSERT INTO customers "
+    "(customer_id, name, barcode, account_date) VALUES (?, ?, ?, '2011-08-11')",
+    -1, &customer, NULL), db, "prepare");
+  check(sqlite3_prepare_v2(db, "INSERT INTO customer_reward_levels "
+    "(customer_id, level, credit) VALUES (?, ?, ?)", -1, &level, NULL), 
+    db, "prepare");
+  check(sqlite3_prepare_v2(db, "INSERT INTO referrals (referrer, customer_id) "
+    "VALUES (?, ?)", -1, &referral, NULL), db, "prepare");
+  
+  for (int i = 1; i <= customers; i++) {
+    char name[32], barcode[16];
+    snprintf(name, sizeof(name), "Customer %d", i);
+    barcodeFor(i, barcode, sizeof(barcode));
+    sqlite3_bind_int(customer, 1, i);
+    sqlite3_bind_text(customer, 2, name, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(customer, 3, barcode, -1, SQLITE_TRANSIENT);
+    check(sqlite3_step(customer), db, "insert");
+    sqlite3_reset(customer);
+    
+    sqlite3_bind_int(level, 1, i);
+    sqlite3_bind_int(level, 2, i % 5);
+    sqlite3_bind_int(level, 3, i % 40);
+    check(sqlite3_step(level), db, "insert");
+    sqlite3_reset(level);
+    
+    if (i > 1 && i % 3) {
+      sqlite3_bind_int(referral, 1, 1 + (i * 7) % (i - 1));
+      sqlite3_bind_int(referral, 2, i);
+      check(sqlite3_step(referral), db, "insert");
+      sqlite3_reset(referral);
+    }
+  }
+  sqlite3_finalize(customer);
+  sqlite3_finalize(level);
+  sqlite3_finalize(referral);
+  check(sqlite3_exec(db, "COMMIT", NULL, NULL, NULL), db, "commit");
+  sqlite3_close(db);
+}
+
+/* Open, compile with the barcode formatted in, step, close */
+static long lookupOpenPerCall(const char *path, int query, 
+                              const char *barcode) {
+  char sql[512], quoted[32];
+  snprintf(quoted, sizeof(quoted), "'%s'", barcode);
+  const char *mark = strchr(queries[query], '?');
+  snprintf(sql, sizeof(sql), "%.*s%s%s", (int)(mark - queries[query]), 
+           queries[query], quoted, mark + 1);
+  
+  sqlite3 *db;
+  sqlite3_stmt *stmt;
+  check(sqlite3_open(path, &db), db, "open");
+  check(sqlite3_prepare_v2(db, sql, -1, &stmt, NULL), db, "prepare");
+  long value = 0;
+  if (sqlite3_step(stmt) == SQLITE_ROW) value = sqlite3_column_bytes(stmt, 0) + 
+    sqlite3_column_int(stmt, 0);
+  sqlite3_finalize(stmt);
+  sqlite3_close(db);
+  return value;
+}
+
+/* Reset and re-bind a statement compiled once */
+static long lookupShared(sqlite3_stmt *stmt, const char *barcode) {
+  sqlite3_reset(stmt);
+  sqlite3_bind_text(stmt, 1, barcode, -1, SQLITE_STATIC);
+  long value = 0;
+  if (sqlite3_step(stmt) == SQLITE_ROW) value = sqlite3_column_bytes(stmt, 0) +
+    sqlite3_column_int(stmt, 0);
+  sqlite3_reset(stmt);
+  return value;
+}
+
+/* Every value from the snapshot query, summed as the lookups are */
+static long lookupSnapshot(sqlite3_stmt *stmt, const char *barcode) {
+  sqlite3_reset(stmt);
+  sqlite3_bind_text(stmt, 1, barcode, -1, SQLITE_STATIC);
+  long value = 0;
+  if (sqlite3_step(stmt) == SQLITE_ROW) {
+    for (int c = 0; c < LOOKUPS_PER_SCAN; c++)
+      value += sqlite3_column_bytes(stmt, c) + sqlite3_column_int(stmt, c);
+  }
+  sqlite3_reset(stmt);
+  return value;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+  double x = *(const double*)a, y = *(const double*)b;
+  return x < y ? -1 : x > y;
+}
+
+static void report(const char *label, double *samples, int count) {
+  qsort(samples, count, sizeof(double), compareDoubles);
+  double total = 0.0;
+  for (int i = 0; i < count; i++) total += samples[i];
+  printf("%-14s %9.2f %9.2f %9.2f %9.2f\n", label, total / count,
+         samples[count / 2], samples[count * 99 / 100], samples[count - 1]);
+}
+
+int main(int argc, char **argv) {
+  int indexed = 1;
+  if (argc > 1 && !strcmp(argv[1], "-n")) {
+    indexed = 0;
+    argc--;
+    argv++;
+  }
+  int customers = argc > 1 ? atoi(argv[1]) : DEFAULT_CUSTOMERS;
+  int scans = argc > 2 ? atoi(argv[2]) : DEFAULT_SCANS;
+  const char *path = argc > 3 ? argv[3] : "customerLookupBench.sql";
+  if (customers < 2 || scans < 1) {
+    fprintf(stderr, "usage: %s [-n] [customers] [scans] [database path]\n", 
+            argv[0]);
+    return 1;
+  }
+  buildDatabase(path, customers, indexed);
+  
+  double *perCall = calloc(scans, sizeof(double));
+  double *shared = calloc(scans, sizeof(double));
+  double *snapshot = calloc(scans, sizeof(double));
+  long checksum[3] = { 0, 0, 0 };
+  srand(1);
+  
+  sqlite3 *db;
+  sqlite3_stmt *stmts[LOOKUPS_PER_SCAN], *snapshotStmt;
+  check(sqlite3_open(path, &db), db, "open");
+  for (int q = 0; q < LOOKUPS_PER_SCAN; q++)
+    check(sqlite3_prepare_v2(db, queries[q], -1, &stmts[q], NULL), 
+          db, "prepare");
+  check(sqlite3_prepare_v2(db, snapshotQuery, -1, &snapshotStmt, NULL), 
+        db, "prepare");
+  
+  // Alternate the ways scan by scan, so all see the same cache state
+  for (int s = 0; s < scans; s++) {
+    char barcode[16];
+    barcodeFor(1 + rand() % customers, barcode, sizeof(barcode));
+    double start = nowUs();
+    for (int q = 0; q < LOOKUPS_PER_SCAN; q++)
+      checksum[0] += lookupOpenPerCall(path, q, barcode);
+    perCall[s] = nowUs() - start;
+    
+    start = nowUs();
+    for (int q = 0; q < LOOKUPS_PER_SCAN; q++)
+      checksum[1] += lookupShared(stmts[q], barcode);
+    shared[s] = nowUs() - start;
+    
+    start = nowUs();
+    checksum[2] += lookupSnapshot(snapshotStmt, barcode);
+    snapshot[s] = nowUs() - start;
+  }
+  
+  for (int q = 0; q < LOOKUPS_PER_SCAN; q++) sqlite3_finalize(stmts[q]);
+  sqlite3_finalize(snapshotStmt);
+  sqlite3_close(db);
+  
+  printf("%d customers, %d scans, referrer %s, sqlite %s\n", 
+         customers, scans, indexed ? "indexed" : "not indexed", 
+         sqlite3_libversion());
+  printf("%-14s %9s %9s %9s %9s\n", "us per scan", "mean", "median", 
+         "p99", "max");
+  report("open-per-call", perCall, scans);
+  report("shared", shared, scans);
+  report("snapshot", snapshot, scans);
+  if (checksum[0] != checksum[1] || checksum[0] != checksum[2]) {
+    fprintf(stderr, "lookups disagree: %ld, %ld, %ld\n", 
+            checksum[0], checksum[1], checksum[2]);
+    return 1;
+  }
+  
+  free(perCall);
+  free(shared);
+  free(snapshot);
+  unlink(path);
+  return 0;
+}
@@ -0,0 +1,224 @@
+//
+//  logWriterBench.c
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/*
+ * Scan log throughput and caller latency, fsync per line vs group commit
+ *
+ * The old databaseManager logString: formatted a timestamp, wrote the line
+ * and fsync()ed it before returning, on the main thread, for every scan.
+ * The first run does the same.  The others drive Classes/logWriter.c, as
+ * the app now does: scans are appended and the caller returns, and every
+ * CREDIT_EVERY-th line is a redemption that waits in logWriterSync() until
+ * it's on disk.
+ *
+ * Reports lines per second and the latency each caller sees, separately
+ * for plain appends and for redemptions.  Point it at a directory on the
+ * disk being measured (tmpfs makes fsync() free).  Runs on Linux or macOS:
+ *
+ *   cc -O2 -pthread -I Classes -o logWriterBench \
+ *      tools/logWriterBench.c Classes/logWriter.c
+ *   ./logWriterBench [directory] [lines]
+ */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "logWriter.h"
+
+#define DEFAULT_LINES 200000
+/* fsync() per line is slow enough that fewer lines make the point */
+#define SYNC_LINES_DIVISOR 40
+/* One redemption for this many scans */
+#define CREDIT_EVERY 20
+#define MAX_PRODUCERS 4
+
+typedef struct {
+  logWriter *writer;
+  int lines;
+  int id;
+  double *appendNs;
+  int appends;
+  double *creditNs;
+  int credits;
+  long full;
+} producer;
+
+static double nowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+  double x = *(const double*)a, y = *(const double*)b;
+  return x < y ? -1 : x > y;
+}
+
+static int scanLine(char *out, int producerId, int i) {
+  return sprintf(out, "SCAN [Customer %d] [%07d] lvl=[%d] dsct=[%d] "
+                 "refs=[%d]", i, 1000000 + producerId * 100000 + i % 100000,
+                 i % 5, 5 * (i % 5), i % 13);
+}
+
+static int creditLine(char *out, int producerId, int i) {
+  return sprintf(out, "CREDIT [%07d] credit=[%d]", 
+                 1000000 + producerId * 100000 + i % 100000, i % 50);
+}
+
+static void report(const char *what, double *ns, int count) {
+  if (!count) return;
+  qsort(ns, count, sizeof(double), compareDoubles);
+  printf("  %-10s %8d calls  p50 %9.1f us  p99 %9.1f us  "
+         "p99.9 %9.1f us  max %9.1f us\n", what, count,
+         ns[count / 2] / 1e3, ns[(int)(count * 0.99)] / 1e3,
+         ns[(int)(count * 0.999)] / 1e3, ns[count - 1] / 1e3);
+}
+
+/* What logString: used to do */
+static void runSyncPerLine(const char *path, int lines) {
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+  if (fd < 0) {
+    perror(path);
+    exit(1);
+  }
+  double *ns = malloc(lines * sizeof(double));
+  char text[LOG_WRITER_RECORD_BYTES], line[LOG_WRITER_RECORD_BYTES + 64];
+  double start = nowNs();
+  for (int i = 0; i < lines; i++) {
+    if ((i + 1) % CREDIT_EVERY) scanLine(text, 0, i);
+    else creditLine(text, 0, i);
+    double t = nowNs();
+    time_t now = time(NULL);
+    struct tm tm;
+    gmtime_r(&now, &tm);
+    size_t length = strftime(line, sizeof(line), 
+                             "%Y-%m-%d %H:%M:%S +0000: ", &tm);
+    length += sprintf(line + length, "%s\n", text);
+    if (write(fd, line, length) < 0 || fsync(fd)) perror("write");
+    ns[i] = nowNs() - t;
+  }
+  double seconds = (nowNs() - start) / 1e9;
+  close(fd);
+  
+  printf("fsync per line, 1 thread: %.0f lines/s, %d fsyncs\n", 
+         lines / seconds, lines);
+  report("every line", ns, lines);
+  free(ns);
+}
+
+static void *produce(void *arg) {
+  producer *p = arg;
+  char text[LOG_WRITER_RECORD_BYTES];
+  for (int i = 0; i < p->lines; i++) {
+    int credit = (i + 1) % CREDIT_EVERY == 0;
+    int length = credit ? creditLine(text, p->id, i) : scanLine(text, p->id, i);
+    double t = nowNs();
+    uint64_t ticket;
+    // The app drops a line when the ring is full; count it and retry here
+    // so that every run writes the same lines
+    while (!(ticket = logWriterAppend(p->writer, text, length))) {
+      p->full++;
+      sched_yield();
+      t = nowNs();
+    }
+    if (credit) {
+      logWriterSync(p->writer, ticket);
+      p->creditNs[p->credits++] = nowNs() - t;
+    }
+    else {
+      p->appendNs[p->appends++] = nowNs() - t;
+    }
+  }
+  return NULL;
+}
+
+static void runGroupCommit(const char *path, int lines, int producers) {
+  unlink(path);
+  logWriter *writer = logWriterOpen(path, NULL, NULL);
+  if (!writer) {
+    perror(path);
+    exit(1);
+  }
+  producer p[MAX_PRODUCERS];
+  pthread_t threads[MAX_PRODUCERS];
+  double start = nowNs();
+  for (int i = 0; i < producers; i++) {
+    memset(&p[i], 0, sizeof(p[i]));
+    p[i].writer = writer;
+    p[i].lines = lines / producers;
+    p[i].id = i;
+    p[i].appendNs = malloc(p[i].lines * sizeof(double));
+    p[i].creditNs = malloc(p[i].lines * sizeof(double));
+    pthread_create(&threads[i], NULL, produce, &p[i]);
+  }
+  for (int i = 0; i < producers; i++) pthread_join(threads[i], NULL);
+  logWriterFlush(writer);
+  double seconds = (nowNs() - start) / 1e9;
+  logWriterStats stats;
+  logWriterGetStats(writer, &stats);
+  logWriterClose(writer);
+  
+  // Merge the producers' samples
+  double *appendNs = malloc(lines * sizeof(double));
+  double *creditNs = malloc(lines * sizeof(double));
+  int appends = 0, credits = 0;
+  long full = 0;
+  for (int i = 0; i < producers; i++) {
+    memcpy(appendNs + appends, p[i].appendNs, p[i].appends * sizeof(double));
+    memcpy(creditNs + credits, p[i].creditNs, p[i].credits * sizeof(double));
+    appends += p[i].appends;
+    credits += p[i].credits;
+    full += p[i].full;
+    free(p[i].appendNs);
+    free(p[i].creditNs);
+  }
+  printf("group commit, %d thread%s: %.0f lines/s, %llu fsyncs "
+         "(%llu for redemptions), %llu batches of up to %llu lines, "
+         "ring full %ld times\n", 
+         producers, producers > 1 ? "s" : "", appends / seconds + 
+         credits / seconds, (unsigned long long)stats.syncs, 
+         (unsigned long long)stats.barriers, 
+         (unsigned long long)stats.batches, 
+         (unsigned long long)stats.maxBatch, full);
+  report("scan", appendNs, appends);
+  report("redemption", creditNs, credits);
+  free(appendNs);
+  free(creditNs);
+}
+
+int main(int argc, char **argv) {
+  const char *directory = argc > 1 ? argv[1] : ".";
+  int lines = argc > 2 ? atoi(argv[2]) : DEFAULT_LINES;
+  char path[1024];
+  snprintf(path, sizeof(path), "%s/logWriterBench.log", directory);
+  
+  runSyncPerLine(path, lines / SYNC_LINES_DIVISOR);
+  runGroupCommit(path, lines, 1);
+  runGroupCommit(path, lines, MAX_PRODUCERS);
+  unlink(path);
+  return 0;
+}
@@ -0,0 +1,216 @@
+//
+//  scanBench.c
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/*
+ * Decode throughput of ZBar scanner configurations over a frame corpus
+ *
+ * The host counterpart of scanBenchmark, for comparing configurations
+ * before they are rolled out without installing a build on a device.
+ * Loads every frame in a corpus directory (see tools/scanCorpus.h), then
+ * scans each frame once per configuration with a fresh image scanner,
+ * timing only the zbar_scan_image() call.
+ *
+ * A configuration is a name and a list of ZBar config strings, as
+ * zbar_image_scanner_parse_config() takes them, e.g.
+ * -c 'code128-only=disable;code128.enable'.  Without -c the
+ * configurations in scanBenchmark's defaultConfigurations are compared.
+ *
+ * Prints one JSON object with, for each configuration, frames/sec, median
+ * and 99th percentile per-frame scan time, hit rate and how many symbols
+ * of each symbology were decoded, the same fields scanBenchmark writes to
+ * scan_benchmark.json.  Runs on Linux or macOS against the system libzbar:
+ *
+ *   cc -O2 -I tools -o scanBench \
+ *      tools/scanBench.c tools/scanCorpus.c -lzbar
+ *   ./scanBench [-c name=config;config]... corpus_dir
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <zbar.h>
+#include "scanCorpus.h"
+
+#define MAX_CONFIGS 32
+#define MAX_SYMBOLOGIES 32
+
+typedef struct {
+  const char *name;
+  const char *settings;    /* ';' separated ZBar config strings */
+} benchConfig;
+
+/* Same as scanBenchmark defaultConfigurations */
+static const benchConfig defaultConfigs[] = {
+  { "default", "" },
+  { "density-2", "x-density=2;y-density=2" },
+  { "code128-only", "disable;code128.enable" },
+};
+
+static double nowMs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+  double x = *(const double*)a, y = *(const double*)b;
+  return x < y ? -1 : x > y;
+}
+
+/* Apply each setting, returns nonzero if ZBar rejects one */
+static int configure(zbar_image_scanner_t *scanner, const char *settings) {
+  char *copy = strdup(settings), *save = NULL, *setting;
+  int err = 0;
+  for (setting = strtok_r(copy, ";", &save); setting && !err;
+       setting = strtok_r(NULL, ";", &save)) {
+    if ((err = zbar_image_scanner_parse_config(scanner, setting)))
+      fprintf(stderr, "bad config string '%s'\n", setting);
+  }
+  free(copy);
+  return err;
+}
+
+static void printSettings(const char *settings) {
+  char *copy = strdup(settings), *save = NULL, *setting;
+  int first = 1;
+  printf("[");
+  for (setting = strtok_r(copy, ";", &save); setting;
+       setting = strtok_r(NULL, ";", &save), first = 0)
+    printf("%s\"%s\"", first ? "" : ", ", setting);
+  printf("]");
+  free(copy);
+}
+
+static int runConfiguration(const scanCorpus *corpus,
+                            const benchConfig *config, int first) {
+  zbar_image_scanner_t *scanner = zbar_image_scanner_create();
+  zbar_image_t *image = zbar_image_create();
+  size_t count = corpus->count;
+  double *times = malloc(count * sizeof(double));
+  const char *names[MAX_SYMBOLOGIES];
+  int counts[MAX_SYMBOLOGIES];
+  int symbologies = 0, hits = 0;
+  double total = 0.0;
+
+  if (configure(scanner, config->settings)) {
+    zbar_image_destroy(image);
+    zbar_image_scanner_destroy(scanner);
+    free(times);
+    return -1;
+  }
+  zbar_image_set_format(image, zbar_fourcc('Y','8','0','0'));
+
+  for (size_t i = 0; i < count; i++) {
+    const scanCorpusFrame *frame = &corpus->frames[i];
+    const zbar_symbol_t *sym;
+    double start;
+    int result;
+
+    zbar_image_set_size(image, frame->width, frame->height);
+    zbar_image_set_data(image, frame->data,
+                        (unsigned long)frame->width * frame->height, NULL);
+    start = nowMs();
+    result = zbar_scan_image(scanner, image);
+    times[i] = nowMs() - start;
+    total += times[i];
+    if (result > 0) hits++;
+
+    for (sym = zbar_image_first_symbol(image); sym;
+         sym = zbar_symbol_next(sym)) {
+      const char *name = zbar_get_symbol_name(zbar_symbol_get_type(sym));
+      int s;
+      for (s = 0; s < symbologies && strcmp(names[s], name); s++);
+      if (s == symbologies) {
+        if (symbologies == MAX_SYMBOLOGIES) continue;
+        names[symbologies] = name;
+        counts[symbologies++] = 0;
+      }
+      counts[s]++;
+    }
+  }
+  zbar_image_set_data(image, NULL, 0, NULL);
+
+  qsort(times, count, sizeof(double), compareDoubles);
+  printf("%s  \"%s\": {\n    \"config\": ", first ? "" : ",\n",
+         config->name);
+  printSettings(config->settings);
+  printf(",\n    \"frames\": %lu,\n    \"hits\": %d,\n"
+         "    \"hit_rate\": %.4f,\n    \"frames_per_sec\": %.1f,\n"
+         "    \"p50_ms\": %.3f,\n    \"p99_ms\": %.3f,\n"
+         "    \"symbologies\": {",
+         (unsigned long)count, hits, (double)hits / count,
+         total > 0 ? count / (total / 1000.0) : 0.0,
+         times[count / 2], times[(count * 99) / 100]);
+  for (int s = 0; s < symbologies; s++)
+    printf("%s\"%s\": %d", s ? ", " : "", names[s], counts[s]);
+  printf("}\n  }");
+
+  free(times);
+  zbar_image_destroy(image);
+  zbar_image_scanner_destroy(scanner);
+  return 0;
+}
+
+static void usage(const char *argv0) {
+  fprintf(stderr, "usage: %s [-c name=config;config]... corpus_dir\n", argv0);
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  benchConfig configs[MAX_CONFIGS];
+  int nconfigs = 0, i, err = 0;
+  const char *dir = NULL;
+  scanCorpus corpus;
+
+  for (i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+      char *eq = strchr(argv[++i], '=');
+      if (!eq || nconfigs == MAX_CONFIGS) usage(argv[0]);
+      *eq = '\0';
+      configs[nconfigs].name = argv[i];
+      configs[nconfigs++].settings = eq + 1;
+    }
+    else if (argv[i][0] == '-' || dir)
+      usage(argv[0]);
+    else
+      dir = argv[i];
+  }
+  if (!dir) usage(argv[0]);
+  if (!nconfigs) {
+    nconfigs = sizeof(defaultConfigs) / sizeof(defaultConfigs[0]);
+    memcpy(configs, defaultConfigs, sizeof(defaultConfigs));
+  }
+
+  if (scanCorpusLoad(dir, &corpus) || !corpus.count) {
+    fprintf(stderr, "no frames in %s\n", dir);
+    return 1;
+  }
+
+  printf("{\n");
+  for (i = 0; i < nconfigs; i++)
+    err |= runConfiguration(&corpus, &configs[i], i == 0);
+  printf("\n}\n");
+
+  scanCorpusFree(&corpus);
+  return err ? 1 : 0;
+}
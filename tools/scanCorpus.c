@@ -0,0 +1,189 @@
+//
+//  scanCorpus.c
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/*
+ * Frame corpus loading shared by the scan host tools
+ *
+ * Mirrors scanBenchmark's frameFromPGM: and frameFromY800:named:, so a
+ * corpus gives the same frames on the host as it does on the device.
+ */
+
+#include <ctype.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "scanCorpus.h"
+
+static unsigned char *readFile(const char *path, size_t *length) {
+  FILE *f = fopen(path, "rb");
+  unsigned char *bytes = NULL;
+  long size;
+  if (!f) return NULL;
+  if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 &&
+      fseek(f, 0, SEEK_SET) == 0 && (bytes = malloc(size ? size : 1))) {
+    if (fread(bytes, 1, size, f) != (size_t)size) {
+      free(bytes);
+      bytes = NULL;
+    }
+    *length = size;
+  }
+  fclose(f);
+  return bytes;
+}
+
+static const char *extensionOf(const char *name) {
+  const char *dot = strrchr(name, '.');
+  return dot ? dot + 1 : "";
+}
+
+/* Header is width, height and maxval separated by whitespace and comments */
+static int parsePGM(const unsigned char *bytes, size_t len,
+                    scanCorpusFrame *frame, size_t *offset) {
+  size_t pos = 2;
+  int fields[3];
+  if (len < 2 || bytes[0] != 'P' || bytes[1] != '5') return -1;
+  for (int i = 0; i < 3; i++) {
+    while (pos < len && (isspace(bytes[pos]) || bytes[pos] == '#')) {
+      if (bytes[pos] == '#')
+        while (pos < len && bytes[pos] != '\n') pos++;
+      else
+        pos++;
+    }
+    if (pos >= len || !isdigit(bytes[pos])) return -1;
+    fields[i] = 0;
+    while (pos < len && isdigit(bytes[pos]) && fields[i] < 1000000)
+      fields[i] = fields[i] * 10 + (bytes[pos++] - '0');
+  }
+  pos++; /* single whitespace before pixel data */
+  frame->width = fields[0];
+  frame->height = fields[1];
+  *offset = pos;
+  return fields[2] > 255 || pos > len ? -1 : 0;
+}
+
+/* Size is WIDTHxHEIGHT after the last '-' of the name, before the extension */
+static int parseY800Name(const char *path, scanCorpusFrame *frame) {
+  const char *base = strrchr(path, '/');
+  const char *size;
+  base = base ? base + 1 : path;
+  size = strrchr(base, '-');
+  size = size ? size + 1 : base;
+  if (sscanf(size, "%d%*[xX]%d", &frame->width, &frame->height) != 2)
+    return -1;
+  return 0;
+}
+
+int scanCorpusLoadFile(const char *path, scanCorpusFrame *frame) {
+  const char *ext = extensionOf(path);
+  size_t length = 0, offset = 0;
+  unsigned char *bytes;
+  int err;
+
+  memset(frame, 0, sizeof(*frame));
+  if (strcasecmp(ext, "pgm") && strcasecmp(ext, "y800")) return -1;
+  if (!(bytes = readFile(path, &length))) return -1;
+
+  if (!strcasecmp(ext, "pgm"))
+    err = parsePGM(bytes, length, frame, &offset);
+  else
+    err = parseY800Name(path, frame);
+  if (err || frame->width <= 0 || frame->height <= 0 ||
+      length - offset < (size_t)frame->width * frame->height) {
+    free(bytes);
+    return -1;
+  }
+
+  /* Keep only the pixels, so frames can be handed to ZBar as they are */
+  if (offset)
+    memmove(bytes, bytes + offset, (size_t)frame->width * frame->height);
+  frame->data = bytes;
+  frame->name = strdup(path);
+  return 0;
+}
+
+static int compareNames(const void *a, const void *b) {
+  return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+int scanCorpusList(const char *dir, char ***paths, size_t *count) {
+  DIR *d = opendir(dir);
+  struct dirent *entry;
+  char **names = NULL;
+  size_t n = 0, capacity = 0;
+
+  *paths = NULL;
+  *count = 0;
+  if (!d) return -1;
+  while ((entry = readdir(d))) {
+    const char *ext = extensionOf(entry->d_name);
+    if (strcasecmp(ext, "pgm") && strcasecmp(ext, "y800")) continue;
+    if (n == capacity) {
+      capacity = capacity ? capacity * 2 : 64;
+      names = realloc(names, capacity * sizeof(*names));
+    }
+    names[n] = malloc(strlen(dir) + strlen(entry->d_name) + 2);
+    sprintf(names[n++], "%s/%s", dir, entry->d_name);
+  }
+  closedir(d);
+  if (n)
+    qsort(names, n, sizeof(*names), compareNames);
+  *paths = names;
+  *count = n;
+  return 0;
+}
+
+void scanCorpusFreeList(char **paths, size_t count) {
+  for (size_t i = 0; i < count; i++)
+    free(paths[i]);
+  free(paths);
+}
+
+int scanCorpusLoad(const char *dir, scanCorpus *corpus) {
+  char **names;
+  size_t count;
+
+  corpus->frames = NULL;
+  corpus->count = 0;
+  if (scanCorpusList(dir, &names, &count)) return -1;
+
+  corpus->frames = calloc(count ? count : 1, sizeof(scanCorpusFrame));
+  for (size_t i = 0; i < count; i++) {
+    if (scanCorpusLoadFile(names[i], &corpus->frames[corpus->count]) == 0)
+      corpus->count++;
+    else
+      fprintf(stderr, "skipping unreadable frame %s\n", names[i]);
+  }
+  scanCorpusFreeList(names, count);
+  return 0;
+}
+
+void scanCorpusFree(scanCorpus *corpus) {
+  for (size_t i = 0; i < corpus->count; i++) {
+    free(corpus->frames[i].name);
+    free(corpus->frames[i].data);
+  }
+  free(corpus->frames);
+  corpus->frames = NULL;
+  corpus->count = 0;
+}
@@ -0,0 +1,59 @@
+//
+//  scanCorpus.h
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+///\file
+
+/*
+ * Frame corpus loading shared by the scan host tools
+ *
+ * Reads the same corpus the app's scanBenchmark takes: binary 8-bit PGM
+ * (P5) files, or raw Y800 files named with their size, e.g.
+ * "frame0001-240x720.y800".  Frames are read whole into memory, in
+ * filename order, so file I/O stays out of anything timed afterwards.
+ */
+
+#ifndef SCAN_CORPUS_H
+#define SCAN_CORPUS_H
+
+#include <stddef.h>
+
+typedef struct {
+  char *name;
+  int width;
+  int height;
+  unsigned char *data;     /* width * height Y800 bytes */
+} scanCorpusFrame;
+
+typedef struct {
+  scanCorpusFrame *frames;
+  size_t count;
+} scanCorpus;
+
+/* Sorted full paths of the frames in a directory, returns 0 on success */
+int scanCorpusList(const char *dir, char ***paths, size_t *count);
+void scanCorpusFreeList(char **paths, size_t count);
+/* Load one PGM or Y800 file, returns 0 on success */
+int scanCorpusLoadFile(const char *path, scanCorpusFrame *frame);
+/* Load every readable frame in a directory, returns 0 on success */
+int scanCorpusLoad(const char *dir, scanCorpus *corpus);
+void scanCorpusFree(scanCorpus *corpus);
+
+#endif
@@ -0,0 +1,171 @@
+//
+//  scanFramePoolTest.c
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/*
+ * Checks that the scan frame pool allocates nothing in steady state
+ *
+ * Drives Classes/scanFrameSlots.c, the core of scanFramePool, the way the
+ * scan worker does: a frame is acquired, its luma data attached (straight
+ * from a plane, or through the slot's conversion buffer as BGRA frames
+ * are), scanned with zbar_scan_image(), its symbols recycled, and the
+ * frame released, with a second frame held as the mailbox would.
+ * After a warm-up, malloc, calloc and realloc are counted over the rest of
+ * the frames and any allocation is a failure, as is a frame the pool's
+ * return function never saw.  Exits nonzero on failure.
+ *
+ * Scans a synthetic frame, or a PGM/Y800 frame dump so ZBar's symbol
+ * recycling is exercised too.  Counting interposes glibc's allocator, so
+ * this runs on Linux:
+ *
+ *   cc -O2 -I Classes -I tools -o scanFramePoolTest \
+ *      tools/scanFramePoolTest.c Classes/scanFrameSlots.c \
+ *      tools/scanCorpus.c -lzbar
+ *   ./scanFramePoolTest [frames] [frame.pgm]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "scanFrameSlots.h"
+#include "scanCorpus.h"
+
+#define POOL_SIZE 4
+#define WARMUP_FRAMES 64
+#define DEFAULT_FRAMES 10000
+#define SYNTHETIC_WIDTH 640
+#define SYNTHETIC_HEIGHT 480
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static int counting;
+static unsigned long allocations;
+
+void *malloc(size_t size) {
+  if (counting) __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+  if (counting) __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  if (counting) __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+  return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+  __libc_free(ptr);
+}
+
+static unsigned long returned;
+
+static void countReturn(int slot, void *context) {
+  (void)slot;
+  (void)context;
+  returned++;
+}
+
+/* Scan one frame through a slot, as codeScanner's scan worker does */
+static int scanFrameIn(scanFrameSlots *slots, int slot,
+                       zbar_image_scanner_t *scanner,
+                       const scanCorpusFrame *frame, int convert) {
+  zbar_image_t *image = scanFrameSlotsImage(slots, slot);
+  size_t length = (size_t)frame->width * frame->height;
+  int found;
+
+  zbar_image_set_size(image, frame->width, frame->height);
+  if (convert) {
+    uint8_t *luma = scanFrameSlotsLuma(slots, slot, length);
+    if (!luma) return -1;
+    memcpy(luma, frame->data, length);
+    scanFrameSlotsAttach(slots, slot, luma, length);
+  }
+  else {
+    scanFrameSlotsAttach(slots, slot, frame->data, length);
+  }
+  found = zbar_scan_image(scanner, image);
+  zbar_image_scanner_recycle_image(scanner, image);
+  return found;
+}
+
+int main(int argc, char **argv) {
+  int frames = argc > 1 ? atoi(argv[1]) : DEFAULT_FRAMES;
+  scanFrameSlots *slots = scanFrameSlotsCreate(POOL_SIZE, countReturn, NULL);
+  zbar_image_scanner_t *scanner = zbar_image_scanner_create();
+  scanCorpusFrame frame;
+  unsigned long acquired = 0;
+  int held = -1, hits = 0;
+
+  if (argc > 2) {
+    if (scanCorpusLoadFile(argv[2], &frame)) {
+      fprintf(stderr, "can't read frame %s\n", argv[2]);
+      return 2;
+    }
+  }
+  else {
+    /* Vertical bars, so the scanner has edges to work on */
+    frame.name = NULL;
+    frame.width = SYNTHETIC_WIDTH;
+    frame.height = SYNTHETIC_HEIGHT;
+    frame.data = __libc_malloc(SYNTHETIC_WIDTH * SYNTHETIC_HEIGHT);
+    for (int i = 0; i < SYNTHETIC_WIDTH * SYNTHETIC_HEIGHT; i++)
+      frame.data[i] = (i % SYNTHETIC_WIDTH) / 3 % 2 ? 0x20 : 0xe0;
+  }
+
+  for (int i = 0; i < WARMUP_FRAMES + frames; i++) {
+    int slot;
+    if (i == WARMUP_FRAMES) counting = 1;
+
+    slot = scanFrameSlotsAcquire(slots);
+    if (slot < 0) {
+      fprintf(stderr, "pool ran dry at frame %d\n", i);
+      return 1;
+    }
+    acquired++;
+    if (scanFrameIn(slots, slot, scanner, &frame, i % 2) > 0 && counting)
+      hits++;
+
+    /* Keep one frame back, as a frame waiting in the mailbox would be */
+    scanFrameSlotsRelease(slots, held);
+    held = slot;
+  }
+  scanFrameSlotsRelease(slots, held);
+  counting = 0;
+
+  printf("%d frames after %d warm-up, %lu allocations, %d with symbols, "
+         "%d of %d frames free\n", frames, WARMUP_FRAMES, allocations, hits,
+         scanFrameSlotsAvailable(slots), POOL_SIZE);
+
+  zbar_image_scanner_destroy(scanner);
+  scanFrameSlotsDestroy(slots);
+  if (allocations || returned != acquired) {
+    fprintf(stderr, "FAIL: %lu allocations, %lu of %lu frames returned\n",
+            allocations, returned, acquired);
+    return 1;
+  }
+  return 0;
+}
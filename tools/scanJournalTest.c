@@ -0,0 +1,130 @@
+//
+//  scanJournalTest.c
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/*
+ * Checks that a redemption in the scan journal survives a crash
+ *
+ * A child process journals a few scans, a redemption and another scan,
+ * then exits without flushing or closing the journal, as the app would if
+ * it crashed.  Reopening the file must find the redemption and every scan
+ * before it.  Exits nonzero on failure.  Runs on Linux or macOS:
+ *
+ *   cc -O2 -pthread -I Classes -o scanJournalTest \
+ *      tools/scanJournalTest.c Classes/scanJournal.c
+ *   ./scanJournalTest [directory]
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "scanJournal.h"
+
+#define SCANS_BEFORE 3
+#define CREDIT_BARCODE "0012345"
+#define CREDIT_AMOUNT 40
+
+static void fill(scanJournalRecord *record, scanJournalEvent event, 
+                 const char *barcode) {
+  memset(record, 0, sizeof(*record));
+  record->event = event;
+  record->barcodeLength = strlen(barcode);
+  memcpy(record->barcode, barcode, record->barcodeLength);
+}
+
+/* Journal the events and exit as a crash would, without closing */
+static void journalAndCrash(const char *path) {
+  scanJournal *journal = scanJournalOpen(path);
+  if (!journal) _exit(2);
+  scanJournalRecord record;
+  for (int i = 0; i < SCANS_BEFORE; i++) {
+    char barcode[16];
+    sprintf(barcode, "%07d", 1000000 + i);
+    fill(&record, SCAN_JOURNAL_SCAN, barcode);
+    record.fields = SCAN_JOURNAL_LEVEL;
+    record.level = i;
+    if (scanJournalAppend(journal, &record)) _exit(2);
+  }
+  fill(&record, SCAN_JOURNAL_CREDIT, CREDIT_BARCODE);
+  record.fields = SCAN_JOURNAL_CREDIT_FIELD;
+  record.credit = CREDIT_AMOUNT;
+  if (scanJournalAppend(journal, &record)) _exit(2);
+  fill(&record, SCAN_JOURNAL_SCAN, "7654321");
+  scanJournalAppend(journal, &record);
+  _exit(0);
+}
+
+static int fail(const char *why) {
+  fprintf(stderr, "scanJournalTest: FAILED: %s\n", why);
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  char path[1024];
+  snprintf(path, sizeof(path), "%s/scanJournalTest.journal", 
+           argc > 1 ? argv[1] : "/tmp");
+  unlink(path);
+  
+  pid_t child = fork();
+  if (child < 0) return fail("fork");
+  if (!child) journalAndCrash(path);
+  int status;
+  waitpid(child, &status, 0);
+  if (!WIFEXITED(status) || WEXITSTATUS(status)) 
+    return fail("journaling failed");
+  
+  // Reopen what the crashed process left
+  int fd = open(path, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st)) return fail("journal missing");
+  char *data = malloc(st.st_size ? st.st_size : 1);
+  if (read(fd, data, st.st_size) != st.st_size) return fail("read");
+  close(fd);
+  unlink(path);
+  
+  scanJournalReader reader;
+  scanJournalRecord record;
+  if (scanJournalReaderInit(&reader, data, st.st_size)) 
+    return fail("bad header");
+  for (int i = 0; i < SCANS_BEFORE; i++) {
+    char barcode[16];
+    sprintf(barcode, "%07d", 1000000 + i);
+    if (!scanJournalNext(&reader, &record) || 
+        record.event != SCAN_JOURNAL_SCAN || strcmp(record.barcode, barcode) ||
+        record.level != (uint32_t)i)
+      return fail("scan before the redemption lost");
+  }
+  if (!scanJournalNext(&reader, &record) || 
+      record.event != SCAN_JOURNAL_CREDIT || 
+      strcmp(record.barcode, CREDIT_BARCODE) || 
+      !(record.fields & SCAN_JOURNAL_CREDIT_FIELD) || 
+      record.credit != CREDIT_AMOUNT)
+    return fail("redemption lost");
+  if (reader.badBlocks || reader.truncated) return fail("damaged block");
+  
+  free(data);
+  printf("scanJournalTest: ok\n");
+  return 0;
+}
@@ -0,0 +1,362 @@
+//
+//  scanJournalTool.c
+//  All-Seeing Eye
+//
+//  Created by Trevor Bentley on 10/17/26.
+//  Copyright 2026 Trevor Bentley. All rights reserved.
+//
+//  This file is part of All-Seeing Eye.
+// 
+//  All-Seeing Eye is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+// 
+//  All-Seeing Eye is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+// 
+//  You should have received a copy of the GNU General Public License
+//  along with All-Seeing Eye.  If not, see <http://www.gnu.org/licenses/>.
+
+/*
+ * Reads the binary scan journals (ase_log-*.journal) the app uploads
+ *
+ *   scanJournalTool csv FILE      one CSV row per record
+ *   scanJournalTool counts FILE   totals, scans per hour, top customers
+ *   scanJournalTool bench [N]     write a journal of N synthetic records
+ *                                 and its text log, compare their sizes
+ *                                 and time reading the journal back
+ *
+ * The journal is mapped and decoded in place by Classes/scanJournal.c,
+ * so reading costs little more than the CRC of each block.  Runs on
+ * Linux or macOS:
+ *
+ *   cc -O2 -pthread -I Classes -o scanJournalTool \
+ *      tools/scanJournalTool.c Classes/scanJournal.c
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "scanJournal.h"
+
+#define DEFAULT_BENCH_RECORDS 2000000
+#define BENCH_CUSTOMERS 20000
+/* One redemption for this many scans, as in the app's logs */
+#define CREDIT_EVERY 20
+#define TOP_CUSTOMERS 10
+
+typedef struct {
+  char barcode[SCAN_JOURNAL_MAX_BARCODE + 1];
+  uint64_t scans;
+  uint64_t credits;
+} customerCount;
+
+typedef struct {
+  customerCount *slots;
+  size_t mask;
+  size_t used;
+} customerTable;
+
+static double nowSeconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static const void *mapFile(const char *path, size_t *length) {
+  int fd = open(path, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st)) {
+    perror(path);
+    exit(1);
+  }
+  *length = (size_t)st.st_size;
+  void *data = mmap(NULL, *length ? *length : 1, PROT_READ, MAP_PRIVATE, 
+                    fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    perror(path);
+    exit(1);
+  }
+  madvise(data, *length, MADV_SEQUENTIAL);
+  return data;
+}
+
+static void openReader(scanJournalReader *reader, const char *path) {
+  size_t length;
+  const void *data = mapFile(path, &length);
+  if (scanJournalReaderInit(reader, data, length)) {
+    fprintf(stderr, "%s: not a version %d scan journal\n", path, 
+            SCAN_JOURNAL_VERSION);
+    exit(1);
+  }
+}
+
+static void reportDamage(const scanJournalReader *reader) {
+  if (reader->badBlocks) 
+    fprintf(stderr, "%llu of %llu blocks failed their CRC and were skipped\n",
+            (unsigned long long)reader->badBlocks, 
+            (unsigned long long)reader->blocks);
+  if (reader->truncated) 
+    fprintf(stderr, "file ends partway through a block\n");
+}
+
+static const char *eventName(scanJournalEvent event) {
+  switch (event) {
+    case SCAN_JOURNAL_SCAN: return "SCAN";
+    case SCAN_JOURNAL_CREDIT: return "CREDIT";
+  }
+  return "UNKNOWN";
+}
+
+static void printField(FILE *out, unsigned fields, unsigned field, 
+                       uint32_t value) {
+  if (fields & field) fprintf(out, ",%u", value);
+  else fputs(",", out);
+}
+
+static void exportCsv(const char *path, FILE *out) {
+  scanJournalReader reader;
+  scanJournalRecord record;
+  openReader(&reader, path);
+  
+  // Rows come many to a second; format each second once
+  char stamp[32];
+  int64_t stampSecond = -1;
+  fputs("time,event,barcode,level,discount,referrals,credit\n", out);
+  while (scanJournalNext(&reader, &record)) {
+    uint64_t us = reader.startUs + record.timeUs;
+    if ((int64_t)(us / 1000000) != stampSecond) {
+      stampSecond = (int64_t)(us / 1000000);
+      time_t t = (time_t)stampSecond;
+      struct tm tm;
+      gmtime_r(&t, &tm);
+      strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+    }
+    fprintf(out, "%s.%06u,%s,%s", stamp, (unsigned)(us % 1000000), 
+            eventName(record.event), record.barcode);
+    printField(out, record.fields, SCAN_JOURNAL_LEVEL, record.level);
+    printField(out, record.fields, SCAN_JOURNAL_DISCOUNT, record.discount);
+    printField(out, record.fields, SCAN_JOURNAL_REFERRALS, record.referrals);
+    printField(out, record.fields, SCAN_JOURNAL_CREDIT_FIELD, record.credit);
+    fputc('\n', out);
+  }
+  reportDamage(&reader);
+}
+
+/* FNV-1a */
+static uint32_t hashBarcode(const char *barcode, size_t length) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (uint8_t)barcode[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static customerCount *findCustomer(customerTable *table, 
+                                   const scanJournalRecord *record) {
+  if (2 * (table->used + 1) > table->mask + 1) {
+    // Grow to keep the table at most half full
+    customerTable bigger = { 
+      calloc(2 * (table->mask + 1), sizeof(customerCount)), 
+      2 * table->mask + 1, table->used };
+    for (size_t i = 0; i <= table->mask; i++) {
+      customerCount *old = &table->slots[i];
+      if (!old->barcode[0]) continue;
+      size_t slot = hashBarcode(old->barcode, strlen(old->barcode)) & 
+        bigger.mask;
+      while (bigger.slots[slot].barcode[0]) slot = (slot + 1) & bigger.mask;
+      bigger.slots[slot] = *old;
+    }
+    free(table->slots);
+    *table = bigger;
+  }
+  size_t slot = hashBarcode(record->barcode, record->barcodeLength) & 
+    table->mask;
+  for (;;) {
+    customerCount *count = &table->slots[slot];
+    if (!count->barcode[0]) {
+      memcpy(count->barcode, record->barcode, record->barcodeLength + 1);
+      table->used++;
+      return count;
+    }
+    if (!strcmp(count->barcode, record->barcode)) return count;
+    slot = (slot + 1) & table->mask;
+  }
+}
+
+static int compareScans(const void *a, const void *b) {
+  uint64_t x = ((const customerCount*)a)->scans;
+  uint64_t y = ((const customerCount*)b)->scans;
+  return x > y ? -1 : x < y;
+}
+
+static void printCounts(const char *path) {
+  scanJournalReader reader;
+  scanJournalRecord record;
+  openReader(&reader, path);
+  
+  uint64_t records = 0, scans = 0, credits = 0, creditTotal = 0;
+  uint64_t byHour[24] = { 0 };
+  customerTable table = { calloc(1024, sizeof(customerCount)), 1023, 0 };
+  double start = nowSeconds();
+  while (scanJournalNext(&reader, &record)) {
+    records++;
+    // Blank barcodes (a scan that didn't decode) aren't customers
+    customerCount *customer = record.barcodeLength ? 
+      findCustomer(&table, &record) : NULL;
+    if (record.event == SCAN_JOURNAL_SCAN) {
+      scans++;
+      if (customer) customer->scans++;
+      uint64_t second = (reader.startUs + record.timeUs) / 1000000;
+      byHour[second / 3600 % 24]++;
+    }
+    else if (record.event == SCAN_JOURNAL_CREDIT) {
+      credits++;
+      creditTotal += record.credit;
+      if (customer) customer->credits++;
+    }
+  }
+  double seconds = nowSeconds() - start;
+  
+  printf("%llu records: %llu scans, %llu redemptions (%llu credit), "
+         "%zu customers\n", (unsigned long long)records, 
+         (unsigned long long)scans, (unsigned long long)credits, 
+         (unsigned long long)creditTotal, table.used);
+  printf("scans per hour (UTC):\n");
+  for (int hour = 0; hour < 24; hour++)
+    if (byHour[hour]) 
+      printf("  %02d:00  %llu\n", hour, (unsigned long long)byHour[hour]);
+  
+  customerCount *customers = malloc((table.used + 1) * sizeof(customerCount));
+  size_t n = 0;
+  for (size_t i = 0; i <= table.mask; i++)
+    if (table.slots[i].barcode[0]) customers[n++] = table.slots[i];
+  qsort(customers, n, sizeof(customerCount), compareScans);
+  printf("top customers:\n");
+  for (size_t i = 0; i < n && i < TOP_CUSTOMERS; i++)
+    printf("  %-20s %llu scans, %llu redemptions\n", customers[i].barcode, 
+           (unsigned long long)customers[i].scans, 
+           (unsigned long long)customers[i].credits);
+  fprintf(stderr, "read in %.3f s, %.1fM records/s\n", seconds, 
+          records / seconds / 1e6);
+  reportDamage(&reader);
+  free(customers);
+  free(table.slots);
+}
+
+static void bench(int records) {
+  const char *journalPath = "/tmp/scanJournalBench.journal";
+  const char *logPath = "/tmp/scanJournalBench.log";
+  scanJournal *journal = scanJournalOpen(journalPath);
+  FILE *log = fopen(logPath, "w");
+  if (!journal || !log) {
+    perror("/tmp");
+    exit(1);
+  }
+  
+  // The same events both ways, the text as logString: writes it
+  scanJournalRecord record;
+  memset(&record, 0, sizeof(record));
+  srand(1);
+  time_t now = time(NULL);
+  struct tm tm;
+  gmtime_r(&now, &tm);
+  char stamp[32];
+  strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S +0000", &tm);
+  double start = nowSeconds();
+  for (int i = 0; i < records; i++) {
+    int customer = rand() % BENCH_CUSTOMERS;
+    record.barcodeLength = (size_t)sprintf(record.barcode, "%07d", 
+                                           1000000 + customer);
+    if ((i + 1) % CREDIT_EVERY) {
+      record.event = SCAN_JOURNAL_SCAN;
+      record.fields = SCAN_JOURNAL_LEVEL | SCAN_JOURNAL_DISCOUNT | 
+        SCAN_JOURNAL_REFERRALS;
+      record.level = customer % 5;
+      record.discount = 5 * record.level;
+      record.referrals = customer % 13;
+      fprintf(log, "%s: SCAN [Customer %d] [%s] lvl=[%u] dsct=[%u] "
+              "refs=[%u]\n", stamp, customer, record.barcode, record.level, 
+              record.discount, record.referrals);
+    }
+    else {
+      record.event = SCAN_JOURNAL_CREDIT;
+      record.fields = SCAN_JOURNAL_CREDIT_FIELD;
+      record.credit = customer % 50;
+      fprintf(log, "%s: CREDIT [%s] credit=[%u]\n", stamp, record.barcode, 
+              record.credit);
+    }
+    scanJournalAppend(journal, &record);
+  }
+  double writeSeconds = nowSeconds() - start;
+  scanJournalClose(journal);
+  fclose(log);
+  
+  struct stat journalStat, logStat;
+  stat(journalPath, &journalStat);
+  stat(logPath, &logStat);
+  printf("%d records: journal %.1f MB (%.1f bytes each), text log %.1f MB "
+         "(%.1f bytes each)\n", records, journalStat.st_size / 1e6, 
+         (double)journalStat.st_size / records, logStat.st_size / 1e6, 
+         (double)logStat.st_size / records);
+  printf("journal written at %.1fM records/s, with the text log alongside\n", 
+         records / writeSeconds / 1e6);
+  
+  // Decode only, then the two commands
+  scanJournalReader reader;
+  openReader(&reader, journalPath);
+  uint64_t read = 0, check = 0;
+  start = nowSeconds();
+  while (scanJournalNext(&reader, &record)) {
+    read++;
+    check += record.level + record.credit;
+  }
+  double readSeconds = nowSeconds() - start;
+  printf("journal read at %.1fM records/s (%llu records, check %llu)\n", 
+         read / readSeconds / 1e6, (unsigned long long)read, 
+         (unsigned long long)check);
+  
+  FILE *devNull = fopen("/dev/null", "w");
+  start = nowSeconds();
+  exportCsv(journalPath, devNull);
+  printf("csv exported at %.1fM records/s\n", 
+         read / (nowSeconds() - start) / 1e6);
+  fclose(devNull);
+  
+  unlink(journalPath);
+  unlink(logPath);
+}
+
+static void usage(void) {
+  fprintf(stderr, "usage: scanJournalTool csv FILE\n"
+                  "       scanJournalTool counts FILE\n"
+                  "       scanJournalTool bench [records]\n");
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) usage();
+  if (!strcmp(argv[1], "csv") && argc == 3) {
+    exportCsv(argv[2], stdout);
+  }
+  else if (!strcmp(argv[1], "counts") && argc == 3) {
+    printCounts(argv[2]);
+  }
+  else if (!strcmp(argv[1], "bench")) {
+    bench(argc > 2 ? atoi(argv[2]) : DEFAULT_BENCH_RECORDS);
+  }
+  else {
+    usage();
+  }
+  return 0;
+}